@@ -0,0 +1,120 @@
+# Ядро движка: мир, объекты, физика, скрипты и менеджеры ресурсов.
+# Не содержит виджетов и не линкуется с OpenGL: вызовы OpenGL в общих
+# исходниках собираются только с NEED_OPENGL из FuryRender.pri.
+
+QT += concurrent
+
+CONFIG += c++17
+
+INCLUDEPATH += \
+    $$PWD/src \
+    $$PWD/includes \
+    $$PWD/libs/python/include
+
+
+# Выкрутасы из-за одинаковых названий библиотеки в debug и release
+CONFIG(debug, debug|release) {
+    LIBS        += \
+        -L$$PWD/libs/reactphysics3d/debug \
+}else {
+    LIBS        += \
+        -L$$PWD/libs/reactphysics3d/release \
+}
+
+
+LIBS        += \
+    -L$$PWD/libs \
+    -L$$PWD/libs/assimp \
+    -L$$PWD/libs/boost \
+    -L$$PWD/libs/python \
+    -L$$PWD/libs/python/libs \
+    -lassimp \
+    -lreactphysics3d
+
+
+SOURCES += \
+    $$PWD/src/Camera.cpp \
+    $$PWD/src/CarObject.cpp \
+    $$PWD/src/FuryLearningScript.cpp \
+    $$PWD/src/FuryModelCache.cpp \
+    $$PWD/src/FuryObjectsFactory.cpp \
+    $$PWD/src/FuryPhongMaterial.cpp \
+    $$PWD/src/FuryTextureCache.cpp \
+    $$PWD/src/DefaultObjects/FuryBoxObject.cpp \
+    $$PWD/src/Learning/FuryAsyncLearner.cpp \
+    $$PWD/src/Learning/FuryPolicyNetwork.cpp \
+    $$PWD/src/Learning/FuryReplayBuffer.cpp \
+    $$PWD/src/Managers/FuryScriptManager.cpp \
+    $$PWD/src/Managers/FuryShaderManager.cpp \
+    $$PWD/src/Managers/FuryWorldManager.cpp \
+    $$PWD/src/PythonAPI/CarObject_Python.cpp \
+    $$PWD/src/PythonAPI/FuryBuffer_Python.cpp \
+    $$PWD/src/PythonAPI/FuryEnvironment_Python.cpp \
+    $$PWD/src/PythonAPI/FuryLearning_Python.cpp \
+    $$PWD/src/PythonAPI/FuryObject_Python.cpp \
+    $$PWD/src/PythonAPI/GLM_Python.cpp \
+    $$PWD/src/Physics/FuryEventListener.cpp \
+    $$PWD/src/Logger/FuryException.cpp \
+    $$PWD/src/Logger/FuryLogger.cpp \
+    $$PWD/src/FuryMaterial.cpp \
+    $$PWD/src/Managers/FuryMaterialManager.cpp \
+    $$PWD/src/FuryMesh.cpp \
+    $$PWD/src/FuryModel.cpp \
+    $$PWD/src/Managers/FuryModelManager.cpp \
+    $$PWD/src/FuryObject.cpp \
+    $$PWD/src/FuryPbrMaterial.cpp \
+    $$PWD/src/FuryFrustum.cpp \
+    $$PWD/src/FuryRenderList.cpp \
+    $$PWD/src/Physics/FuryRaySensor.cpp \
+    $$PWD/src/Physics/FuryVehicleSystem.cpp \
+    $$PWD/src/DefaultObjects/FurySphereObject.cpp \
+    $$PWD/src/FuryTexture.cpp \
+    $$PWD/src/Managers/FuryTextureManager.cpp \
+    $$PWD/src/FuryWorld.cpp \
+    $$PWD/src/Simulation/FuryEpisodeRecord.cpp \
+    $$PWD/src/Simulation/FurySimulation.cpp \
+    $$PWD/src/Simulation/FurySimulationThread.cpp \
+    $$PWD/src/Simulation/FuryVectorEnvironment.cpp \
+    $$PWD/src/Simulation/FuryWorldSnapshot.cpp
+
+HEADERS += \
+    $$PWD/src/Camera.h \
+    $$PWD/src/CarObject.h \
+    $$PWD/src/FuryLearningScript.h \
+    $$PWD/src/FuryModelCache.h \
+    $$PWD/src/FuryObjectsFactory.h \
+    $$PWD/src/FuryPhongMaterial.h \
+    $$PWD/src/FuryTextureCache.h \
+    $$PWD/src/DefaultObjects/FuryBoxObject.h \
+    $$PWD/src/Learning/FuryAsyncLearner.h \
+    $$PWD/src/Learning/FuryPolicyNetwork.h \
+    $$PWD/src/Learning/FuryReplayBuffer.h \
+    $$PWD/src/Managers/FuryScriptManager.h \
+    $$PWD/src/Managers/FuryShaderManager.h \
+    $$PWD/src/Managers/FuryWorldManager.h \
+    $$PWD/src/Physics/FuryEventListener.h \
+    $$PWD/src/PythonAPI/FuryBuffer_Python.h \
+    $$PWD/src/PythonAPI/FuryGilRelease_Python.h \
+    $$PWD/src/Logger/FuryException.h \
+    $$PWD/src/Logger/FuryLogger.h \
+    $$PWD/src/FuryMaterial.h \
+    $$PWD/src/Managers/FuryMaterialManager.h \
+    $$PWD/src/FuryMesh.h \
+    $$PWD/src/FuryModel.h \
+    $$PWD/src/Managers/FuryModelManager.h \
+    $$PWD/src/FuryObject.h \
+    $$PWD/src/FuryPbrMaterial.h \
+    $$PWD/src/FuryFrustum.h \
+    $$PWD/src/FuryRenderList.h \
+    $$PWD/src/Physics/FuryRaySensor.h \
+    $$PWD/src/Physics/FuryVehicleSystem.h \
+    $$PWD/src/DefaultObjects/FurySphereObject.h \
+    $$PWD/src/FuryTexture.h \
+    $$PWD/src/Managers/FuryTextureManager.h \
+    $$PWD/src/FuryWorld.h \
+    $$PWD/src/Simulation/FuryEpisodeRecord.h \
+    $$PWD/src/Simulation/FurySimulation.h \
+    $$PWD/src/Simulation/FurySimulationThread.h \
+    $$PWD/src/Simulation/FuryTripleBuffer.h \
+    $$PWD/src/Simulation/FuryVectorEnvironment.h \
+    $$PWD/src/Simulation/FuryWorldSnapshot.h
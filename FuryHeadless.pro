@@ -0,0 +1,23 @@
+TARGET = FuryHeadless
+TEMPLATE = app
+VERSION = 0.0.1
+
+# Только симуляция: без виджетов и без OpenGL (FuryRender.pri не подключается).
+# QtGui нужен лишь для QQuaternion / QVector3D.
+QT += core gui
+QT -= widgets
+
+CONFIG += c++17 console
+
+DESTDIR = bin
+OBJECTS_DIR = build/headless
+MOC_DIR = build/headless
+UI_DIR = build/headless
+RCC_DIR = build/headless
+
+
+include(FuryCore.pri)
+
+
+SOURCES += \
+    src/mainHeadless.cpp
@@ -0,0 +1,18 @@
+# Отрисовка OpenGL: шейдеры, карты теней и вызовы OpenGL в общих исходниках ядра.
+# Подключается после FuryCore.pri только в сборке с окном.
+
+DEFINES += NEED_OPENGL=1
+
+LIBS        += \
+    -L$$PWD/libs/glew \
+    -lglew32 \
+    -lOpenGL32
+
+
+SOURCES += \
+    $$PWD/src/FuryShadowCascades.cpp \
+    $$PWD/src/Shader.cpp
+
+HEADERS += \
+    $$PWD/src/FuryShadowCascades.h \
+    $$PWD/src/Shader.h
@@ -0,0 +1,68 @@
+# Асинхронное обучение. Выполняется в отдельном потоке C++ (FuryAsyncLearner):
+# симуляция сама выбирает действия нативной сетью и складывает переходы
+# в очередь, а этот цикл забирает их, обучает сеть и публикует веса.
+import os
+import numpy as np
+import tensorflow as tf
+
+from scripts.discrete_deepq import DiscreteDeepQ
+from scripts.model import MLP
+
+
+MODEL_SAVE_DIR = 'saved-model'
+# Период сохранения модели в шагах обучения
+SAVE_PERIOD = 10000
+# Ожидание переходов, если их ещё мало для мини-пакета (мс)
+WAIT_TIMEOUT = 100
+
+
+def run(learner):
+    observation_size = learner.observationSize()
+    num_actions = learner.actionCount()
+
+    tf.reset_default_graph()
+    session = tf.Session()
+
+    # Описание нейросети
+    brain = MLP([observation_size,], [40, 30, num_actions],
+                [tf.nn.leaky_relu, tf.nn.leaky_relu, tf.identity])
+
+    # Оптимизатор. RMSProp рекомендуется
+    optimizer = tf.train.RMSPropOptimizer(learning_rate=0.01, decay=1)
+
+    # Контроллер обучения с подкреплением. Действия выбирает актор в C++,
+    # здесь только буфер воспроизведения и шаги обучения
+    controller = DiscreteDeepQ((observation_size,), num_actions, brain, optimizer, session,
+                               discount_rate=0.95, exploration_period=0, max_experience=100000,
+                               store_every_nth=1, train_every_nth=1, minibatch_size=32)
+
+    if os.path.exists(MODEL_SAVE_DIR):
+        print('restoring model...')
+        controller.restore(MODEL_SAVE_DIR)
+        print('done')
+
+    learner.setExplorationProbability(controller.random_action_probability)
+    learner.publishPolicy(brain.export_bytes(session))
+
+    train_steps = 0
+
+    while not learner.stopRequested():
+        added = learner.drain(controller.experience)
+        controller.number_of_times_store_called += added
+
+        if len(controller.experience) < controller.minibatch_size:
+            learner.waitForTransitions(WAIT_TIMEOUT)
+            continue
+
+        with tf.device("/cpu:0"):
+            controller.training_step()
+        train_steps += 1
+
+        if train_steps % learner.publishPeriod() == 0:
+            learner.publishPolicy(brain.export_bytes(session))
+
+        if train_steps % SAVE_PERIOD == 0:
+            controller.save(MODEL_SAVE_DIR)
+
+    controller.save(MODEL_SAVE_DIR)
+    print('Model saved. Train steps:', train_steps, 'Dropped transitions:', learner.droppedCount())
@@ -5,7 +5,7 @@ import os
 import pickle
 import time
 
-from collections import deque
+from FuryLearning import ReplayBuffer
 
 class DiscreteDeepQ(object):
     def __init__(self, observation_shape,
@@ -21,6 +21,9 @@ class DiscreteDeepQ(object):
                        discount_rate=0.95,
                        max_experience=30000,
                        target_network_update_rate=0.01,
+                       prioritized_replay=False,
+                       priority_alpha=0.6,
+                       priority_beta=0.4,
                        summary_writer=None):
         """Initialized the Deepq object.
 
@@ -75,6 +78,15 @@ class DiscreteDeepQ(object):
             alpha, target network T, and network N. Every
             time N gets updated we execute:
                 T = (1-alpha)*T + alpha*N
+        prioritized_replay: bool
+            sample minibatches proportionally to the
+            TD error instead of uniformly
+        priority_alpha: float (0 to 1)
+            how much prioritization is used
+            (0 - uniform sampling)
+        priority_beta: float (0 to 1)
+            importance sampling correction for
+            prioritized replay (1 - full correction)
         summary_writer: tf.train.SummaryWriter
             writer to log metrics
         """
@@ -95,10 +107,18 @@ class DiscreteDeepQ(object):
         self.max_experience            = max_experience
         self.target_network_update_rate = \
                 tf.constant(target_network_update_rate)
+        self.prioritized_replay        = prioritized_replay
+        self.priority_beta             = priority_beta
 
         # deepq state
         self.actions_executed_so_far = 0
-        self.experience = deque()
+        # ring buffer in C++: observations in one float block,
+        # minibatches are sampled into preallocated arrays
+        self.experience = ReplayBuffer(max_experience,
+                                       int(np.prod(observation_shape)),
+                                       minibatch_size,
+                                       num_actions,
+                                       priority_alpha if prioritized_replay else 0.0)
 
         self.iteration = 0
         self.summary_writer = summary_writer
@@ -149,8 +169,9 @@ class DiscreteDeepQ(object):
             # FOR PREDICTION ERROR
             self.action_mask                = tf.placeholder(tf.float32, (None, self.num_actions), name="action_mask")
             self.masked_action_scores       = tf.reduce_sum(self.action_scores * self.action_mask, reduction_indices=[1,])
-            temp_diff                       = self.masked_action_scores - self.future_rewards
-            self.prediction_error           = tf.reduce_mean(tf.square(temp_diff))
+            self.importance_weights         = tf.placeholder_with_default(tf.ones_like(self.rewards), (None,), name="importance_weights")
+            self.temp_diff                  = self.masked_action_scores - self.future_rewards
+            self.prediction_error           = tf.reduce_mean(self.importance_weights * tf.square(self.temp_diff))
             gradients                       = self.optimizer.compute_gradients(self.prediction_error)
             for i, (grad, var) in enumerate(gradients):
                 if grad is not None:
@@ -206,11 +227,18 @@ class DiscreteDeepQ(object):
         If newstate is None, the state/action pair is assumed to be terminal
         """
         if self.number_of_times_store_called % self.store_every_nth == 0:
-            self.experience.append((observation, action, reward, newobservation))
-            if len(self.experience) > self.max_experience:
-                self.experience.popleft()
+            self.experience.add(observation, action, reward, newobservation)
         self.number_of_times_store_called += 1
 
+    def store_batch(self, observations, actions, rewards, newobservations, dones):
+        """Store a batch of experience, e.g. one step of a vector
+        environment. For finished episodes (dones[i]) newobservations[i]
+        is ignored. Every transition is stored, store_every_nth
+        is not applied.
+        """
+        self.experience.addBatch(observations, actions, rewards, newobservations, dones)
+        self.number_of_times_store_called += len(actions)
+
     def training_step(self):
         """Pick a self.minibatch_size exeperiences from reply buffer
         and backpropage the value function.
@@ -219,46 +247,38 @@ class DiscreteDeepQ(object):
             if len(self.experience) <  self.minibatch_size:
                 return
 
-            # sample experience.
-            samples   = random.sample(range(len(self.experience)), self.minibatch_size)
-            # samples = range(len(self.experience) - self.minibatch_size, len(self.experience))
-            samples   = [self.experience[i] for i in samples]
-
-            # bach states
-            states         = np.empty(self.observation_batch_shape(len(samples)))
-            newstates      = np.empty(self.observation_batch_shape(len(samples)))
-            action_mask    = np.zeros((len(samples), self.num_actions))
-
-            newstates_mask = np.empty((len(samples),))
-            rewards        = np.empty((len(samples),))
-
-            for i, (state, action, reward, newstate) in enumerate(samples):
-                states[i] = state
-                action_mask[i] = 0
-                action_mask[i][action] = 1
-                rewards[i] = reward
-                if newstate is not None:
-                    newstates[i] = newstate
-                    newstates_mask[i] = 1
-                else:
-                    newstates[i] = 0
-                    newstates_mask[i] = 0
+            # sample experience straight into the buffer's minibatch arrays.
+            if self.prioritized_replay:
+                batch = self.experience.samplePrioritized(self.priority_beta)
+            else:
+                batch = self.experience.sample()
 
+            states, action_mask, rewards, newstates, newstates_mask, _, weights = \
+                    [np.asarray(x) for x in batch]
 
             calculate_summaries = self.iteration % 100 == 0 and \
                     self.summary_writer is not None
 
-            cost, _, summary_str = self.s.run([
-                self.prediction_error,
-                self.train_op,
-                self.summarize if calculate_summaries else self.no_op1,
-            ], {
+            feed = {
                 self.observation:            states,
                 self.next_observation:       newstates,
                 self.next_observation_mask:  newstates_mask,
                 self.action_mask:            action_mask,
                 self.rewards:                rewards,
-            })
+            }
+
+            if self.prioritized_replay:
+                feed[self.importance_weights] = weights
+
+            cost, _, summary_str, temp_diff = self.s.run([
+                self.prediction_error,
+                self.train_op,
+                self.summarize if calculate_summaries else self.no_op1,
+                self.temp_diff if self.prioritized_replay else self.no_op1,
+            ], feed)
+
+            if self.prioritized_replay:
+                self.experience.updatePriorities(np.abs(temp_diff).astype(np.float32))
 
             self.s.run(self.target_network_update)
 
@@ -272,6 +292,8 @@ class DiscreteDeepQ(object):
     def save(self, save_dir, debug=False):
         STATE_FILE      = os.path.join(save_dir, 'deepq_state')
         MODEL_FILE      = os.path.join(save_dir, 'model')
+        EXPERIENCE_FILE = os.path.join(save_dir, 'experience')
+        POLICY_FILE     = os.path.join(save_dir, 'policy.bin')
 
         # deepq state
         state = {
@@ -289,21 +311,30 @@ class DiscreteDeepQ(object):
         self.saver.save(self.s, MODEL_FILE)
         with open(STATE_FILE, "wb") as f:
             pickle.dump(state, f)
+        self.experience.save(EXPERIENCE_FILE)
+        # weights for the native policy evaluator, runs without Python
+        if hasattr(self.q_network, 'export'):
+            self.q_network.export(self.s, POLICY_FILE)
 
         print('done in {} s'.format(time.time() - saving_started))
         print(list(map(lambda x: self.s.run(x), self.q_network.variables())))
         print()
         print()
-        print(self.s.run(self.action_scores, {self.observation: self.experience[-1][0][np.newaxis,:]}))
+        if self.experience.size() > 0:
+            last_observation = np.asarray(self.experience.observation(self.experience.latestIndex()))
+            print(self.s.run(self.action_scores, {self.observation: last_observation[np.newaxis,:]}))
 
     def restore(self, save_dir, debug=False):
         # deepq state
         STATE_FILE      = os.path.join(save_dir, 'deepq_state')
         MODEL_FILE      = os.path.join(save_dir, 'model')
+        EXPERIENCE_FILE = os.path.join(save_dir, 'experience')
 
         with open(STATE_FILE, "rb") as f:
             state = pickle.load(f)
         self.saver.restore(self.s, MODEL_FILE)
+        if os.path.exists(EXPERIENCE_FILE):
+            self.experience.restore(EXPERIENCE_FILE)
 
         self.actions_executed_so_far      = state['actions_executed_so_far']
         self.iteration                    = state['iteration']
@@ -1,7 +1,31 @@
 import math
+import struct
+import numpy as np
 import tensorflow as tf
 
 
+# policy.bin format, read by FuryPolicyNetwork (C++):
+#   'FPOL', version, layer count,
+#   per layer: input size, output size, activation, alpha,
+#              W (input x output, row-major), b (output)
+# everything little-endian int32 / float32
+POLICY_FILE_MAGIC   = 0x4C4F5046
+POLICY_FILE_VERSION = 1
+ACTIVATION_IDENTITY   = 0
+ACTIVATION_LEAKY_RELU = 1
+
+
+def activation_code(nonlinearity):
+    """Maps a TF nonlinearity to (activation, alpha) of FuryPolicyNetwork"""
+    if nonlinearity is tf.identity:
+        return ACTIVATION_IDENTITY, 0.0
+    if nonlinearity is tf.nn.leaky_relu:
+        return ACTIVATION_LEAKY_RELU, 0.2
+    if nonlinearity is tf.nn.relu:
+        return ACTIVATION_LEAKY_RELU, 0.0
+    raise ValueError("Nonlinearity %s can not be exported" % (nonlinearity,))
+
+
 def base_name(var):
     """Extracts value passed to name= when creating a variable"""
     return var.name.split('/')[-1].split(':')[0]
@@ -82,6 +106,28 @@ class MLP(object):
                 hidden = nonlinearity(layer(hidden))
             return hidden
 
+    def export_bytes(self, session):
+        """Weights in the format of the native policy evaluator"""
+        layers = [self.input_layer] + self.layers
+        nonlinearities = [self.input_nonlinearity] + self.layer_nonlinearities
+
+        chunks = [struct.pack('<IIi', POLICY_FILE_MAGIC, POLICY_FILE_VERSION, len(layers))]
+        for layer, nonlinearity in zip(layers, nonlinearities):
+            # several inputs of a layer are one concatenated input
+            W = np.concatenate(session.run(layer.Ws), axis=0).astype('<f4')
+            b = session.run(layer.b).astype('<f4')
+            activation, alpha = activation_code(nonlinearity)
+            chunks.append(struct.pack('<iiif', W.shape[0], W.shape[1], activation, alpha))
+            chunks.append(W.tobytes())
+            chunks.append(b.tobytes())
+        return b''.join(chunks)
+
+    def export(self, session, path):
+        """Writes weights to path for the native policy evaluator
+        (saved-model/policy.bin)"""
+        with open(path, "wb") as f:
+            f.write(self.export_bytes(session))
+
     def variables(self):
         res = self.input_layer.variables()
         for layer in self.layers:
@@ -51,13 +51,18 @@ class Behaviour(FuryBehaviour):
         self.last_action = 0
         # Последнее наблюдаемое состояние среды
         self.last_observation = None
+        
+        # Буферы машины без копирования: память принадлежит C++
+        self.observation = np.asarray(self.object.observationBuffer())
+        self.action = np.asarray(self.object.actionBuffer())
     
     def update(self):
         # print('update', self.object.worldPosition())
         if self.isFirst:
-            action = self.predict(self.object.getObservation())
+            self.object.updateObservation()
+            action = self.predict(self.observation)
             self.object.getReward()
-            self.object.setBotAction(action)
+            self.setAction(action)
             self.isFirst = False
             return
         
@@ -99,16 +104,23 @@ class Behaviour(FuryBehaviour):
         else:
             self.score += carReward
             # int action = m_learnScript->learn(observation, carReward, false);
-            action = self.learnFunc(self.object.getObservation(), carReward)
-            self.object.setBotAction(action);
+            self.object.updateObservation()
+            action = self.learnFunc(self.observation, carReward)
+            self.setAction(action)
     
     def stop(self):
         # self.current_controller.save(self.MODEL_SAVE_DIR)
         print('Model saved')
     
+    # Передача действия машине через буфер действия
+    def setAction(self, _action):
+        self.action[0] = _action
+        self.object.applyAction()
+    
     # Основная функция для обучения. Предсказывает действие и обучает
     def learnFunc(self, _observation, _reward):
         if _observation is not None:
+            # Копия: буфер наблюдения перезаписывается на следующем шаге
             _observation = np.array(_observation)
 
         if self.last_observation is not None:
@@ -130,6 +142,7 @@ class Behaviour(FuryBehaviour):
 
     # Предсказать действие без обучения
     def predict(self, _observation):
+        # Копия: буфер наблюдения перезаписывается на следующем шаге
         _observation = np.array(_observation)
         
         self.last_observation = _observation
@@ -0,0 +1,83 @@
+# Обучение на векторной среде. Запуск:
+#   FuryHeadless --envs 8 --env-script scripts.vector_train
+# Цикл шагов ведёт скрипт: один вызов env.step(actions) на шаг всех миров.
+import os
+import numpy as np
+import tensorflow as tf
+
+from scripts.discrete_deepq import DiscreteDeepQ
+from scripts.model import MLP
+
+
+MODEL_SAVE_DIR = 'saved-model'
+# Количество тиков физики на одно решение
+TICKS_PER_STEP = 1
+# Количество шагов обучения (0 - бесконечно)
+MAX_STEPS = 0
+
+
+def run(env):
+    env_count = env.envCount()
+    observation_size = env.observationSize()
+    num_actions = 9
+
+    env.setTicksPerStep(TICKS_PER_STEP)
+
+    tf.reset_default_graph()
+    session = tf.InteractiveSession()
+
+    # Описание нейросети
+    brain = MLP([observation_size,], [40, 30, num_actions],
+                [tf.nn.leaky_relu, tf.nn.leaky_relu, tf.identity])
+
+    # Оптимизатор. RMSProp рекомендуется
+    optimizer = tf.train.RMSPropOptimizer(learning_rate=0.01, decay=1)
+
+    # Контроллер обучения с подкреплением
+    controller = DiscreteDeepQ((observation_size,), num_actions, brain, optimizer, session,
+                               discount_rate=0.95, exploration_period=0, max_experience=100000,
+                               store_every_nth=1, train_every_nth=1, minibatch_size=32)
+
+    if os.path.exists(MODEL_SAVE_DIR):
+        print('restoring model...')
+        controller.restore(MODEL_SAVE_DIR)
+        print('done')
+
+    # Представления буферов C++ без копирования
+    observations = np.asarray(env.reset())
+    actions = np.asarray(env.actions())
+
+    scores = np.zeros(env_count)
+    game_counter = 0
+    step = 0
+
+    while MAX_STEPS == 0 or step < MAX_STEPS:
+        last_observations = np.array(observations)
+
+        for i in range(env_count):
+            actions[i] = controller.action(last_observations[i])
+
+        # Действия уже лежат в буфере среды
+        _, rewards, dones = env.step()
+        rewards = np.asarray(rewards)
+        dones = np.asarray(dones)
+
+        # Весь шаг уходит в буфер C++ одним вызовом. Для закончившегося
+        # эпизода в наблюдениях уже начало нового, буфер его не берёт
+        controller.store_batch(last_observations, actions, rewards, observations, dones)
+
+        for i in range(env_count):
+            if dones[i]:
+                print("Game:", game_counter, "Score:", scores[i] + rewards[i])
+                scores[i] = 0
+                game_counter += 1
+            else:
+                scores[i] += rewards[i]
+
+        with tf.device("/cpu:0"):
+            controller.training_step()
+
+        step += 1
+
+    controller.save(MODEL_SAVE_DIR)
+    print('Model saved')
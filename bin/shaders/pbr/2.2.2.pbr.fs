@@ -3,7 +3,7 @@ out vec4 FragColor;
 in vec2 TexCoords;
 in vec3 WorldPos;
 in vec3 Normal;
-in vec4 FragPosLightSpace;
+in float ViewDepth;
 
 
 // material parameters
@@ -33,8 +33,11 @@ uniform samplerCube irradianceMap;
 uniform samplerCube prefilterMap;
 uniform sampler2D brdfLUT;
 
-// Shadow Map
-uniform sampler2D shadowMap;
+// Cascaded Shadow Maps
+uniform sampler2D shadowMaps[4];
+uniform mat4 lightSpaceMatrices[4];
+uniform float cascadeFar[4];
+uniform int cascadeCount;
 uniform int shadowMapEnabled;
 
 // lights
@@ -139,12 +142,54 @@ vec3 fresnelSchlickRoughness(float cosTheta, vec3 F0, float roughness)
     return F0 + (max(vec3(1.0 - roughness), F0) - F0) * pow(clamp(1.0 - cosTheta, 0.0, 1.0), 5.0);
 }   
 // ----------------------------------------------------------------------------
-float ShadowCalculation(vec4 fragPosLightSpace)
+//! Массив сэмплеров в GLSL 330 индексируется только константой, поэтому
+//! каскад выбирается ветвлением. textureLod - ветвление неоднородно по пикселям
+float sampleShadowMap(int cascade, vec2 coords)
+{
+    if (cascade == 0)
+        return textureLod(shadowMaps[0], coords, 0.0).r;
+    if (cascade == 1)
+        return textureLod(shadowMaps[1], coords, 0.0).r;
+    if (cascade == 2)
+        return textureLod(shadowMaps[2], coords, 0.0).r;
+    return textureLod(shadowMaps[3], coords, 0.0).r;
+}
+
+vec2 shadowMapSize(int cascade)
+{
+    if (cascade == 0)
+        return vec2(textureSize(shadowMaps[0], 0));
+    if (cascade == 1)
+        return vec2(textureSize(shadowMaps[1], 0));
+    if (cascade == 2)
+        return vec2(textureSize(shadowMaps[2], 0));
+    return vec2(textureSize(shadowMaps[3], 0));
+}
+// ----------------------------------------------------------------------------
+float ShadowCalculation()
 {
 	if (shadowMapEnabled == 0)
 	{
 		return 0;
 	}
+
+    // Каскад - первый, чья дальняя граница дальше фрагмента
+    int cascade = -1;
+    for (int i = 0; i < 4; ++i)
+    {
+        if (i < cascadeCount && ViewDepth <= cascadeFar[i])
+        {
+            cascade = i;
+            break;
+        }
+    }
+
+    if (cascade < 0)
+    {
+        return 0.0;
+    }
+
+    vec4 fragPosLightSpace = lightSpaceMatrices[cascade] * vec4(WorldPos, 1.0);
 	
     // perform perspective divide
     vec3 projCoords = fragPosLightSpace.xyz / fragPosLightSpace.w;
@@ -152,26 +197,26 @@ float ShadowCalculation(vec4 fragPosLightSpace)
     // transform to [0,1] range
     projCoords = projCoords * 0.5 + 0.5;
     
-    // get closest depth value from light's perspective (using [0,1] range fragPosLight as coords)
-    float closestDepth = texture(shadowMap, projCoords.xy).r;
-    
     // get depth of current fragment from light's perspective
     float currentDepth = projCoords.z;
     // check whether current frag pos is in shadow
 
+    vec2 mapSize = shadowMapSize(cascade);
     vec3 lightDir = normalize(-dirLight.direction);
     vec3 normal = getNormalFromMap();
     float bias = max(0.001 * (1.0 - dot(normal, lightDir)), 0.005) * 0.4;
+    // Смещение подобрано для карты 4096, у грубых каскадов тексель крупнее
+    bias *= 4096.0 / mapSize.x;
     // float shadow = currentDepth - bias > closestDepth  ? 1.0 : 0.0;
     
     // PCF
     float shadow = 0.0;
-    vec2 texelSize = 1.0 / textureSize(shadowMap, 0);
+    vec2 texelSize = 1.0 / mapSize;
     for(int x = -1; x <= 1; ++x)
     {
         for(int y = -1; y <= 1; ++y)
         {
-            float pcfDepth = texture(shadowMap, projCoords.xy + vec2(x, y) * texelSize).r;
+            float pcfDepth = sampleShadowMap(cascade, projCoords.xy + vec2(x, y) * texelSize);
             shadow += currentDepth - bias > pcfDepth  ? 1.0 : 0.0;
         }
     }
@@ -262,7 +307,7 @@ void main()
 
     vec3 ambient = (kD * diffuse + specular) * ao;
     
-    float shadow = ShadowCalculation(FragPosLightSpace);
+    float shadow = ShadowCalculation();
     shadow *= 0.75;
     vec4 color = vec4(ambient + Lo, getAlbedo(TexCoords).a);
     color.rgb = color.rgb * (1.0 - shadow);
@@ -6,7 +6,7 @@ layout (location = 2) in vec2 aTexCoords;
 out vec2 TexCoords;
 out vec3 WorldPos;
 out vec3 Normal;
-out vec4 FragPosLightSpace;
+out float ViewDepth;
 
 uniform mat4 projection;
 uniform mat4 view;
@@ -14,14 +14,13 @@ uniform mat4 model;
 uniform mat3 normalMatrix;
 
 uniform vec2 textureScales;
-uniform mat4 lightSpaceMatrix;
 
 void main()
 {
     TexCoords = aTexCoords * textureScales;
     WorldPos = vec3(model * vec4(aPos, 1.0));
     Normal = normalMatrix * aNormal;
-    FragPosLightSpace = lightSpaceMatrix * vec4(WorldPos, 1.0);
+    ViewDepth = -(view * vec4(WorldPos, 1.0)).z;
 
     gl_Position =  projection * view * vec4(WorldPos, 1.0);
 }
\ No newline at end of file
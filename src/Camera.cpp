@@ -1,7 +1,6 @@
 #include "Camera.h"
 
 #include "FuryObject.h"
-#include "Managers/FuryModelManager.h"
 
 
 Camera::Camera(glm::vec3 _position, glm::vec3 _up, GLfloat _yaw, GLfloat _pitch) :
@@ -32,38 +31,6 @@ const glm::mat4 &Camera::getPerspectiveMatrix(int _width, int _height,
     return m_perspectiveMatrix;
 }
 
-bool Camera::sphereInFrustum(FuryObject *_object)
-{
-    glm::vec4 planes[6];
-    glm::mat4 m = glm::transpose(m_perspectiveMatrix * m_viewMatrix);
-    planes[0] = m[3] + m[0];
-    planes[1] = m[3] - m[0];
-    planes[2] = m[3] + m[1];
-    planes[3] = m[3] - m[1];
-    planes[4] = m[3] + m[2];
-    planes[5] = m[3] - m[2];
-
-    FuryModelManager* modelManager = FuryModelManager::instance();
-
-    const glm::vec3& minp = _object->worldPosition();
-    const glm::vec3& scales = _object->scales();
-    float maxScale = std::max(std::max(scales.x, scales.y), scales.z);
-    float radius = modelManager->modelByName(_object->modelName()).modelRadius();
-    radius *= maxScale;
-
-    for (int i = 0; i < 6; i++)
-    {
-        float distance = glm::dot(planes[i], glm::vec4(minp.x, minp.y, minp.z, 1.0f));
-
-        if (distance < -radius)
-        {
-            return false;
-        }
-    }
-
-    return true;
-}
-
 void Camera::processKeyboard(Camera_Movement _direction, GLfloat _deltaTime)
 {
     GLfloat velocity = m_movementSpeed * _deltaTime;
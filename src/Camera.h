@@ -3,6 +3,7 @@
 
 
 #include "FuryObject.h"
+#include "FuryFrustum.h"
 
 // GL Includes
 #include <GL/glew.h>
@@ -65,11 +66,12 @@ public:
                                    float _near, float _far);
 
     /*!
-     * \brief Проверка, находится ли объект как сфера в зоне видимости камеры
-     * \param _object - Объект. Считаем, что он вписан в сферу
-     * \return Возвращает признак того, находится ли объект в зоне видимости
+     * \brief Получить пирамиду видимости камеры по последним матрицам
+     * getViewMatrix() и getPerspectiveMatrix()
+     * \return Возвращает пирамиду видимости
      */
-    bool sphereInFrustum(FuryObject* _object);
+    inline FuryFrustum frustum() const
+    { return FuryFrustum(m_perspectiveMatrix * m_viewMatrix); }
 
     /*!
      * \brief Обработка нажатий клавиатуры
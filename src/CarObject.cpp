@@ -4,13 +4,44 @@
 #include "FuryWorld.h"
 #include "FuryPbrMaterial.h"
 #include "DefaultObjects/FurySphereObject.h"
-#include "Physics/FuryRaycastCallback.h"
+#include "Learning/FuryPolicyNetwork.h"
+#include "Logger/FuryLogger.h"
+#include "Physics/FuryVehicleSystem.h"
 #include "Managers/FuryMaterialManager.h"
 
 #include <QString>
+#include <cstring>
 
 
 int rayCount = 20;
+//! Количество колёс
+const int wheelCount = 4;
+
+//! Состояние машины в снимке мира
+struct CarSnapshotState
+{
+    //! Движение вперёд
+    float forward;
+    //! Поворот направо
+    float right;
+    //! Номер последнего триггера
+    int lastTriggerNumber;
+    //! Награда
+    float reward;
+    //! Счётчик времени
+    float timeCounter;
+    //! Счётчик триггеров в обратном направлении
+    int backTriggerCounter;
+    //! Признак контакта со стенами
+    bool hasContact;
+    //! Оставшиеся тики повтора действия
+    int repeatTicksLeft;
+    //! Прошлые длины подвески
+    float suspentionLenght[wheelCount];
+};
+
+//! Длина лучей датчика
+float rayLenght = 30;
 
 
 CarObject::CarObject(FuryWorld *_world) :
@@ -26,7 +57,12 @@ CarObject::CarObject(FuryWorld *_world) :
     m_reward(0),
     m_timeCounter(0),
     m_backTriggerCounter(0),
-    m_hasContact(false)
+    m_hasContact(false),
+    m_observationBuffer(observationSize, 0),
+    m_actionBuffer(0),
+    m_policy(nullptr),
+    m_actionRepeat(1),
+    m_repeatTicksLeft(0)
 {
     setShaderName("pbrShader");
 
@@ -39,6 +75,8 @@ CarObject::CarObject(FuryWorld *_world) :
     m_objectWheels.push_back(new FuryObject(world(), glm::vec3(-2, -0.5, -1), this));
     m_objectWheels.last()->setObjectName("wheel_RL");
 
+    world()->vehicleSystem()->addVehicle(this);
+
     for (int i = 0; i < rayCount; ++i)
     {
         m_objectsDebugRays.push_back(new FurySphereObject(world(), glm::vec3(30, 0, 0), 0.25, this, true));
@@ -57,10 +95,19 @@ CarObject::CarObject(FuryWorld *_world) :
 
         m_objectsDebugRays.last()->setMaterialName("rayCastBall");
         m_objectsDebugRays.last()->setObjectName("rayCastBall");
+        m_objectsDebugRays.last()->setCollisionCategory(CategoryDebug);
         m_objectsDebugRays.last()->setShaderName(shaderName());
+
+        float x = std::cos(2 * 3.14 / rayCount * i);
+        float z = std::sin(2 * 3.14 / rayCount * i);
+        m_localRayEnds.append(rp3d::Vector3(rayLenght * x, 0, rayLenght * z));
     }
 
+    m_sensorRays.resize(rayCount);
+
     setObjectName("AI_car");
+    setObjectTag(TagCar);
+    setCollisionCategory(CategoryCar);
     setModelName("backpack2");
     glm::mat4 testSubModel = glm::mat4(1.0f);
     testSubModel = glm::translate(testSubModel, glm::vec3(0, -0.88, 0));
@@ -71,103 +118,29 @@ CarObject::CarObject(FuryWorld *_world) :
 
 CarObject::~CarObject()
 {
-
+    world()->vehicleSystem()->removeVehicle(this);
 }
 
 void CarObject::tick(double _dt)
 {
-    for (int i = 0; i < m_objectWheels.size(); ++i)
+    // В FurySimulation действия всех машин выбираются пакетом до тика мира,
+    // здесь остаются машины вне симуляции
+    if (m_policy != nullptr && isDecisionRequired())
     {
-        glm::vec3 tmp1 = m_objectWheels[i]->worldPosition();
-        // Create the ray
-        reactphysics3d::Vector3 startPoint(tmp1.x, tmp1.y, tmp1.z);
-        reactphysics3d::Vector3 endPoint = m_objectWheels[i]->physicsBody()->getWorldPoint(reactphysics3d::Vector3(0, -m_springLenght, 0));
-        reactphysics3d::Ray ray(startPoint, endPoint);
-
-        // Create an instance of your callback class
-        FuryRaycastCallback callbackObject;
-
-        // Raycast test
-        world()->physicsWorld()->raycast(ray, &callbackObject);
-
-        if (abs(1 - callbackObject.m_lastHitFraction) <= rp3d::MACHINE_EPSILON)
-        {
-            m_lastSuspentionLenght[i] = m_springLenght;
-            continue;
-        }
-
-        float currentLenght = m_springLenght * callbackObject.m_lastHitFraction;
-
-        float deltaX = m_springLenght - currentLenght;
-        float forceValue = m_springK * deltaX;
-
-
-        float damperK = 20;
-        forceValue += (m_lastSuspentionLenght[i] - currentLenght) / _dt * damperK;
-
-
-        physicsBody()->applyLocalForceAtWorldPosition(callbackObject.m_lastNormal * forceValue, startPoint);
-        m_lastSuspentionLenght[i] = currentLenght;
-
-
-
-        rp3d::Transform oldTransform = m_objectWheels[i]->physicsBody()->getTransform();
-
-        rp3d::Vector3 forward(1, 0, 0);
-        rp3d::Vector3 right(0, 0, 1);
-
-        if (i < 2 && m_right != 0)
-        {
-            rp3d::Quaternion rotation = rp3d::Quaternion::fromEulerAngles(0, m_right * (-3.14 / 6), 0);
-            rp3d::Transform transform(oldTransform.getPosition(), oldTransform.getOrientation() * rotation);
-            m_objectWheels[i]->physicsBody()->setTransform(transform);
-        }
-
-        rp3d::decimal scalar1 = forward.dot(callbackObject.m_lastNormal);
-        rp3d::decimal scalar2 = right.dot(callbackObject.m_lastNormal);
-
-        rp3d::Vector3 proj1 = scalar1 * callbackObject.m_lastNormal;
-        rp3d::Vector3 proj2 = scalar2 * callbackObject.m_lastNormal;
-
-        rp3d::Vector3 forwardProjection = forward - proj1;
-        forwardProjection.normalize();
-        rp3d::Vector3 rightProjection = right - proj2;
-        rightProjection.normalize();
-
-        rp3d::Vector3 velocity = m_objectWheels[i]->physicsBody()->getLinearVelocity();
-        rp3d::Vector3 localVelocity = m_objectWheels[i]->physicsBody()->getLocalVector(velocity);
-        rp3d::decimal tireForceRight = forceValue * std::clamp(-localVelocity.z, -1.f, 1.f);
-
-        float slipAngle = 0;
-        float slipAnglePeak = 8.0f / 180.0f * 3.14f;
-
-        if (localVelocity.x != 0)
-        {
-            slipAngle = atan(-localVelocity.z / abs(localVelocity.x));
-        }
-
-        float Sy = slipAngle / slipAnglePeak;
-
-        tireForceRight = forceValue * std::clamp(Sy, -2.f, 2.f);
-
-        rp3d::decimal tireForceForward = forceValue * 1.5 * m_forward;
-        int localVelXSign = localVelocity.x < 0 ? -1 : 1;
-        rp3d::decimal tireForceBack
-                = 0.003
-                * localVelXSign
-                * std::clamp(-pow(localVelocity.x, 2.f), -1000.f, 1000.f);
-        tireForceForward += forceValue * tireForceBack;
+        applyPolicy();
+    }
 
-        rp3d::Vector3 tireForce = (rightProjection * tireForceRight) + (forwardProjection * tireForceForward);
+    if (m_repeatTicksLeft > 0)
+    {
+        --m_repeatTicksLeft;
+    }
 
-        physicsBody()->applyLocalForceAtWorldPosition(tireForce, startPoint);
+    m_timeCounter += _dt;
 
+    // Тик идёт после шага физики, награда считается по новому положению машины
+    addTriggerShapingReward();
 
-        if (i < 2 && m_right != 0)
-        {
-            m_objectWheels[i]->physicsBody()->setTransform(oldTransform);
-        }
-    }
+    // Силы подвески и шин считает FuryVehicleSystem мира после тика всех объектов
 }
 
 void CarObject::keyPressEvent(int _keyCode)
@@ -259,114 +232,198 @@ void CarObject::setBotAction(int _action)
     default:
         break;
     }
+
+    m_repeatTicksLeft = m_actionRepeat;
 }
 
 QVector<float> CarObject::getObservation()
 {
-    QVector<float> result = getRays();
+    QVector<float> result(observationSize);
+    writeObservation(result.data());
+    return result;
+}
+
+void CarObject::writeObservation(float *_observation)
+{
+    writeRays(_observation);
+    writeObservationTail(_observation + 2 * rayCount);
+}
+
+void CarObject::writeObservationBatch(const QVector<CarObject *> &_cars, float *_observations)
+{
+    if (_cars.isEmpty())
+    {
+        return;
+    }
+
+    // Лучи всех машин - один запрос к датчику, дальше раскладываем по наблюдениям
+    QVector<float> rays(_cars.size() * 2 * rayCount);
+    writeRaysBatch(_cars, rays.data());
+
+    for (int i = 0; i < _cars.size(); ++i)
+    {
+        float* observation = _observations + i * observationSize;
+        std::memcpy(observation, rays.constData() + i * 2 * rayCount,
+                    sizeof(float) * 2 * rayCount);
+        _cars[i]->writeObservationTail(observation + 2 * rayCount);
+    }
+}
+
+void CarObject::writeObservationTail(float *_tail)
+{
+    float* tail = _tail;
 
     glm::vec3 speed = getSpeed();
     speed /= 23;
-    result.append(speed.x);
-    result.append(speed.y);
-    result.append(speed.z);
+    tail[0] = speed.x;
+    tail[1] = speed.y;
+    tail[2] = speed.z;
 
     glm::vec3 angularSpeed = getAngularSpeed();
     angularSpeed /= 2;
-    result.append(angularSpeed.x);
-    result.append(angularSpeed.y);
-    result.append(angularSpeed.z);
+    tail[3] = angularSpeed.x;
+    tail[4] = angularSpeed.y;
+    tail[5] = angularSpeed.z;
+
+    tail[6] = 0;
+    tail[7] = 0;
+    tail[8] = 0;
 
     if (world() == nullptr)
     {
-        result.append(0);
-        result.append(0);
-        result.append(0);
         qDebug() << ru("Ошибка при поиске следующего триггера. Нет мира");
-        return result;
+        return;
     }
 
-    FuryObject* trigger = nullptr;
-    int nextTriggerNumber = (getLastTriggerNumber() + 1) % 72;
-
-    for (int i = 0; i < world()->getAllObjects().size(); ++i)
-    {
-        FuryObject* object = world()->getAllObjects()[i];
-
-        if (object->objectName() == QString("Trigger %1").arg(nextTriggerNumber))
-        {
-            trigger = object;
-            break;
-        }
-    }
+    FuryObject* trigger = world()->triggerByNumber(nextTriggerNumber());
 
     if (trigger != nullptr)
     {
         const glm::vec3& triggerPos = trigger->worldPosition();
         glm::vec3 direct = calcNextTriggerVector(triggerPos);
-        result.append(direct.x);
-        result.append(direct.y);
-        result.append(direct.z);
+        tail[6] = direct.x;
+        tail[7] = direct.y;
+        tail[8] = direct.z;
     }
     else
     {
-        result.append(0);
-        result.append(0);
-        result.append(0);
         qDebug() << ru("Ошибка при поиске следующего триггера. Нет триггера");
     }
+}
 
+QVector<float> CarObject::getRays()
+{
+    QVector<float> result(2 * rayCount);
+    writeRays(result.data());
     return result;
 }
 
-QVector<float> CarObject::getRays()
+void CarObject::writeRays(float *_rays)
 {
-    QVector<float> result;
+    fillSensorRays(m_sensorRays.data());
+    world()->raySensor()->raycast(m_sensorRays.constData(), rayCount, _rays);
+    updateDebugRays(m_sensorRays.constData(), _rays);
+}
 
-    float rayLenght = 30;
-    for (int i = 0; i < rayCount; ++i)
+void CarObject::writeRaysBatch(const QVector<CarObject*> &_cars, float *_rays)
+{
+    if (_cars.isEmpty())
     {
-        float x = std::cos(2 * 3.14 / rayCount * i);
-        float z = std::sin(2 * 3.14 / rayCount * i);
+        return;
+    }
+
+    QVector<FuryRaySensor::Ray> rays(_cars.size() * rayCount);
+
+    for (int i = 0; i < _cars.size(); ++i)
+    {
+        _cars[i]->fillSensorRays(rays.data() + i * rayCount);
+    }
+
+    _cars.first()->world()->raySensor()->raycast(rays.constData(), rays.size(), _rays);
 
-        glm::vec3 tmp1 = worldPosition() - glm::vec3(0, 0.25, 0);
-        reactphysics3d::Vector3 tmp2 = physicsBody()->getWorldPoint(reactphysics3d::Vector3(rayLenght * x, 0, rayLenght * z));
-        glm::vec3 tmp3(tmp2.x, tmp2.y, tmp2.z);
-        tmp3 -= glm::vec3(0, 0.25, 0);
-        // Create the ray
-        reactphysics3d::Vector3 startPoint(tmp1.x, tmp1.y, tmp1.z);
-        reactphysics3d::Vector3 endPoint(tmp3.x, tmp3.y, tmp3.z);
-        reactphysics3d::Ray ray(startPoint, endPoint);
+    for (int i = 0; i < _cars.size(); ++i)
+    {
+        _cars[i]->updateDebugRays(rays.constData() + i * rayCount,
+                                  _rays + i * 2 * rayCount);
+    }
+}
 
-        // Create an instance of your callback class
-        FuryRaycastCallback callbackObject;
+void CarObject::updateObservationBuffer()
+{
+    writeObservation(m_observationBuffer.data());
+}
 
-        {
-            callbackObject.m_needTriggerNumber = (m_lastTriggerNumber + 1) % 72;
-        }
+void CarObject::applyActionBuffer()
+{
+    setBotAction(m_actionBuffer);
+}
+
+void CarObject::applyPolicy()
+{
+    if (m_policy == nullptr)
+    {
+        return;
+    }
+
+    updateObservationBuffer();
+    m_actionBuffer = m_policy->predictAction(m_observationBuffer.constData());
+    applyActionBuffer();
+}
+
+void CarObject::applyPolicyBatch(const QVector<CarObject*> &_cars, const FuryPolicyNetwork &_policy)
+{
+    QVector<float> observations(_cars.size() * observationSize);
+    QVector<int> actions(_cars.size());
 
-        // Raycast test
-        world()->physicsWorld()->raycast(ray, &callbackObject);
+    writeObservationBatch(_cars, observations.data());
 
-        result.append(callbackObject.m_lastHitFraction);
-        result.append((callbackObject.m_needTriggered) ? 1.0f : -1.0f);
+    _policy.predictActions(observations.constData(), _cars.size(), actions.data());
 
-        glm::vec3 tmp4 = tmp1 + (tmp3 - tmp1) * callbackObject.m_lastHitFraction;
-        m_objectsDebugRays[i]->setWorldPosition(tmp4);
+    for (int i = 0; i < _cars.size(); ++i)
+    {
+        _cars[i]->m_actionBuffer = actions[i];
+        _cars[i]->applyActionBuffer();
+    }
+}
+
+void CarObject::fillSensorRays(FuryRaySensor::Ray *_rays) const
+{
+    const rp3d::Transform& transform = physicsBody()->getTransform();
+    const rp3d::Vector3 heightOffset(0, 0.25, 0);
+
+    glm::vec3 position = worldPosition();
+    rp3d::Vector3 startPoint = rp3d::Vector3(position.x, position.y, position.z) - heightOffset;
+    unsigned short categoryMask = world()->vehicleSystem()->rayMask();
+
+    for (int i = 0; i < rayCount; ++i)
+    {
+        _rays[i].start = startPoint;
+        _rays[i].end = transform * m_localRayEnds[i] - heightOffset;
+        _rays[i].needTriggerNumber = nextTriggerNumber();
+        _rays[i].ignoreBody = physicsBody();
+        _rays[i].categoryMask = categoryMask;
+    }
+}
+
+void CarObject::updateDebugRays(const FuryRaySensor::Ray *_rays, const float *_result)
+{
+    for (int i = 0; i < rayCount; ++i)
+    {
+        float hitFraction = _result[2 * i];
+        bool needTriggered = _result[2 * i + 1] > 0;
 
+        rp3d::Vector3 hitPoint = _rays[i].start + (_rays[i].end - _rays[i].start) * hitFraction;
+        m_objectsDebugRays[i]->setWorldPosition(glm::vec3(hitPoint.x, hitPoint.y, hitPoint.z));
+
+        if (needTriggered)
+        {
+            m_objectsDebugRays[i]->setMaterialName("greenRay");
+        }
+        else
         {
-            if (callbackObject.m_needTriggered)
-            {
-                m_objectsDebugRays[i]->setMaterialName("greenRay");
-            }
-            else
-            {
-                m_objectsDebugRays[i]->setMaterialName("rayCastBall");
-            }
+            m_objectsDebugRays[i]->setMaterialName("rayCastBall");
         }
     }
-
-    return result;
 }
 
 glm::vec3 CarObject::getSpeed()
@@ -394,6 +451,18 @@ int CarObject::getLastTriggerNumber()
     return m_lastTriggerNumber;
 }
 
+int CarObject::nextTriggerNumber() const
+{
+    int triggerCount = world()->triggerCount();
+
+    if (triggerCount == 0)
+    {
+        return -1;
+    }
+
+    return (m_lastTriggerNumber + 1) % triggerCount;
+}
+
 void CarObject::onContact()
 {
     m_hasContact = true;
@@ -401,12 +470,15 @@ void CarObject::onContact()
 
 void CarObject::onTrigger(int _number)
 {
-    if (m_lastTriggerNumber == 0 && _number == 71)
+    // Номер последнего триггера круга: переход через него - новый круг
+    int lastNumber = world()->triggerCount() - 1;
+
+    if (m_lastTriggerNumber == 0 && _number == lastNumber)
     {
         m_reward -= 0.1f;
         m_backTriggerCounter++;
     }
-    else if (m_lastTriggerNumber == 71 && _number == 0)
+    else if (m_lastTriggerNumber == lastNumber && _number == 0)
     {
         m_reward += 0.1f;
         m_timeCounter = 0;
@@ -425,26 +497,42 @@ void CarObject::onTrigger(int _number)
     m_lastTriggerNumber = _number;
 }
 
-glm::vec3 CarObject::calcNextTriggerVector(const glm::vec3 &_trigger)
+glm::vec3 CarObject::calcNextTriggerVector(const glm::vec3 &_trigger) const
 {
     glm::vec3 vector = _trigger - worldPosition();
     vector = glm::normalize(vector);
     rp3d::Vector3 worldVector(vector.x, vector.y, vector.z);
     rp3d::Vector3 localVector = physicsBody()->getLocalVector(worldVector);
-    glm::vec3 speedGlm = getSpeed();
-    rp3d::Vector3 speed(speedGlm.x / 23, speedGlm.y / 23, speedGlm.z / 23);
 
-    float tmp = speed.dot(localVector) * 0.05;
+    return glm::vec3(localVector.x, localVector.y, localVector.z);
+}
+
+void CarObject::addTriggerShapingReward()
+{
+    if (world() == nullptr)
+    {
+        return;
+    }
+
+    FuryObject* trigger = world()->triggerByNumber(nextTriggerNumber());
+
+    if (trigger == nullptr)
+    {
+        return;
+    }
+
+    glm::vec3 direct = calcNextTriggerVector(trigger->worldPosition());
+    glm::vec3 speed = getSpeed() / 23.0f;
+
+    float tmp = glm::dot(speed, direct) * 0.05f;
     if (tmp < 0)
     {
-        m_reward += tmp * 1.2;
+        m_reward += tmp * 1.2f;
     }
     else
     {
         m_reward += tmp;
     }
-
-    return glm::vec3(localVector.x, localVector.y, localVector.z);
 }
 
 void CarObject::reset()
@@ -455,21 +543,60 @@ void CarObject::reset()
     m_hasContact = false;
     m_timeCounter = 0;
     m_lastTriggerNumber = 0;
+    m_repeatTicksLeft = 0;
 }
 
-bool CarObject::checkTimeCounter()
+void CarObject::saveSnapshotState(QByteArray &_state) const
 {
-    if (m_timeCounter < 18)
+    CarSnapshotState state;
+    state.forward = m_forward;
+    state.right = m_right;
+    state.lastTriggerNumber = m_lastTriggerNumber;
+    state.reward = m_reward;
+    state.timeCounter = m_timeCounter;
+    state.backTriggerCounter = m_backTriggerCounter;
+    state.hasContact = m_hasContact;
+    state.repeatTicksLeft = m_repeatTicksLeft;
+
+    for (int i = 0; i < wheelCount; ++i)
     {
-        m_timeCounter += 1.0f / 60;
-        return true;
+        state.suspentionLenght[i] = m_lastSuspentionLenght[i];
     }
-    else
+
+    _state.append(reinterpret_cast<const char*>(&state), sizeof(state));
+}
+
+void CarObject::restoreSnapshotState(const char *_state, int _size)
+{
+    if (_size != int(sizeof(CarSnapshotState)))
     {
-        return false;
+        Debug(ru("[ ВНИМАНИЕ ] Неверный размер состояния машины в снимке мира: %1").arg(_size));
+        return;
+    }
+
+    CarSnapshotState state;
+    std::memcpy(&state, _state, sizeof(state));
+
+    m_forward = state.forward;
+    m_right = state.right;
+    m_lastTriggerNumber = state.lastTriggerNumber;
+    m_reward = state.reward;
+    m_timeCounter = state.timeCounter;
+    m_backTriggerCounter = state.backTriggerCounter;
+    m_hasContact = state.hasContact;
+    m_repeatTicksLeft = state.repeatTicksLeft;
+
+    for (int i = 0; i < wheelCount; ++i)
+    {
+        m_lastSuspentionLenght[i] = state.suspentionLenght[i];
     }
 }
 
+bool CarObject::checkTimeCounter()
+{
+    return m_timeCounter < 18;
+}
+
 bool CarObject::checkBackTriggerCounter()
 {
     if (m_backTriggerCounter < 3)
@@ -498,7 +625,7 @@ void CarObject::initPhysics(reactphysics3d::BodyType _type)
     FuryObject::initPhysics(_type);
 
     const reactphysics3d::Vector3 halfExtents(6.5 / 2.0f, 1 / 2.0f, 3 / 2.0f);
-    reactphysics3d::BoxShape* boxShape = world()->physicsCommon()->createBoxShape(halfExtents);
+    reactphysics3d::BoxShape* boxShape = world()->boxShape(halfExtents);
     reactphysics3d::Transform transform_boxShape = reactphysics3d::Transform::identity();
     reactphysics3d::Collider* collider_box;
     collider_box = physicsBody()->addCollider(boxShape, transform_boxShape);
@@ -512,15 +639,14 @@ void CarObject::initPhysics(reactphysics3d::BodyType _type)
 
 glm::vec3 CarObject::cameraPosition() const
 {
-    reactphysics3d::Vector3 cameraLocalPosition(m_cameraLocalPosition.x, 0, m_cameraLocalPosition.z);
-    reactphysics3d::Vector3 worldPos = physicsBody()->getWorldPoint(cameraLocalPosition);
+    // Камеру ставит поток отрисовки, поэтому берём трансформацию для отрисовки
+    glm::vec4 worldPos = renderTransform() * glm::vec4(m_cameraLocalPosition.x, 0, m_cameraLocalPosition.z, 1);
     return glm::vec3(worldPos.x, worldPos.y + m_cameraLocalPosition.y, worldPos.z);
 }
 
 glm::vec3 CarObject::cameraViewPoint() const
 {
-    reactphysics3d::Vector3 cameraLocalViewPoint(m_cameraLocalViewPoint.x, 0, m_cameraLocalViewPoint.z);
-    reactphysics3d::Vector3 worldPoint = physicsBody()->getWorldPoint(cameraLocalViewPoint);
+    glm::vec4 worldPoint = renderTransform() * glm::vec4(m_cameraLocalViewPoint.x, 0, m_cameraLocalViewPoint.z, 1);
     return glm::vec3(worldPoint.x, worldPoint.y + m_cameraLocalViewPoint.y, worldPoint.z);
 }
 
@@ -2,12 +2,14 @@
 #define CAROBJECT_H
 
 #include "FuryObject.h"
+#include "Physics/FuryRaySensor.h"
 
 #include <reactphysics3d/reactphysics3d.h>
 #include <vector>
 
 #include <QVector>
 
+class FuryPolicyNetwork;
 
 //! Автомобиль для обучения ИИ
 class CarObject : public FuryObject
@@ -19,6 +21,11 @@ class CarObject : public FuryObject
     Q_PROPERTY(glm::vec3 cameraLocalPosition READ cameraLocalPosition WRITE setCameraLocalPosition)
 
 public:
+    //! Размер наблюдения: 20 лучей по 2 значения, скорость, угловая скорость, направление к триггеру
+    static constexpr int observationSize = 49;
+    //! Количество поворотных колёс: первые в списке колёс
+    static constexpr int steeredWheelCount = 2;
+
     /*!
      * \brief Конструктор
      * \param[in] _world - Мир
@@ -33,6 +40,13 @@ public:
      */
     void tick(double _dt) override;
 
+    /*!
+     * \brief Машине нужен tick: политика, повтор действия, счётчик времени
+     * \return Возвращает true
+     */
+    inline bool hasTick() const override
+    { return true; }
+
     /*!
      * \brief Событие нажатия кнопки клавиатуры
      * \param[in] _keyCode - Код кнопки
@@ -49,23 +63,153 @@ public:
     void resetKeyInput();
 
     /*!
-     * \brief Установка действия от Бота
+     * \brief Установка действия от Бота. Действие держится actionRepeat() тиков
      * \param[in] _action - Действие
      */
     void setBotAction(int _action);
 
+    /*!
+     * \brief Получение управления движением вперёд
+     * \return Возвращает ввод [-1;1]
+     */
+    inline float forwardInput() const
+    { return m_forward; }
+
+    /*!
+     * \brief Получение управления поворотом направо
+     * \return Возвращает ввод [-1;1]
+     */
+    inline float rightInput() const
+    { return m_right; }
+
+    /*!
+     * \brief Прямая установка управления, минуя действия Бота и клавиатуру.
+     * Для воспроизведения записанных эпизодов
+     * \param[in] _forward - Движение вперёд
+     * \param[in] _right - Поворот направо
+     */
+    inline void setInput(float _forward, float _right)
+    {
+        m_forward = _forward;
+        m_right = _right;
+    }
+
+    /*!
+     * \brief Установка повтора действия: сколько тиков физики по 1/60 секунды
+     * держится каждое действие Бота. Награда за эти тики накапливается в m_reward,
+     * а скрипт и политика вызываются только на границе решения
+     * \param[in] _ticks - Количество тиков. 1 - решение в каждом тике
+     */
+    inline void setActionRepeat(int _ticks)
+    { m_actionRepeat = qMax(1, _ticks); }
+
+    /*!
+     * \brief Получение повтора действия
+     * \return Возвращает количество тиков на одно действие
+     */
+    inline int actionRepeat() const
+    { return m_actionRepeat; }
+
+    /*!
+     * \brief Проверка границы решения: прошлое действие отработало все тики повтора
+     * \return Возвращает признак того, что нужно выбрать новое действие
+     */
+    inline bool isDecisionRequired() const
+    { return m_repeatTicksLeft <= 0; }
+
+    /*!
+     * \brief Нужно ли вызывать update скрипта машины в этом тике
+     * \return Возвращает признак границы решения
+     */
+    inline bool isScriptUpdateRequired() const override
+    { return isDecisionRequired(); }
+
     /*!
      * \brief Получение наблюдения для ИИ
      * \return Возвращает список наблюдаемых параметров
      */
     QVector<float> getObservation();
 
+    /*!
+     * \brief Запись наблюдения для ИИ в буфер без выделения памяти
+     * \param[out] _observation - Буфер на observationSize значений
+     */
+    void writeObservation(float* _observation);
+
+    /*!
+     * \brief Запись наблюдений нескольких машин одного мира. Лучи всех машин
+     * проверяются одним пакетным запросом к датчику
+     * \param[in] _cars - Машины. Все должны быть в одном мире
+     * \param[out] _observations - Буфер на _cars.size() * observationSize значений, машины подряд
+     */
+    static void writeObservationBatch(const QVector<CarObject*>& _cars, float* _observations);
+
     /*!
      * \brief Получить значения лучей
      * \return Возвращает значения лучей
      */
     QVector<float> getRays();
 
+    /*!
+     * \brief Запись значений лучей в буфер одним пакетным запросом
+     * \param[out] _rays - Буфер на 2 * 20 значений: доля длины и признак нужного триггера
+     */
+    void writeRays(float* _rays);
+
+    /*!
+     * \brief Запись значений лучей нескольких машин одного мира одним пакетным запросом
+     * \param[in] _cars - Машины. Все должны быть в одном мире
+     * \param[out] _rays - Буфер на _cars.size() * 2 * 20 значений, машины подряд
+     */
+    static void writeRaysBatch(const QVector<CarObject*>& _cars, float* _rays);
+
+    //! Запись текущего наблюдения в буфер наблюдения
+    void updateObservationBuffer();
+
+    //! Установка действия от Бота из буфера действия
+    void applyActionBuffer();
+
+    /*!
+     * \brief Подключение нейросети политики. Пока она подключена, машина
+     * в каждом тике сама выбирает действие по наблюдению, без скриптов
+     * \param[in] _policy - Нейросеть политики. nullptr - отключить.
+     * Память остаётся за вызывающим
+     */
+    inline void setPolicy(const FuryPolicyNetwork* _policy)
+    { m_policy = _policy; }
+
+    /*!
+     * \brief Получение нейросети политики
+     * \return Возвращает нейросеть политики или nullptr
+     */
+    inline const FuryPolicyNetwork* policy() const
+    { return m_policy; }
+
+    //! Выбор и установка действия нейросетью политики по текущему наблюдению
+    void applyPolicy();
+
+    /*!
+     * \brief Выбор действий нескольких машин одним пакетным проходом нейросети
+     * \param[in] _cars - Машины
+     * \param[in] _policy - Нейросеть политики
+     */
+    static void applyPolicyBatch(const QVector<CarObject*>& _cars, const FuryPolicyNetwork& _policy);
+
+    /*!
+     * \brief Получение буфера наблюдения. Память принадлежит машине,
+     * скрипты получают его без копирования
+     * \return Возвращает буфер на observationSize значений
+     */
+    inline float* observationBuffer()
+    { return m_observationBuffer.data(); }
+
+    /*!
+     * \brief Получение буфера действия. Память принадлежит машине
+     * \return Возвращает буфер на одно действие
+     */
+    inline int* actionBuffer()
+    { return &m_actionBuffer; }
+
     /*!
      * \brief Получить вектор скорости
      * \return Возвращает вектор скорости
@@ -91,6 +235,12 @@ public:
      */
     int getLastTriggerNumber();
 
+    /*!
+     * \brief Получение номера следующего триггера на трассе
+     * \return Возвращает номер следующего триггера или -1, если в мире нет триггеров
+     */
+    int nextTriggerNumber() const;
+
     //! Произошёл контакт. Вызывается из FuryEventListener при контакте.
     void onContact();
 
@@ -105,13 +255,27 @@ public:
      * \param[in] _trigger - Позиция следующего триггера
      * \return Возвращает локальное направление к следующему триггеру
      */
-    glm::vec3 calcNextTriggerVector(const glm::vec3& _trigger);
+    glm::vec3 calcNextTriggerVector(const glm::vec3& _trigger) const;
 
     //! Возрождение
     void reset() override;
 
     /*!
-     * \brief Проверка временного счётчика
+     * \brief Запись счётчиков эпизода, управления и подвески в снимок мира
+     * \param[out] _state - Буфер, в конец которого дописывается состояние
+     */
+    void saveSnapshotState(QByteArray& _state) const override;
+
+    /*!
+     * \brief Восстановление состояния, записанного saveSnapshotState
+     * \param[in] _state - Начало записанного состояния
+     * \param[in] _size - Размер записанного состояния
+     */
+    void restoreSnapshotState(const char* _state, int _size) override;
+
+    /*!
+     * \brief Проверка временного счётчика. Время идёт в tick, поэтому результат
+     * не зависит от того, как часто вызывается проверка
      * \return Возвращает признак того, не закончилось ли у нас ещё время
      */
     bool checkTimeCounter();
@@ -181,6 +345,36 @@ public:
     inline float springK() const
     { return m_springK; }
 
+    /*!
+     * \brief Получение колёс. Первые steeredWheelCount колёс - поворотные
+     * \return Возвращает колёса
+     */
+    inline const QVector<FuryObject*>& wheels() const
+    { return m_objectWheels; }
+
+    /*!
+     * \brief Получение угла поворота передних колёс вокруг оси y
+     * \return Возвращает угол в радианах
+     */
+    inline float steerAngle() const
+    { return m_right * (-3.14f / 6); }
+
+    /*!
+     * \brief Получение длины пружины колеса в прошлом тике
+     * \param[in] _wheel - Индекс колеса
+     * \return Возвращает длину пружины
+     */
+    inline float lastSuspentionLenght(int _wheel) const
+    { return m_lastSuspentionLenght[_wheel]; }
+
+    /*!
+     * \brief Установка длины пружины колеса в текущем тике
+     * \param[in] _wheel - Индекс колеса
+     * \param[in] _lenght - Длина пружины
+     */
+    inline void setLastSuspentionLenght(int _wheel, float _lenght)
+    { m_lastSuspentionLenght[_wheel] = _lenght; }
+
     inline const glm::vec3& cameraLocalViewPoint() const
     { return m_cameraLocalViewPoint; }
 
@@ -193,11 +387,41 @@ public:
     inline void setCameraLocalPosition(const glm::vec3& _pos)
     { m_cameraLocalPosition = _pos; }
 
+private:
+    /*!
+     * \brief Заполнение лучей датчика по текущему положению машины
+     * \param[out] _rays - Буфер на 20 лучей
+     */
+    void fillSensorRays(FuryRaySensor::Ray* _rays) const;
+
+    /*!
+     * \brief Запись части наблюдения после лучей: скорости и направление на триггер
+     * \param[out] _tail - Буфер на observationSize - 40 значений (после 20 лучей)
+     */
+    void writeObservationTail(float* _tail);
+
+    /*!
+     * \brief Начисление награды за скорость в сторону следующего триггера.
+     * Вызывается каждый тик, чтобы при повторе действия награда не терялась
+     */
+    void addTriggerShapingReward();
+
+    /*!
+     * \brief Перемещение отладочных сфер в точки пересечения лучей
+     * \param[in] _rays - Лучи датчика
+     * \param[in] _result - Результат пакетного запроса по этим лучам
+     */
+    void updateDebugRays(const FuryRaySensor::Ray* _rays, const float* _result);
+
 private:
     //! Список объектов-колёс
     QVector<FuryObject*> m_objectWheels;
     //! Список объектов - сфер для отображения raycast лучей
     QVector<FuryObject*> m_objectsDebugRays;
+    //! Концы лучей датчика в локальных координатах машины
+    QVector<rp3d::Vector3> m_localRayEnds;
+    //! Лучи датчика. Переиспользуются между запросами
+    QVector<FuryRaySensor::Ray> m_sensorRays;
     //! Длина пружин. Референс
     float m_springLenght;
     //! Коэффициент жёсткости пружин
@@ -219,12 +443,23 @@ private:
     int m_lastTriggerNumber;
     //! Награда за текущий тик
     float m_reward;
-    //! Счётчик времени
+    //! Счётчик времени эпизода без продвижения по трассе, в секундах
     float m_timeCounter;
     //! Счётчик триггеров, проеханных по трассе в обратном направлении
     int m_backTriggerCounter;
     //! Признак наличия контактов со стенами
     bool m_hasContact;
+
+    //! Буфер наблюдения для скриптов
+    QVector<float> m_observationBuffer;
+    //! Буфер действия для скриптов
+    int m_actionBuffer;
+    //! Нейросеть политики. nullptr - действия задаются снаружи
+    const FuryPolicyNetwork* m_policy;
+    //! Количество тиков на одно действие Бота
+    int m_actionRepeat;
+    //! Сколько тиков ещё держать текущее действие Бота
+    int m_repeatTicksLeft;
 };
 
 
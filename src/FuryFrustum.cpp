@@ -0,0 +1,100 @@
+#include "FuryFrustum.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+
+FuryFrustum::FuryFrustum()
+{
+    for (glm::vec4& plane : m_planes)
+    {
+        plane = glm::vec4(0, 0, 0, 1);
+    }
+}
+
+FuryFrustum::FuryFrustum(const glm::mat4 &_viewProjection)
+{
+    glm::mat4 m = glm::transpose(_viewProjection);
+    m_planes[0] = m[3] + m[0];
+    m_planes[1] = m[3] - m[0];
+    m_planes[2] = m[3] + m[1];
+    m_planes[3] = m[3] - m[1];
+    m_planes[4] = m[3] + m[2];
+    m_planes[5] = m[3] - m[2];
+}
+
+bool FuryFrustum::boxVisible(const glm::vec3 &_min, const glm::vec3 &_max) const
+{
+    for (const glm::vec4& plane : m_planes)
+    {
+        // Вершина коробки, дальше всех продвинутая вдоль нормали плоскости
+        glm::vec3 positive(plane.x >= 0 ? _max.x : _min.x,
+                           plane.y >= 0 ? _max.y : _min.y,
+                           plane.z >= 0 ? _max.z : _min.z);
+
+        if (glm::dot(glm::vec3(plane), positive) + plane.w < 0)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int FuryFrustum::cullBoxes(const float *_minX, const float *_minY, const float *_minZ,
+                           const float *_maxX, const float *_maxY, const float *_maxZ,
+                           int _count, quint8 *_visible) const
+{
+    int visibleCount = 0;
+    int i = 0;
+
+#if defined(__SSE2__) || defined(_M_X64)
+    // Выбор вершины по знаку нормали одинаков для всех коробок - делаем его один раз
+    const float* positiveX[6];
+    const float* positiveY[6];
+    const float* positiveZ[6];
+
+    for (int p = 0; p < 6; ++p)
+    {
+        positiveX[p] = m_planes[p].x >= 0 ? _maxX : _minX;
+        positiveY[p] = m_planes[p].y >= 0 ? _maxY : _minY;
+        positiveZ[p] = m_planes[p].z >= 0 ? _maxZ : _minZ;
+    }
+
+    const __m128 zero = _mm_setzero_ps();
+
+    for (; i + 4 <= _count; i += 4)
+    {
+        __m128 outside = _mm_setzero_ps();
+
+        for (int p = 0; p < 6; ++p)
+        {
+            __m128 distance = _mm_set1_ps(m_planes[p].w);
+            distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(m_planes[p].x), _mm_loadu_ps(positiveX[p] + i)));
+            distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(m_planes[p].y), _mm_loadu_ps(positiveY[p] + i)));
+            distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(m_planes[p].z), _mm_loadu_ps(positiveZ[p] + i)));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, zero));
+        }
+
+        int outsideBits = _mm_movemask_ps(outside);
+
+        for (int lane = 0; lane < 4; ++lane)
+        {
+            quint8 visible = ((outsideBits >> lane) & 1) == 0;
+            _visible[i + lane] = visible;
+            visibleCount += visible;
+        }
+    }
+#endif
+
+    for (; i < _count; ++i)
+    {
+        quint8 visible = boxVisible(glm::vec3(_minX[i], _minY[i], _minZ[i]),
+                                    glm::vec3(_maxX[i], _maxY[i], _maxZ[i]));
+        _visible[i] = visible;
+        visibleCount += visible;
+    }
+
+    return visibleCount;
+}
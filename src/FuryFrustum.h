@@ -0,0 +1,66 @@
+#ifndef FURYFRUSTUM_H
+#define FURYFRUSTUM_H
+
+#include <glm/glm.hpp>
+
+#include <QtGlobal>
+
+
+/*!
+ * \brief Усечённая пирамида видимости.
+ *
+ * Плоскости берутся из матрицы проекции и вида (метод Грибба-Хартманна).
+ * Коробки проверяются по ближайшей к плоскости вершине: коробка отсекается,
+ * если она целиком за одной из плоскостей. Пакетная проверка идёт SIMD
+ * по 4 коробки над границами, разложенными по массивам.
+ */
+class FuryFrustum
+{
+public:
+    //! Конструктор пирамиды, которая ничего не отсекает
+    FuryFrustum();
+
+    /*!
+     * \brief Конструктор
+     * \param[in] _viewProjection - Произведение матриц проекции и вида
+     */
+    explicit FuryFrustum(const glm::mat4& _viewProjection);
+
+    /*!
+     * \brief Проверка коробки
+     * \param[in] _min - Минимальная вершина коробки в глобальных координатах
+     * \param[in] _max - Максимальная вершина коробки в глобальных координатах
+     * \return Возвращает признак пересечения коробки с пирамидой
+     */
+    bool boxVisible(const glm::vec3& _min, const glm::vec3& _max) const;
+
+    /*!
+     * \brief Пакетная проверка коробок
+     * \param[in] _minX - Минимальные x коробок
+     * \param[in] _minY - Минимальные y коробок
+     * \param[in] _minZ - Минимальные z коробок
+     * \param[in] _maxX - Максимальные x коробок
+     * \param[in] _maxY - Максимальные y коробок
+     * \param[in] _maxZ - Максимальные z коробок
+     * \param[in] _count - Количество коробок
+     * \param[out] _visible - Признак видимости каждой коробки, _count значений
+     * \return Возвращает количество видимых коробок
+     */
+    int cullBoxes(const float* _minX, const float* _minY, const float* _minZ,
+                  const float* _maxX, const float* _maxY, const float* _maxZ,
+                  int _count, quint8* _visible) const;
+
+    /*!
+     * \brief Получение плоскости
+     * \param[in] _index - Номер плоскости [0; 6): лево, право, низ, верх, ближняя, дальняя
+     * \return Возвращает плоскость (a, b, c, d): a*x + b*y + c*z + d >= 0 внутри
+     */
+    inline const glm::vec4& plane(int _index) const
+    { return m_planes[_index]; }
+
+private:
+    //! Плоскости пирамиды, нормали внутрь
+    glm::vec4 m_planes[6];
+};
+
+#endif // FURYFRUSTUM_H
@@ -29,7 +29,7 @@ public:
     { return false; }
 
     /*!
-     * \brief Установка материала в шейдер
+     * \brief Установка материала в шейдер. Шейдер должен быть активен
      * \param[in] _shader - Шейдер
      */
     virtual void setShaderMaterial(Shader *_shader) = 0;
@@ -20,6 +20,7 @@ FuryMesh::FuryMesh(FuryModel *_parentModel, const QVector<Vertex> &_vertices,
     EBO(0),
     m_materialName(_material),
     m_transformation(_transformation),
+    m_normalMatrix(glm::transpose(glm::inverse(glm::mat3(_transformation)))),
     m_minimumVertex(_minVertex),
     m_maximumVertex(_maxVertex)
 {
@@ -28,16 +29,19 @@ FuryMesh::FuryMesh(FuryModel *_parentModel, const QVector<Vertex> &_vertices,
 
 void FuryMesh::draw()
 {
+#if NEED_OPENGL == 1
     if (VAO != 0)
     {
         glBindVertexArray(VAO);
         glDrawElements(GL_TRIANGLES, (GLsizei)m_indices.size(), GL_UNSIGNED_INT, 0);
         glBindVertexArray(0);
     }
+#endif
 }
 
 void FuryMesh::setupMesh()
 {
+#if NEED_OPENGL == 1
     // Создание буферов, массивов openGL
     glGenVertexArrays(1, &VAO);
     glGenBuffers(1, &VBO);
@@ -76,6 +80,7 @@ void FuryMesh::setupMesh()
     glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
                           (void*)offsetof(Vertex, m_bitangent));
     glBindVertexArray(0);
+#endif
 }
 
 glm::vec3 FuryMesh::meshCenter() const
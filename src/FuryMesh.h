@@ -69,7 +69,17 @@ public:
      * \param[in] _transformation - Матрица трансформации меша
      */
     inline void setTransformation(const glm::mat4& _transformation)
-    { m_transformation = _transformation; }
+    {
+        m_transformation = _transformation;
+        m_normalMatrix = glm::transpose(glm::inverse(glm::mat3(_transformation)));
+    }
+
+    /*!
+     * \brief Получить матрицу нормалей для трансформации меша
+     * \return Возвращает матрицу нормалей
+     */
+    inline const glm::mat3& normalMatrix() const
+    { return m_normalMatrix; }
 
     /*!
      * \brief Получить родительскую модель
@@ -91,6 +101,20 @@ public:
      */
     glm::vec3 meshCenter() const;
 
+    /*!
+     * \brief Получить минимальную вершину куба, в который вписан меш
+     * \return Возвращает минимальную вершину без трансформации меша
+     */
+    inline const glm::vec3& minVertex() const
+    { return m_minimumVertex; }
+
+    /*!
+     * \brief Получить максимальную вершину куба, в который вписан меш
+     * \return Возвращает максимальную вершину без трансформации меша
+     */
+    inline const glm::vec3& maxVertex() const
+    { return m_maximumVertex; }
+
 private:
     FuryModel* m_parentModel;
 
@@ -110,6 +134,8 @@ private:
     QString m_materialName;
     //! Матрица трансформации меша относительно родителя
     glm::mat4 m_transformation;
+    //! Матрица нормалей для трансформации меша
+    glm::mat3 m_normalMatrix;
 
     //! Минимальная координата куба, в которую вписана модель
     glm::vec3 m_minimumVertex;
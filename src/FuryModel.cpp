@@ -14,7 +14,7 @@ FuryModel::FuryModel(const QString &_path) :
     m_path(_path),
     m_modelRadius(1),
     m_minimumVertex(std::numeric_limits<float>::max()),
-    m_maximumVertex(std::numeric_limits<float>::min()),
+    m_maximumVertex(std::numeric_limits<float>::lowest()),
     m_ready(false),
     m_loaded(false)
 {
@@ -201,7 +201,7 @@ FuryMesh *FuryModel::processMesh(aiMesh *_mesh, const aiScene *_scene, const aiN
     QVector<unsigned int> indices;
 
     glm::vec3 meshMinVertex(std::numeric_limits<float>::max());
-    glm::vec3 meshMaxVertex(std::numeric_limits<float>::min());
+    glm::vec3 meshMaxVertex(std::numeric_limits<float>::lowest());
 
     // Обходим вершины
     for (unsigned int i = 0; i < _mesh->mNumVertices; i++)
@@ -6,7 +6,8 @@
 FuryModelCache::FuryModelCache(const QString &_modelName) :
     QObject(),
     m_modelName(_modelName),
-    m_model(&FuryModelManager::instance()->modelByName(m_modelName))
+    m_model(&FuryModelManager::instance()->modelByName(m_modelName)),
+    m_version(0)
 {
     initConnections();
 }
@@ -27,6 +28,7 @@ void FuryModelCache::requestModelSlot(const QString &_modelName)
     if (m_modelName == _modelName)
     {
         m_model = &FuryModelManager::instance()->modelByName(m_modelName);
+        ++m_version;
     }
 }
 
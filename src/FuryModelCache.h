@@ -30,6 +30,14 @@ public:
      */
     const FuryModel& model() const;
 
+    /*!
+     * \brief Получение номера изменения модели. Растёт при смене названия
+     * и при каждой перезагрузке модели менеджером
+     * \return Возвращает номер изменения
+     */
+    inline quint32 version() const
+    { return m_version; }
+
 private slots:
     /*!
      * \brief Слот перезапроса модели у менеджера
@@ -46,6 +54,8 @@ private:
     QString m_modelName;
     //! Модель
     const FuryModel* m_model;
+    //! Номер изменения модели
+    quint32 m_version;
 };
 
 #endif // FURYMODELCACHE_H
@@ -2,6 +2,7 @@
 
 #include "FuryWorld.h"
 #include "FuryModelCache.h"
+#include "Physics/FuryRaySensor.h"
 
 #include <reactphysics3d/reactphysics3d.h>
 
@@ -9,6 +10,7 @@
 #include <QJsonArray>
 #include <QQuaternion>
 #include <QMetaProperty>
+#include <QMutexLocker>
 
 /*!
  * \brief Дополнительная функция. Потом надо вынести. Углы Эйлера по кватерниону
@@ -17,6 +19,26 @@
  */
 rp3d::Vector3 quaternionToEulerAngles(const rp3d::Quaternion& q);
 
+/*!
+ * \brief Название категории столкновений для JSON сцены
+ * \param[in] _category - Категория столкновений
+ * \return Возвращает название
+ */
+static QString collisionCategoryName(FuryObject::CollisionCategory _category)
+{
+    switch (_category)
+    {
+    case FuryObject::CategoryTrigger:
+        return "TRIGGER";
+    case FuryObject::CategoryCar:
+        return "CAR";
+    case FuryObject::CategoryDebug:
+        return "DEBUG";
+    default:
+        return "TRACK";
+    }
+}
+
 
 
 FuryObject::FuryObject(FuryWorld *_world, FuryObject *_parent, bool _withoutJoint) :
@@ -30,15 +52,34 @@ FuryObject::FuryObject(FuryWorld *_world, const glm::vec3& _position, FuryObject
     m_worldPosition(_position),
     m_initLocalPosition(_position),
     m_worldRotation(glm::vec3(0, 0, 0)),
+    m_worldOrientation(rp3d::Quaternion::identity()),
+    m_worldRotationDirty(false),
+    m_worldMatrix(1),
+    m_worldMatrixDirty(true),
+    m_transformVersion(0),
     m_initLocalRotation(glm::vec3(0, 0, 0)),
     m_scales(glm::vec3(1, 1, 1)),
     m_physicsBody(nullptr),
     m_world(_world),
     m_modelCache(new FuryModelCache()),
     m_modelTransform(1),
+    m_renderTransform(1),
+    m_hasRenderTransform(false),
+    m_renderModelMatrix(1),
+    m_renderNormalMatrix(1),
+    m_renderModelVersion(0),
+    m_renderMatrixDirty(true),
+    m_renderMatrixVersion(0),
+    m_renderVersion(0),
     m_textureScales(1, 1),
     m_visible(true),
-    m_selectedInEditor(false)
+    m_selectedInEditor(false),
+    m_objectTag(TagNone),
+    m_tagNumber(-1),
+    m_collisionCategory(CategoryTrack),
+    m_collideWithMask(collideAllMask),
+    m_mergedCollider(nullptr),
+    m_mergedLocalTransform(rp3d::Transform::identity())
 {
     m_world->addObject(this);
 
@@ -77,28 +118,34 @@ FuryObject::~FuryObject()
         m_modelCache = nullptr;
     }
 
+    if (m_mergedCollider != nullptr)
+    {
+        m_world->trackBody()->removeCollider(m_mergedCollider);
+        m_world->raySensor()->invalidate();
+    }
+
+    m_world->removeObject(this);
+
     m_world->physicsWorld()->destroyRigidBody(m_physicsBody);
 }
 
 void FuryObject::postPhysics()
 {
-    const rp3d::Transform& physics_transform = physicsBody()->getTransform();
-    const rp3d::Vector3& physics_position = physics_transform.getPosition();
-    const rp3d::Quaternion& orientation = physics_transform.getOrientation();
-    rp3d::Vector3 newAngle = quaternionToEulerAngles(orientation);
-
-    m_worldPosition = glm::vec3(physics_position.x, physics_position.y, physics_position.z);
-    m_worldRotation = glm::vec3(newAngle.x, newAngle.y, newAngle.z);
-
-    foreach (QObject* child, children())
+    // Статические и спящие тела физика не двигает: кэш трансформации остаётся
+    if (physicsBody()->getType() != rp3d::BodyType::STATIC && !physicsBody()->isSleeping())
     {
-        FuryObject* obj = qobject_cast<FuryObject*>(child);
-        if (obj == nullptr)
+        const rp3d::Transform& physics_transform = physicsBody()->getTransform();
+        const rp3d::Vector3& physics_position = physics_transform.getPosition();
+        const rp3d::Quaternion& orientation = physics_transform.getOrientation();
+        glm::vec3 position(physics_position.x, physics_position.y, physics_position.z);
+
+        if (position != m_worldPosition || !(orientation == m_worldOrientation))
         {
-            continue;
+            m_worldPosition = position;
+            m_worldOrientation = orientation;
+            m_worldRotationDirty = true;
+            markTransformChanged();
         }
-
-        obj->postPhysics();
     }
 }
 
@@ -116,6 +163,25 @@ void FuryObject::reset()
     }
 }
 
+void FuryObject::restorePhysicsState(const reactphysics3d::Transform &_transform,
+                                     const reactphysics3d::Vector3 &_linearVelocity,
+                                     const reactphysics3d::Vector3 &_angularVelocity,
+                                     const glm::vec3 &_worldRotation)
+{
+    const rp3d::Vector3& position = _transform.getPosition();
+    m_worldPosition = glm::vec3(position.x, position.y, position.z);
+    m_worldOrientation = _transform.getOrientation();
+    m_worldRotation = _worldRotation;
+    m_worldRotationDirty = false;
+    markTransformChanged();
+
+    physicsBody()->setTransform(_transform);
+    physicsBody()->resetForce();
+    physicsBody()->resetTorque();
+    physicsBody()->setLinearVelocity(_linearVelocity);
+    physicsBody()->setAngularVelocity(_angularVelocity);
+}
+
 void FuryObject::addChildObject(FuryObject *_child, bool _withoutJoint)
 {
     _child->setParent(this);
@@ -155,6 +221,7 @@ void FuryObject::setInitLocalPosition(const glm::vec3 &_pos)
 void FuryObject::setWorldRotation(const glm::vec3 &_rotation)
 {
     m_worldRotation = _rotation;
+    m_worldRotationDirty = false;
     setTransformToWorld();
 }
 
@@ -182,12 +249,65 @@ void FuryObject::setInitLocalRotationDegrees(const glm::vec3 &_rotation)
 
 glm::mat4 FuryObject::getOpenGLTransform() const
 {
-    float rawMatrix[16];
-    m_physicsBody->getTransform().getOpenGLMatrix(rawMatrix);
-    return glm::mat4(rawMatrix[0], rawMatrix[1], rawMatrix[2], rawMatrix[3],
-                     rawMatrix[4], rawMatrix[5], rawMatrix[6], rawMatrix[7],
-                     rawMatrix[8], rawMatrix[9], rawMatrix[10], rawMatrix[11],
-            rawMatrix[12], rawMatrix[13], rawMatrix[14], rawMatrix[15]);
+    if (m_worldMatrixDirty)
+    {
+        float rawMatrix[16];
+        rp3d::Vector3 position(m_worldPosition.x, m_worldPosition.y, m_worldPosition.z);
+        rp3d::Transform(position, m_worldOrientation).getOpenGLMatrix(rawMatrix);
+        m_worldMatrix = glm::make_mat4(rawMatrix);
+        m_worldMatrixDirty = false;
+    }
+
+    return m_worldMatrix;
+}
+
+const glm::mat4 &FuryObject::renderModelMatrix() const
+{
+    // Без снимка трансформаций матрица модели идёт от физики: сверяем версию
+    if (m_renderMatrixDirty || (!m_hasRenderTransform && m_renderMatrixVersion != m_transformVersion))
+    {
+        m_renderModelMatrix = glm::scale(renderTransform(), m_scales) * m_modelTransform;
+        m_renderNormalMatrix = glm::transpose(glm::inverse(glm::mat3(m_renderModelMatrix)));
+        m_renderMatrixVersion = m_transformVersion;
+        m_renderMatrixDirty = false;
+        ++m_renderModelVersion;
+    }
+
+    return m_renderModelMatrix;
+}
+
+const glm::mat3 &FuryObject::renderNormalMatrix() const
+{
+    renderModelMatrix();
+    return m_renderNormalMatrix;
+}
+
+quint32 FuryObject::renderModelVersion() const
+{
+    renderModelMatrix();
+    return m_renderModelVersion;
+}
+
+void FuryObject::setRenderTransform(const glm::mat4 &_transform)
+{
+    if (!m_hasRenderTransform || m_renderTransform != _transform)
+    {
+        m_renderTransform = _transform;
+        m_hasRenderTransform = true;
+        m_renderMatrixDirty = true;
+    }
+}
+
+const glm::vec3 &FuryObject::worldRotation() const
+{
+    if (m_worldRotationDirty)
+    {
+        rp3d::Vector3 angles = quaternionToEulerAngles(m_worldOrientation);
+        m_worldRotation = glm::vec3(angles.x, angles.y, angles.z);
+        m_worldRotationDirty = false;
+    }
+
+    return m_worldRotation;
 }
 
 void FuryObject::setModelName(const QString &_modelName)
@@ -196,6 +316,48 @@ void FuryObject::setModelName(const QString &_modelName)
     m_modelCache->setModelName(m_modelName);
 }
 
+QString FuryObject::shaderName() const
+{
+    QMutexLocker locker(&m_renderNamesMutex);
+    return m_shaderName;
+}
+
+void FuryObject::setShaderName(const QString &_shaderName)
+{
+    {
+        QMutexLocker locker(&m_renderNamesMutex);
+        if (m_shaderName == _shaderName)
+        {
+            return;
+        }
+        m_shaderName = _shaderName;
+    }
+
+    // Номер меняется только при смене названия, иначе список отрисовки
+    // заново разрешал бы объект. Увидев номер, поток отрисовки прочтёт новое
+    m_renderVersion.fetchAndAddRelease(1);
+}
+
+QString FuryObject::materialName() const
+{
+    QMutexLocker locker(&m_renderNamesMutex);
+    return m_materialName;
+}
+
+void FuryObject::setMaterialName(const QString &_materialName)
+{
+    {
+        QMutexLocker locker(&m_renderNamesMutex);
+        if (m_materialName == _materialName)
+        {
+            return;
+        }
+        m_materialName = _materialName;
+    }
+
+    m_renderVersion.fetchAndAddRelease(1);
+}
+
 QJsonObject FuryObject::toJson() const
 {
     QJsonObject result;
@@ -240,7 +402,9 @@ QJsonObject FuryObject::toJson() const
     result["children"] = childrenJson;
 
 
-    if (physicsBody()->getNbColliders() == 0)
+    rp3d::Collider* collider = firstCollider();
+
+    if (collider == nullptr)
     {
         result["physicsType"] = "NONE";
         result["isTrigger"] = false;
@@ -260,7 +424,8 @@ QJsonObject FuryObject::toJson() const
             result["physicsType"] = "KINEMATIC";
         }
 
-        result["isTrigger"] = physicsBody()->getCollider(0)->getIsTrigger();
+        result["isTrigger"] = collider->getIsTrigger();
+        result["collisionCategory"] = collisionCategoryName(m_collisionCategory);
     }
 
     return result;
@@ -321,13 +486,80 @@ void FuryObject::fromJson(const QJsonObject &_json)
             initPhysics(rp3d::BodyType::KINEMATIC);
         }
 
-        physicsBody()->getCollider(0)->setIsTrigger(_json["isTrigger"].toBool());
+        bool isTrigger = _json["isTrigger"].toBool();
+        physicsBody()->getCollider(0)->setIsTrigger(isTrigger);
+
+        // Старые сцены без категории: триггер по флагу, иначе категория класса
+        QString category = _json["collisionCategory"].toString();
+
+        if (category == "TRIGGER" || (category.isEmpty() && isTrigger))
+        {
+            setCollisionCategory(CategoryTrigger);
+        }
+        else if (category == "CAR")
+        {
+            setCollisionCategory(CategoryCar);
+        }
+        else if (category == "DEBUG")
+        {
+            setCollisionCategory(CategoryDebug);
+        }
+        else if (category == "TRACK")
+        {
+            setCollisionCategory(CategoryTrack);
+        }
+        else
+        {
+            setCollisionCategory(m_collisionCategory);
+        }
+    }
+}
+
+void FuryObject::setCollisionCategory(CollisionCategory _category)
+{
+    m_collisionCategory = _category;
+
+    for (rp3d::uint i = 0; i < physicsBody()->getNbColliders(); ++i)
+    {
+        physicsBody()->getCollider(i)->setCollisionCategoryBits(_category);
+        physicsBody()->getCollider(i)->setCollideWithMaskBits(m_collideWithMask);
+    }
+
+    if (m_mergedCollider != nullptr)
+    {
+        m_mergedCollider->setCollisionCategoryBits(_category);
+        m_mergedCollider->setCollideWithMaskBits(m_collideWithMask);
+    }
+
+    m_world->raySensor()->invalidate();
+}
+
+void FuryObject::setCollideWithMask(unsigned short _mask)
+{
+    m_collideWithMask = _mask;
+
+    for (rp3d::uint i = 0; i < physicsBody()->getNbColliders(); ++i)
+    {
+        physicsBody()->getCollider(i)->setCollideWithMaskBits(_mask);
+    }
+
+    if (m_mergedCollider != nullptr)
+    {
+        m_mergedCollider->setCollideWithMaskBits(_mask);
     }
 }
 
+void FuryObject::setMergedCollider(reactphysics3d::Collider *_collider,
+                                   const reactphysics3d::Transform &_localTransform)
+{
+    m_mergedCollider = _collider;
+    m_mergedLocalTransform = _localTransform;
+}
+
 void FuryObject::initPhysics(reactphysics3d::BodyType _type)
 {
     physicsBody()->setType(_type);
+    m_world->invalidateUpdateLists();
 }
 
 glm::vec3 FuryObject::calculateWorldPositionByInit() const
@@ -383,31 +615,88 @@ void FuryObject::resetTransformationToInit()
     }
 
 
-    rp3d::Vector3 newAngle = quaternionToEulerAngles(objectOrientation);
     m_worldPosition = glm::vec3(objectPos.x, objectPos.y, objectPos.z);
-    m_worldRotation = glm::vec3(newAngle.x, newAngle.y, newAngle.z);
+    m_worldOrientation = objectOrientation;
+    m_worldRotationDirty = true;
+    markTransformChanged();
 
     physicsBody()->setTransform(objectTransform);
     physicsBody()->resetForce();
     physicsBody()->resetTorque();
     physicsBody()->setLinearVelocity(rp3d::Vector3(0, 0, 0));
     physicsBody()->setAngularVelocity(rp3d::Vector3(0, 0, 0));
+
+    updateMergedCollider(objectTransform);
+    invalidateRaySensorIfStatic();
 }
 
 void FuryObject::setTransformToWorld()
 {
+    const glm::vec3& rotation = worldRotation();
     rp3d::Vector3 objectPos(m_worldPosition.x, m_worldPosition.y, m_worldPosition.z);
-    rp3d::Quaternion objectOrientation = rp3d::Quaternion::fromEulerAngles(m_worldRotation.x,
-                                                                           m_worldRotation.y,
-                                                                           m_worldRotation.z);
+    rp3d::Quaternion objectOrientation = rp3d::Quaternion::fromEulerAngles(rotation.x,
+                                                                           rotation.y,
+                                                                           rotation.z);
     rp3d::Transform objectTransform(objectPos, objectOrientation);
+    m_worldOrientation = objectOrientation;
+    markTransformChanged();
+
     physicsBody()->setTransform(objectTransform);
     physicsBody()->resetForce();
     physicsBody()->resetTorque();
     physicsBody()->setLinearVelocity(rp3d::Vector3(0, 0, 0));
     physicsBody()->setAngularVelocity(rp3d::Vector3(0, 0, 0));
+
+    updateMergedCollider(objectTransform);
+    invalidateRaySensorIfStatic();
+}
+
+void FuryObject::invalidateRaySensorIfStatic()
+{
+    // Датчик лучей кэширует границы статических коллайдеров
+    if (physicsBody()->getType() == rp3d::BodyType::STATIC
+            && firstCollider() != nullptr)
+    {
+        m_world->raySensor()->invalidate();
+    }
+}
+
+void FuryObject::updateMergedCollider(const reactphysics3d::Transform &_objectTransform)
+{
+    if (m_mergedCollider == nullptr)
+    {
+        return;
+    }
+
+    // Тело трассы стоит в начале координат: трансформация коллайдера в нём мировая
+    rp3d::Transform colliderTransform = _objectTransform * m_mergedLocalTransform;
+
+    if (!(m_mergedCollider->getLocalToBodyTransform() == colliderTransform))
+    {
+        m_mergedCollider->setLocalToBodyTransform(colliderTransform);
+    }
 }
 
+void FuryObject::markTransformChanged()
+{
+    m_worldMatrixDirty = true;
+    ++m_transformVersion;
+}
+
+reactphysics3d::Collider *FuryObject::firstCollider() const
+{
+    if (m_mergedCollider != nullptr)
+    {
+        return m_mergedCollider;
+    }
+
+    if (physicsBody()->getNbColliders() == 0)
+    {
+        return nullptr;
+    }
+
+    return physicsBody()->getCollider(0);
+}
 
 
 
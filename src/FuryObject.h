@@ -13,8 +13,11 @@
 #include <reactphysics3d/reactphysics3d.h>
 
 #include <QObject>
+#include <QMutex>
 #include <QString>
+#include <QByteArray>
 #include <QJsonObject>
+#include <QAtomicInteger>
 
 class Camera;
 class Shader;
@@ -43,6 +46,35 @@ class FuryObject : public QObject
     Q_PROPERTY(bool visible READ visible WRITE setVisible)
 
 public:
+    //! Метка объекта для проверок без сравнения названий
+    enum ObjectTag
+    {
+        //! Обычный объект
+        TagNone = 0,
+        //! Машина для обучения ИИ
+        TagCar,
+        //! Триггер трассы
+        TagTrigger
+    };
+
+    //! Категория столкновений коллайдеров объекта. Биты для масок запросов физики
+    enum CollisionCategory
+    {
+        //! Статическая геометрия трассы: стены, дорога
+        CategoryTrack = 0x0001,
+        //! Триггер трассы
+        CategoryTrigger = 0x0002,
+        //! Машина
+        CategoryCar = 0x0004,
+        //! Отладочный объект
+        CategoryDebug = 0x0008
+    };
+
+    //! Маска лучей, которые останавливаются о твёрдые тела: трассу и машины
+    static const unsigned short raySolidMask = CategoryTrack | CategoryCar;
+    //! Маска столкновений со всеми категориями
+    static const unsigned short collideAllMask = 0xFFFF;
+
     /*!
      * \brief Конструктор
      * \param[in] _world - Мир, к которому принадлежит объект
@@ -64,15 +96,32 @@ public:
     //! Деструктор
     virtual ~FuryObject();
 
-    //! Метод, вызывающийся между обновлением физики и tick
+    /*!
+     * \brief Метод, вызывающийся между обновлением физики и tick. Мир вызывает
+     * его только для нестатических тел, включая дочерние объекты
+     */
     virtual void postPhysics();
 
     /*!
-     * \brief Обновление состояния
+     * \brief Обновление состояния. Вызывается только для корневых объектов,
+     * у которых hasTick() возвращает true
      * \param[in] _dt - Время от прошлого обновления
      */
     virtual void tick(double /*_dt*/) {};
 
+    /*!
+     * \brief Нужно ли миру вызывать tick объекта. Переопределяется вместе с tick
+     * \return Возвращает признак наличия обновления состояния
+     */
+    virtual bool hasTick() const { return false; }
+
+    /*!
+     * \brief Нужно ли вызывать update скрипта объекта в этом тике.
+     * Объекты с повтором действия пропускают тики между решениями
+     * \return Возвращает признак вызова update
+     */
+    virtual bool isScriptUpdateRequired() const { return true; }
+
     //! Сброс
     virtual void reset();
 
@@ -125,15 +174,13 @@ public:
      * \brief Получение названия шейдера
      * \return Возвращает название шейдера
      */
-    inline const QString& shaderName() const
-    { return m_shaderName; }
+    QString shaderName() const;
 
     /*!
      * \brief Установка названия шейдера
      * \param[in] _shaderName - Название шейдера
      */
-    inline void setShaderName(const QString& _shaderName)
-    { m_shaderName = _shaderName; }
+    void setShaderName(const QString& _shaderName);
 
     /*!
      * \brief Получение физического тела
@@ -142,6 +189,23 @@ public:
     inline reactphysics3d::RigidBody* physicsBody() const
     { return m_physicsBody; }
 
+    /*!
+     * \brief Получение коллайдера объекта, перенесённого в общее тело трассы
+     * (см. FuryWorld::mergeStaticTrack)
+     * \return Возвращает коллайдер или nullptr, если объект не объединён
+     */
+    inline reactphysics3d::Collider* mergedCollider() const
+    { return m_mergedCollider; }
+
+    /*!
+     * \brief Установка коллайдера объекта в общем теле трассы. Трансформация
+     * коллайдера дальше следует за трансформацией объекта
+     * \param[in] _collider - Коллайдер в общем теле
+     * \param[in] _localTransform - Трансформация коллайдера относительно объекта
+     */
+    void setMergedCollider(reactphysics3d::Collider* _collider,
+                           const reactphysics3d::Transform& _localTransform);
+
     /*!
      * \brief Установка физического тела
      * \param[in] _physicsBody - Физическое тело
@@ -150,11 +214,44 @@ public:
     { m_physicsBody = _physicsBody; }
 
     /*!
-     * \brief Получение вращения от физического мира
+     * \brief Восстановление состояния физического тела из снимка мира.
+     * Мировое вращение берётся из снимка, без пересчёта углов Эйлера
+     * \param[in] _transform - Трансформация тела
+     * \param[in] _linearVelocity - Линейная скорость
+     * \param[in] _angularVelocity - Угловая скорость
+     * \param[in] _worldRotation - Мировое вращение, соответствующее _transform
+     */
+    void restorePhysicsState(const reactphysics3d::Transform& _transform,
+                             const reactphysics3d::Vector3& _linearVelocity,
+                             const reactphysics3d::Vector3& _angularVelocity,
+                             const glm::vec3& _worldRotation);
+
+    /*!
+     * \brief Запись в снимок мира состояния, которого нет в физике (счётчики эпизода и т.п.)
+     * \param[out] _state - Буфер, в конец которого дописывается состояние
+     */
+    virtual void saveSnapshotState(QByteArray& /*_state*/) const {};
+
+    /*!
+     * \brief Восстановление состояния, записанного saveSnapshotState
+     * \param[in] _state - Начало записанного состояния
+     * \param[in] _size - Размер записанного состояния
+     */
+    virtual void restoreSnapshotState(const char* /*_state*/, int /*_size*/) {};
+
+    /*!
+     * \brief Получение вращения от физического мира в углах Эйлера.
+     * Углы считаются из кватерниона только при запросе, для редактора и скриптов
      * \return Возвращает вращение
      */
-    inline const glm::vec3& worldRotation() const
-    { return m_worldRotation; }
+    const glm::vec3& worldRotation() const;
+
+    /*!
+     * \brief Получение вращения от физического мира
+     * \return Возвращает кватернион вращения
+     */
+    inline const reactphysics3d::Quaternion& worldOrientation() const
+    { return m_worldOrientation; }
 
     /*!
      * \brief Установка вращения объекта в мировых координанах
@@ -199,14 +296,60 @@ public:
      * \param[in] _sizes - Масштабы по осям
      */
     inline void setScales(const glm::vec3& _scales)
-    { m_scales = _scales; }
+    { m_scales = _scales; m_renderMatrixDirty = true; }
 
     /*!
-     * \brief Получить матрицу модели (model) для объекта
+     * \brief Получить матрицу модели (model) для объекта. Кэшируется и
+     * пересчитывается только после движения тела
      * \return Возвращает матрицу модели (model) для объекта
      */
     virtual glm::mat4 getOpenGLTransform() const;
 
+    /*!
+     * \brief Установка матрицы модели для отрисовки. Пока мир считается в потоке
+     * симуляции, её выставляет поток отрисовки из снимка трансформаций
+     * \param[in] _transform - Матрица модели
+     */
+    void setRenderTransform(const glm::mat4& _transform);
+
+    //! Возврат к матрице модели из физического тела
+    inline void clearRenderTransform()
+    { m_hasRenderTransform = false; m_renderMatrixDirty = true; }
+
+    /*!
+     * \brief Получить матрицу модели для отрисовки с масштабом и трансформацией
+     * модели, без трансформации меша. Кэшируется до изменения трансформации
+     * \return Возвращает матрицу модели
+     */
+    const glm::mat4& renderModelMatrix() const;
+
+    /*!
+     * \brief Получить матрицу нормалей для renderModelMatrix()
+     * \return Возвращает матрицу нормалей
+     */
+    const glm::mat3& renderNormalMatrix() const;
+
+    /*!
+     * \brief Получить номер изменения renderModelMatrix(). По нему кэши,
+     * зависящие от матрицы модели, узнают о движении объекта
+     * \return Возвращает номер изменения
+     */
+    quint32 renderModelVersion() const;
+
+    /*!
+     * \brief Получить матрицу модели для отрисовки
+     * \return Возвращает матрицу из снимка трансформаций, без него - getOpenGLTransform()
+     */
+    inline glm::mat4 renderTransform() const
+    { return m_hasRenderTransform ? m_renderTransform : getOpenGLTransform(); }
+
+    /*!
+     * \brief Получить позицию для отрисовки
+     * \return Возвращает позицию из снимка трансформаций, без него - worldPosition()
+     */
+    inline glm::vec3 renderPosition() const
+    { return m_hasRenderTransform ? glm::vec3(m_renderTransform[3]) : m_worldPosition; }
+
     /*!
      * \brief Получить мир, к которому принадлежит объект
      * \return Возвращает мир, к которому принадлежит объект
@@ -239,7 +382,7 @@ public:
      * \param[in] _modelTransform - Матрица трансформации
      */
     inline void setModelTransform(const glm::mat4& _modelTransform)
-    { m_modelTransform = _modelTransform; }
+    { m_modelTransform = _modelTransform; m_renderMatrixDirty = true; }
 
     /*!
      * \brief Получить трансформацию модели
@@ -252,15 +395,22 @@ public:
      * \brief Установка названия материала
      * \param[in] _materialName - Название материала
      */
-    inline void setMaterialName(const QString& _materialName)
-    { m_materialName = _materialName; }
+    void setMaterialName(const QString& _materialName);
 
     /*!
      * \brief Получить название материала
      * \return Возвращает название материала
      */
-    inline const QString& materialName() const
-    { return m_materialName; }
+    QString materialName() const;
+
+    /*!
+     * \brief Получение номера изменения материала и шейдера объекта.
+     * По нему список отрисовки обновляет только изменившиеся объекты.
+     * Материал меняется из потока симуляции, читается из потока отрисовки
+     * \return Возвращает номер изменения
+     */
+    inline quint32 renderVersion() const
+    { return m_renderVersion.loadAcquire(); }
 
     /*!
      * \brief Получить масштаб текстуры
@@ -304,6 +454,56 @@ public:
     inline void setSelectedInEditor(bool _selected)
     { m_selectedInEditor = _selected; }
 
+    /*!
+     * \brief Получить метку объекта
+     * \return Возвращает метку объекта
+     */
+    inline ObjectTag objectTag() const
+    { return m_objectTag; }
+
+    /*!
+     * \brief Получить номер объекта в пределах метки (например, номер триггера)
+     * \return Возвращает номер. -1, если номера нет
+     */
+    inline int tagNumber() const
+    { return m_tagNumber; }
+
+    /*!
+     * \brief Установить метку объекта
+     * \param[in] _tag - Метка
+     * \param[in] _number - Номер в пределах метки
+     */
+    inline void setObjectTag(ObjectTag _tag, int _number = -1)
+    { m_objectTag = _tag; m_tagNumber = _number; }
+
+    /*!
+     * \brief Получить категорию столкновений
+     * \return Возвращает категорию столкновений
+     */
+    inline CollisionCategory collisionCategory() const
+    { return m_collisionCategory; }
+
+    /*!
+     * \brief Установить категорию столкновений всем коллайдерам объекта.
+     * Запросы лучей с маской без этой категории объект не видят
+     * \param[in] _category - Категория столкновений
+     */
+    void setCollisionCategory(CollisionCategory _category);
+
+    /*!
+     * \brief Получить маску категорий, с которыми сталкивается объект
+     * \return Возвращает маску категорий
+     */
+    inline unsigned short collideWithMask() const
+    { return m_collideWithMask; }
+
+    /*!
+     * \brief Установить маску категорий, с которыми сталкиваются коллайдеры
+     * объекта. На запросы лучей не влияет
+     * \param[in] _mask - Маска категорий
+     */
+    void setCollideWithMask(unsigned short _mask);
+
     /*!
      * \brief Перевод в JSON объект
      * \return Возвращает JSON объект
@@ -345,14 +545,42 @@ private:
     //! Установка трансформации по мировым координатам
     void setTransformToWorld();
 
+    //! Сброс кэша датчика лучей при перемещении статического тела с коллайдерами
+    void invalidateRaySensorIfStatic();
+
+    /*!
+     * \brief Перенос объединённого коллайдера вслед за объектом
+     * \param[in] _objectTransform - Новая трансформация объекта
+     */
+    void updateMergedCollider(const reactphysics3d::Transform& _objectTransform);
+
+    /*!
+     * \brief Получение первого коллайдера объекта, в своём теле или в общем
+     * \return Возвращает коллайдер или nullptr, если коллайдеров нет
+     */
+    reactphysics3d::Collider* firstCollider() const;
+
+    //! Отметка изменения мировой трансформации для кэшей матриц
+    void markTransformChanged();
+
 private:
     //! Мировая позиция
     glm::vec3 m_worldPosition;
     //! Начальная позиция в локальном пространстве
     glm::vec3 m_initLocalPosition;
 
+    //! Мировое вращение объекта в углах Эйлера. Считается лениво
+    mutable glm::vec3 m_worldRotation;
     //! Мировое вращение объекта
-    glm::vec3 m_worldRotation;
+    reactphysics3d::Quaternion m_worldOrientation;
+    //! Углы Эйлера устарели относительно кватерниона
+    mutable bool m_worldRotationDirty;
+    //! Кэш мировой матрицы тела
+    mutable glm::mat4 m_worldMatrix;
+    //! Кэш мировой матрицы устарел
+    mutable bool m_worldMatrixDirty;
+    //! Номер изменения мировой трансформации
+    quint32 m_transformVersion;
     //! Начальное вращение в локальном пространстве
     glm::vec3 m_initLocalRotation;
 
@@ -373,8 +601,26 @@ private:
     FuryModelCache* m_modelCache;
     //! Трансформация для модели
     glm::mat4 m_modelTransform;
+    //! Матрица модели для отрисовки из снимка трансформаций
+    glm::mat4 m_renderTransform;
+    //! Признак наличия матрицы модели для отрисовки
+    bool m_hasRenderTransform;
+    //! Кэш матрицы модели для отрисовки
+    mutable glm::mat4 m_renderModelMatrix;
+    //! Кэш матрицы нормалей для отрисовки
+    mutable glm::mat3 m_renderNormalMatrix;
+    //! Номер изменения кэша матрицы модели для отрисовки
+    mutable quint32 m_renderModelVersion;
+    //! Кэш матриц для отрисовки устарел
+    mutable bool m_renderMatrixDirty;
+    //! Номер изменения мировой трансформации, по которому посчитан кэш
+    mutable quint32 m_renderMatrixVersion;
     //! Название материала объекта
     QString m_materialName;
+    //! Мьютекс названий материала и шейдера
+    mutable QMutex m_renderNamesMutex;
+    //! Номер изменения материала и шейдера
+    QAtomicInteger<quint32> m_renderVersion;
 
     //! Масштаб текстур
     glm::vec2 m_textureScales;
@@ -384,6 +630,19 @@ private:
 
     //! Объект выбран в редакторе
     bool m_selectedInEditor;
+
+    //! Метка объекта
+    ObjectTag m_objectTag;
+    //! Номер объекта в пределах метки
+    int m_tagNumber;
+    //! Категория столкновений
+    CollisionCategory m_collisionCategory;
+    //! Маска категорий, с которыми сталкивается объект
+    unsigned short m_collideWithMask;
+    //! Коллайдер в общем теле трассы. nullptr, если объект не объединён
+    reactphysics3d::Collider* m_mergedCollider;
+    //! Трансформация объединённого коллайдера относительно объекта
+    reactphysics3d::Transform m_mergedLocalTransform;
 };
 
 #endif // FURYOBJECT_H
@@ -18,7 +18,7 @@ FuryPbrMaterial::FuryPbrMaterial() :
 
 void FuryPbrMaterial::setShaderMaterial(Shader *_shader)
 {
-    _shader->use();
+#if NEED_OPENGL == 1
     _shader->setVec3("material.albedoColor", m_albedoColor);
     _shader->setFloat("material.metallic", m_metallic);
     _shader->setFloat("material.roughness", m_roughness);
@@ -84,6 +84,9 @@ void FuryPbrMaterial::setShaderMaterial(Shader *_shader)
     {
         glEnable(GL_CULL_FACE);
     }
+#else
+    Q_UNUSED(_shader)
+#endif
 }
 
 void FuryPbrMaterial::setAlbedoTexture(const QString &_texture)
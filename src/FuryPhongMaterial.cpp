@@ -48,7 +48,7 @@ void FuryPhongMaterial::setNormalTexture(const QString &_normalTexture)
 
 void FuryPhongMaterial::setShaderMaterial(Shader *_shader)
 {
-    _shader->use();
+#if NEED_OPENGL == 1
     _shader->setFloat("material.shininess", 32);
     _shader->setVec3("material.diffuseColor", m_diffuseColor);
     _shader->setVec3("material.specularColor", m_specularColor);
@@ -105,6 +105,9 @@ void FuryPhongMaterial::setShaderMaterial(Shader *_shader)
     {
         glEnable(GL_CULL_FACE);
     }
+#else
+    Q_UNUSED(_shader)
+#endif
 }
 
 QJsonObject FuryPhongMaterial::toJson() const
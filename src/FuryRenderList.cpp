@@ -0,0 +1,263 @@
+#include "FuryRenderList.h"
+
+#include "FuryMesh.h"
+#include "FuryModel.h"
+#include "FuryObject.h"
+#include "FuryWorld.h"
+#include "FuryFrustum.h"
+#include "FuryModelCache.h"
+#include "Logger/FuryLogger.h"
+#include "Managers/FuryShaderManager.h"
+#include "Managers/FuryMaterialManager.h"
+
+#include <reactphysics3d/reactphysics3d.h>
+
+
+FuryRenderList::FuryRenderList(FuryWorld *_world) :
+    m_world(_world),
+    m_materialVersion(0),
+    m_shaderVersion(0),
+    m_staticVersion(0),
+    m_dirty(true)
+{
+
+}
+
+void FuryRenderList::update()
+{
+    if (!m_dirty)
+    {
+        // Новая модель меняет количество записей объекта - только полная сборка
+        for (const ObjectRecord& record : m_records)
+        {
+            if (record.modelVersion != record.object->modelCache()->version())
+            {
+                m_dirty = true;
+                break;
+            }
+        }
+    }
+
+    if (m_dirty)
+    {
+        rebuild();
+        return;
+    }
+
+    bool managersChanged = m_materialVersion != FuryMaterialManager::instance()->version()
+            || m_shaderVersion != FuryShaderManager::instance()->version();
+
+    for (ObjectRecord& record : m_records)
+    {
+        if (managersChanged || record.renderVersion != record.object->renderVersion())
+        {
+            resolve(record);
+        }
+    }
+
+    m_materialVersion = FuryMaterialManager::instance()->version();
+    m_shaderVersion = FuryShaderManager::instance()->version();
+}
+
+void FuryRenderList::rebuild()
+{
+    m_entries.clear();
+    m_records.clear();
+    // Удалённые материалы и меши не должны занимать номера
+    m_shaderIds.clear();
+    m_materialIds.clear();
+    m_meshIds.clear();
+    m_objects = m_world->getRootObjects();
+
+    // Обход в ширину: дети добавляются в конец обходимого списка
+    for (int i = 0; i < m_objects.size(); ++i)
+    {
+        FuryObject* obj = m_objects[i];
+
+        foreach (QObject* child, obj->children())
+        {
+            FuryObject* childObject = qobject_cast<FuryObject*>(child);
+            if (childObject != nullptr)
+            {
+                m_objects.append(childObject);
+            }
+        }
+
+        ObjectRecord record;
+        record.object = obj;
+        record.firstEntry = m_entries.size();
+        record.modelVersion = obj->modelCache()->version();
+        // Номер не совпадёт с объектом: границы посчитаются при первом отсечении
+        record.boundsVersion = obj->renderModelVersion() - 1;
+        record.isStatic = false;
+        record.visible = obj->visible();
+
+        // Солнце рисуется для наглядности и не должно затенять сцену
+        bool castsShadow = obj->objectName() != "sunVisualBox";
+
+        foreach (FuryMesh* mesh, obj->modelCache()->model().meshes())
+        {
+            Entry entry;
+            entry.object = obj;
+            entry.mesh = mesh;
+            entry.material = nullptr;
+            entry.shader = nullptr;
+            entry.castsShadow = castsShadow;
+            entry.isStatic = false;
+            entry.sortKey = 0;
+            m_entries.append(entry);
+        }
+
+        record.entryCount = m_entries.size() - record.firstEntry;
+        resolve(record);
+        updateStatic(record);
+        m_records.append(record);
+    }
+
+    m_boundsMinX.resize(m_entries.size());
+    m_boundsMinY.resize(m_entries.size());
+    m_boundsMinZ.resize(m_entries.size());
+    m_boundsMaxX.resize(m_entries.size());
+    m_boundsMaxY.resize(m_entries.size());
+    m_boundsMaxZ.resize(m_entries.size());
+
+    m_materialVersion = FuryMaterialManager::instance()->version();
+    m_shaderVersion = FuryShaderManager::instance()->version();
+    ++m_staticVersion;
+    m_dirty = false;
+}
+
+void FuryRenderList::resolve(ObjectRecord &_record)
+{
+    FuryMaterialManager* materialManager = FuryMaterialManager::instance();
+    FuryShaderManager* shaderManager = FuryShaderManager::instance();
+    FuryObject* obj = _record.object;
+
+    // Номер читается до названий: если их сменят позже, номер снова не совпадёт
+    _record.renderVersion = obj->renderVersion();
+    const QString materialName = obj->materialName();
+    const QString shaderName = obj->shaderName();
+
+    FuryMaterial* objMaterial = nullptr;
+    if (materialManager->materialExist(materialName))
+    {
+        objMaterial = materialManager->materialByName(materialName);
+    }
+
+    Shader* shader = nullptr;
+    if (shaderManager->containsShader(shaderName))
+    {
+        shader = shaderManager->shaderByName(shaderName);
+    }
+    else if (_record.entryCount > 0)
+    {
+        Debug(ru("[ ВНИМАНИЕ ] Менеджер шейдеров не содержит шейдер (%1) объекта (%2)")
+              .arg(shaderName, obj->objectName()));
+    }
+
+    for (int i = _record.firstEntry; i < _record.firstEntry + _record.entryCount; ++i)
+    {
+        Entry& entry = m_entries[i];
+        entry.material = objMaterial != nullptr ? objMaterial
+                                                : materialManager->materialByName(entry.mesh->materialName());
+        entry.shader = shader;
+        entry.sortKey = (stateId(m_shaderIds, entry.shader) << 48)
+                | (stateId(m_materialIds, entry.material) << 24)
+                | stateId(m_meshIds, entry.mesh);
+    }
+}
+
+quint64 FuryRenderList::stateId(QHash<const void *, quint64> &_ids, const void *_state)
+{
+    if (_state == nullptr)
+    {
+        return 0;
+    }
+
+    auto it = _ids.constFind(_state);
+    if (it != _ids.constEnd())
+    {
+        return it.value();
+    }
+
+    quint64 id = _ids.size() + 1;
+    _ids.insert(_state, id);
+    return id;
+}
+
+FuryRenderList::CullingStats FuryRenderList::cull(const FuryFrustum &_frustum, QVector<quint8> &_visible)
+{
+    for (ObjectRecord& record : m_records)
+    {
+        updateStatic(record);
+
+        if (record.boundsVersion != record.object->renderModelVersion())
+        {
+            updateBounds(record);
+
+            if (record.isStatic)
+            {
+                ++m_staticVersion;
+            }
+        }
+    }
+
+    _visible.resize(m_entries.size());
+
+    CullingStats stats;
+    stats.tested = m_entries.size();
+    stats.visible = _frustum.cullBoxes(m_boundsMinX.constData(), m_boundsMinY.constData(),
+                                       m_boundsMinZ.constData(), m_boundsMaxX.constData(),
+                                       m_boundsMaxY.constData(), m_boundsMaxZ.constData(),
+                                       m_entries.size(), _visible.data());
+    return stats;
+}
+
+void FuryRenderList::updateBounds(ObjectRecord &_record)
+{
+    const glm::mat4& objectMatrix = _record.object->renderModelMatrix();
+    _record.boundsVersion = _record.object->renderModelVersion();
+
+    for (int i = _record.firstEntry; i < _record.firstEntry + _record.entryCount; ++i)
+    {
+        const FuryMesh* mesh = m_entries[i].mesh;
+        glm::mat4 matrix = objectMatrix * mesh->transformation();
+
+        // Коробка после поворота: центр переносится матрицей, половины
+        // размеров - модулем её поворотной части
+        glm::vec3 center = glm::vec3(matrix * glm::vec4((mesh->minVertex() + mesh->maxVertex()) * 0.5f, 1.0f));
+        glm::vec3 halfSize = (mesh->maxVertex() - mesh->minVertex()) * 0.5f;
+        glm::mat3 absolute(glm::abs(glm::vec3(matrix[0])),
+                           glm::abs(glm::vec3(matrix[1])),
+                           glm::abs(glm::vec3(matrix[2])));
+        glm::vec3 extent = absolute * halfSize;
+
+        m_boundsMinX[i] = center.x - extent.x;
+        m_boundsMinY[i] = center.y - extent.y;
+        m_boundsMinZ[i] = center.z - extent.z;
+        m_boundsMaxX[i] = center.x + extent.x;
+        m_boundsMaxY[i] = center.y + extent.y;
+        m_boundsMaxZ[i] = center.z + extent.z;
+    }
+}
+
+void FuryRenderList::updateStatic(ObjectRecord &_record)
+{
+    FuryObject* obj = _record.object;
+    bool isStatic = obj->physicsBody() != nullptr
+            && obj->physicsBody()->getType() == rp3d::BodyType::STATIC;
+
+    if (isStatic == _record.isStatic && (!isStatic || obj->visible() == _record.visible))
+    {
+        return;
+    }
+
+    _record.isStatic = isStatic;
+    _record.visible = obj->visible();
+    ++m_staticVersion;
+
+    for (int i = _record.firstEntry; i < _record.firstEntry + _record.entryCount; ++i)
+    {
+        m_entries[i].isStatic = isStatic;
+    }
+}
@@ -0,0 +1,204 @@
+#ifndef FURYRENDERLIST_H
+#define FURYRENDERLIST_H
+
+#include <QHash>
+#include <QVector>
+
+class FuryFrustum;
+class FuryMesh;
+class FuryObject;
+class FuryMaterial;
+class FuryWorld;
+class Shader;
+
+
+/*!
+ * \brief Список отрисовки мира.
+ *
+ * Хранит плоский список (объект, меш, материал, шейдер) всех объектов мира,
+ * общий для прохода глубины, основного прохода и выделения в редакторе.
+ * Полностью пересобирается только при добавлении, удалении и смене родителя
+ * объектов и при смене модели объекта. Смена материала или шейдера объекта
+ * перечитывает только записи этого объекта, изменение набора материалов
+ * или шейдеров в менеджерах - только указатели всех записей.
+ *
+ * Видимость и прозрачность проверяются при отрисовке: они меняются без
+ * уведомлений.
+ *
+ * Для отсечения по пирамиде видимости хранятся границы записей в глобальных
+ * координатах, разложенные по массивам. Границы пересчитываются только
+ * у объектов, чья матрица модели изменилась с прошлого кадра.
+ *
+ * Записи объектов со статическими телами отмечаются для кэша теней, любое
+ * изменение среди них увеличивает staticVersion().
+ *
+ * Каждая запись хранит ключ сортировки по состоянию OpenGL: шейдер в старших
+ * битах, затем материал и меш. Очередь, отсортированная по ключу, меняет
+ * шейдер и материал только на границах групп.
+ */
+class FuryRenderList
+{
+public:
+    //! Запись списка отрисовки
+    struct Entry
+    {
+        //! Объект
+        FuryObject* object;
+        //! Меш модели объекта
+        FuryMesh* mesh;
+        //! Материал: материал объекта или, если его нет, материал меша
+        FuryMaterial* material;
+        //! Шейдер объекта. nullptr, если шейдера нет в менеджере
+        Shader* shader;
+        //! Отбрасывает ли меш тень
+        bool castsShadow;
+        //! Тело объекта статическое: меш рисуется в кэшированный слой теней
+        bool isStatic;
+        //! Ключ сортировки: 16 бит шейдера, 24 бита материала, 24 бита меша
+        quint64 sortKey;
+    };
+
+    //! Статистика отсечения
+    struct CullingStats
+    {
+        //! Проверено записей
+        int tested = 0;
+        //! Видимых записей
+        int visible = 0;
+    };
+
+    /*!
+     * \brief Конструктор
+     * \param[in] _world - Мир
+     */
+    explicit FuryRenderList(FuryWorld* _world);
+
+    //! Сброс списка. Он будет собран заново при следующем обновлении
+    inline void invalidate()
+    { m_dirty = true; }
+
+    //! Обновление списка перед кадром. Без изменений в мире почти ничего не делает
+    void update();
+
+    /*!
+     * \brief Получение записей списка
+     * \return Возвращает записи в порядке обхода дерева объектов
+     */
+    inline const QVector<Entry>& entries() const
+    { return m_entries; }
+
+    /*!
+     * \brief Получение объектов списка
+     * \return Возвращает все объекты мира в порядке обхода дерева
+     */
+    inline const QVector<FuryObject*>& objects() const
+    { return m_objects; }
+
+    /*!
+     * \brief Отсечение записей по пирамиде видимости. Перед проверкой
+     * обновляет границы сдвинувшихся объектов. Вызывается после update()
+     * \param[in] _frustum - Пирамида видимости
+     * \param[out] _visible - Признак видимости каждой записи
+     * \return Возвращает статистику отсечения
+     */
+    CullingStats cull(const FuryFrustum& _frustum, QVector<quint8>& _visible);
+
+    /*!
+     * \brief Получение номера изменения статических записей. Растёт при сборке
+     * списка, движении, смене видимости и типа тела статических объектов.
+     * Обновляется в cull()
+     * \return Возвращает номер изменения
+     */
+    inline quint32 staticVersion() const
+    { return m_staticVersion; }
+
+private:
+    //! Записи одного объекта
+    struct ObjectRecord
+    {
+        //! Объект
+        FuryObject* object;
+        //! Индекс первой записи объекта
+        int firstEntry;
+        //! Количество записей объекта
+        int entryCount;
+        //! Номер изменения материала и шейдера объекта
+        quint32 renderVersion;
+        //! Номер изменения модели объекта
+        quint32 modelVersion;
+        //! Номер изменения матрицы модели, по которому посчитаны границы
+        quint32 boundsVersion;
+        //! Тело объекта статическое
+        bool isStatic;
+        //! Видимость объекта при последнем отсечении
+        bool visible;
+    };
+
+    //! Полная сборка списка обходом дерева объектов
+    void rebuild();
+
+    /*!
+     * \brief Получение материала и шейдера для записей объекта
+     * \param[in] _record - Записи объекта
+     */
+    void resolve(ObjectRecord& _record);
+
+    /*!
+     * \brief Получение номера состояния для ключа сортировки
+     * \param[in,out] _ids - Выданные номера состояний
+     * \param[in] _state - Шейдер, материал или меш
+     * \return Возвращает номер, выданный при первой встрече состояния.
+     * 0 - состояния нет
+     */
+    static quint64 stateId(QHash<const void*, quint64>& _ids, const void* _state);
+
+    /*!
+     * \brief Пересчёт границ записей объекта в глобальных координатах
+     * \param[in] _record - Записи объекта
+     */
+    void updateBounds(ObjectRecord& _record);
+
+    /*!
+     * \brief Обновление признака статичности записей объекта
+     * \param[in] _record - Записи объекта
+     */
+    void updateStatic(ObjectRecord& _record);
+
+private:
+    //! Мир
+    FuryWorld* m_world;
+    //! Записи
+    QVector<Entry> m_entries;
+    //! Записи по объектам
+    QVector<ObjectRecord> m_records;
+    //! Объекты в порядке обхода дерева
+    QVector<FuryObject*> m_objects;
+    //! Минимальные x границ записей
+    QVector<float> m_boundsMinX;
+    //! Минимальные y границ записей
+    QVector<float> m_boundsMinY;
+    //! Минимальные z границ записей
+    QVector<float> m_boundsMinZ;
+    //! Максимальные x границ записей
+    QVector<float> m_boundsMaxX;
+    //! Максимальные y границ записей
+    QVector<float> m_boundsMaxY;
+    //! Максимальные z границ записей
+    QVector<float> m_boundsMaxZ;
+    //! Номера шейдеров для ключей сортировки
+    QHash<const void*, quint64> m_shaderIds;
+    //! Номера материалов для ключей сортировки
+    QHash<const void*, quint64> m_materialIds;
+    //! Номера мешей для ключей сортировки
+    QHash<const void*, quint64> m_meshIds;
+    //! Номер изменения набора материалов, по которому получены материалы
+    quint32 m_materialVersion;
+    //! Номер изменения набора шейдеров, по которому получены шейдеры
+    quint32 m_shaderVersion;
+    //! Номер изменения статических записей
+    quint32 m_staticVersion;
+    //! Список устарел
+    bool m_dirty;
+};
+
+#endif // FURYRENDERLIST_H
@@ -0,0 +1,301 @@
+#include "FuryShadowCascades.h"
+
+#include "Camera.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cmath>
+
+
+//! Запас окна каскада относительно радиуса: центр отрезка может сдвинуться
+//! на эту долю радиуса, прежде чем окно переедет
+static const float cacheSlack = 0.15f;
+//! Шаг округления радиуса каскада в метрах
+static const float radiusStep = 0.5f;
+//! Шаг округления азимута и высоты света в радианах (5 градусов). Пока
+//! округлённое направление не меняется, окна и статичный слой не перестраиваются
+static const float lightAngleStep = 0.0872665f;
+
+
+/*!
+ * \brief Округление направления света до сетки по азимуту и высоте
+ * \param[in] _direction - Нормализованное направление на свет
+ * \return Возвращает округлённое нормализованное направление
+ */
+static glm::vec3 quantizeLightDirection(const glm::vec3& _direction)
+{
+    float azimuth = std::atan2(_direction.z, _direction.x);
+    float elevation = std::asin(glm::clamp(_direction.y, -1.0f, 1.0f));
+
+    azimuth = std::round(azimuth / lightAngleStep) * lightAngleStep;
+    elevation = std::round(elevation / lightAngleStep) * lightAngleStep;
+
+    float horizontal = std::cos(elevation);
+    return glm::vec3(horizontal * std::cos(azimuth),
+                     std::sin(elevation),
+                     horizontal * std::sin(azimuth));
+}
+
+
+FuryShadowCascades::FuryShadowCascades() :
+    m_cascadeCount(3),
+    m_near(0.1f),
+    m_far(70.0f),
+    m_firstSplit(25.0f),
+    m_casterDistance(37.0f),
+    m_lightDirection(0.0f)
+{
+    m_cascades[0].resolution = 4096;
+    m_cascades[1].resolution = 2048;
+    m_cascades[2].resolution = 1024;
+    m_cascades[3].resolution = 1024;
+}
+
+FuryShadowCascades::~FuryShadowCascades()
+{
+    for (Cascade& cascade : m_cascades)
+    {
+        deleteBuffers(cascade);
+    }
+}
+
+void FuryShadowCascades::setCascadeCount(int _count)
+{
+    _count = qBound(1, _count, maxCascades);
+
+    if (_count == m_cascadeCount)
+    {
+        return;
+    }
+
+    m_cascadeCount = _count;
+
+    // Границы всех каскадов сдвигаются
+    for (Cascade& cascade : m_cascades)
+    {
+        cascade.windowDirty = true;
+    }
+}
+
+void FuryShadowCascades::setResolution(int _cascade, int _resolution)
+{
+    if (_cascade < 0 || _cascade >= maxCascades || _resolution <= 0)
+    {
+        return;
+    }
+
+    m_cascades[_cascade].resolution = _resolution;
+}
+
+void FuryShadowCascades::setRange(float _near, float _far, float _firstSplit, float _casterDistance)
+{
+    if (_near == m_near && _far == m_far && _firstSplit == m_firstSplit
+            && _casterDistance == m_casterDistance)
+    {
+        return;
+    }
+
+    m_near = _near;
+    m_far = _far;
+    m_firstSplit = _firstSplit;
+    m_casterDistance = _casterDistance;
+
+    for (Cascade& cascade : m_cascades)
+    {
+        cascade.windowDirty = true;
+    }
+}
+
+void FuryShadowCascades::update(Camera *_camera, float _aspect, const glm::vec3 &_dirLightPosition)
+{
+    // Свет в сцене может двигаться каждый кадр: тени следуют за ним шагами,
+    // иначе статичный слой перерисовывался бы почти в каждом кадре
+    glm::vec3 lightDirection = quantizeLightDirection(glm::normalize(_dirLightPosition));
+
+    if (lightDirection != m_lightDirection)
+    {
+        m_lightDirection = lightDirection;
+
+        for (Cascade& cascade : m_cascades)
+        {
+            cascade.windowDirty = true;
+        }
+    }
+
+    float shadowNear = qMax(m_near, 0.01f);
+    float shadowFar = qMax(m_far, shadowNear + 1.0f);
+    float firstSplit = qBound(shadowNear + 0.5f, m_firstSplit, shadowFar);
+
+    glm::vec3 front = _camera->front();
+    glm::vec3 right = glm::normalize(glm::cross(front, glm::vec3(0.0f, 1.0f, 0.0f)));
+    glm::vec3 up = glm::cross(right, front);
+    float tanHeight = std::tan(glm::radians(_camera->zoom()) * 0.5f);
+    float tanWidth = tanHeight * _aspect;
+
+    float splitNear = shadowNear;
+
+    for (int i = 0; i < m_cascadeCount; ++i)
+    {
+        Cascade& cascade = m_cascades[i];
+
+        // Первый каскад - ближние метры, остальные делят дальность логарифмически
+        if (m_cascadeCount == 1)
+        {
+            cascade.splitFar = shadowFar;
+        }
+        else if (i == 0)
+        {
+            cascade.splitFar = firstSplit;
+        }
+        else
+        {
+            cascade.splitFar = firstSplit * std::pow(shadowFar / firstSplit,
+                                                     float(i) / float(m_cascadeCount - 1));
+        }
+
+        glm::vec3 corners[8];
+        float distances[2] = {splitNear, cascade.splitFar};
+
+        for (int d = 0; d < 2; ++d)
+        {
+            glm::vec3 center = _camera->position() + front * distances[d];
+            glm::vec3 toRight = right * (distances[d] * tanWidth);
+            glm::vec3 toUp = up * (distances[d] * tanHeight);
+
+            corners[d * 4 + 0] = center - toRight - toUp;
+            corners[d * 4 + 1] = center + toRight - toUp;
+            corners[d * 4 + 2] = center - toRight + toUp;
+            corners[d * 4 + 3] = center + toRight + toUp;
+        }
+
+        updateBuffers(cascade);
+        fitWindow(cascade, corners, lightDirection);
+
+        splitNear = cascade.splitFar;
+    }
+
+    // Карты выключенных каскадов не держат видеопамять
+    for (int i = m_cascadeCount; i < maxCascades; ++i)
+    {
+        deleteBuffers(m_cascades[i]);
+    }
+}
+
+void FuryShadowCascades::markStaticDrawn(int _cascade, quint32 _staticVersion)
+{
+    m_cascades[_cascade].staticVersion = _staticVersion;
+    m_cascades[_cascade].staticValid = true;
+}
+
+void FuryShadowCascades::createDepthMap(int _resolution, GLuint *_depthMapFBO, GLuint *_depthMap)
+{
+    // Создадим буфер глубины для теней
+    glGenFramebuffers(1, _depthMapFBO);
+
+    // Создадим текстуру для буфера
+    glGenTextures(1, _depthMap);
+    glBindTexture(GL_TEXTURE_2D, *_depthMap);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, _resolution, _resolution, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+    float borderColor[] = { 1.0f, 1.0f, 1.0f, 1.0f };
+    glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, *_depthMapFBO);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, *_depthMap, 0);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void FuryShadowCascades::updateBuffers(Cascade &_cascade)
+{
+    if (_cascade.bufferResolution == _cascade.resolution)
+    {
+        return;
+    }
+
+    deleteBuffers(_cascade);
+
+    createDepthMap(_cascade.resolution, &_cascade.depthMapFBO, &_cascade.depthMap);
+    createDepthMap(_cascade.resolution, &_cascade.staticDepthMapFBO, &_cascade.staticDepthMap);
+    _cascade.bufferResolution = _cascade.resolution;
+
+    // Привязка к сетке текселей зависит от размера карты
+    _cascade.windowDirty = true;
+}
+
+void FuryShadowCascades::deleteBuffers(Cascade &_cascade)
+{
+    if (_cascade.bufferResolution == 0)
+    {
+        return;
+    }
+
+    glDeleteFramebuffers(1, &_cascade.depthMapFBO);
+    glDeleteTextures(1, &_cascade.depthMap);
+    glDeleteFramebuffers(1, &_cascade.staticDepthMapFBO);
+    glDeleteTextures(1, &_cascade.staticDepthMap);
+
+    _cascade.depthMapFBO = 0;
+    _cascade.depthMap = 0;
+    _cascade.staticDepthMapFBO = 0;
+    _cascade.staticDepthMap = 0;
+    _cascade.bufferResolution = 0;
+    _cascade.staticValid = false;
+}
+
+void FuryShadowCascades::fitWindow(Cascade &_cascade, const glm::vec3 *_corners, const glm::vec3 &_lightDirection)
+{
+    // Углы отрезка жёстко связаны с камерой: сфера вокруг них не меняет
+    // радиус при повороте камеры, округление убирает ошибки вычислений
+    glm::vec3 center(0.0f);
+    for (int i = 0; i < 8; ++i)
+    {
+        center += _corners[i];
+    }
+    center /= 8.0f;
+
+    float radius = 0;
+    for (int i = 0; i < 8; ++i)
+    {
+        radius = qMax(radius, glm::length(_corners[i] - center));
+    }
+    radius = std::ceil(radius / radiusStep) * radiusStep;
+
+    if (!_cascade.windowDirty && radius == _cascade.radius
+            && glm::length(center - _cascade.center) <= radius * cacheSlack)
+    {
+        return;
+    }
+
+    _cascade.windowDirty = false;
+    _cascade.center = center;
+    _cascade.radius = radius;
+    _cascade.staticValid = false;
+
+    float halfSize = radius * (1.0f + cacheSlack);
+    glm::vec3 lightUp = std::abs(_lightDirection.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f)
+                                                             : glm::vec3(0.0f, 1.0f, 0.0f);
+
+    glm::mat4 lightView = glm::lookAt(center + _lightDirection * (halfSize + m_casterDistance),
+                                      center,
+                                      lightUp);
+    glm::mat4 lightProjection = glm::ortho(-halfSize, halfSize,
+                                           -halfSize, halfSize,
+                                           0.0f, 2.0f * halfSize + m_casterDistance);
+
+    // Начало координат мира попадает точно в тексель: при переезде окна
+    // тексели ложатся на те же места сцены и края теней не дрожат
+    glm::mat4 lightSpaceMatrix = lightProjection * lightView;
+    float texelsPerUnit = _cascade.resolution * 0.5f;
+    glm::vec2 origin = glm::vec2(lightSpaceMatrix * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f)) * texelsPerUnit;
+    glm::vec2 offset = (glm::round(origin) - origin) / texelsPerUnit;
+
+    lightProjection[3][0] += offset.x;
+    lightProjection[3][1] += offset.y;
+
+    _cascade.lightSpaceMatrix = lightProjection * lightView;
+}
@@ -0,0 +1,204 @@
+#ifndef FURYSHADOWCASCADES_H
+#define FURYSHADOWCASCADES_H
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <QtGlobal>
+
+class Camera;
+
+
+/*!
+ * \brief Каскадные карты теней направленного света.
+ *
+ * Дальность теней камеры делится на каскады: первый покрывает ближние
+ * метры до firstSplit, остальные делят оставшееся расстояние
+ * логарифмически. Каждый каскад описан сферой вокруг своего отрезка
+ * пирамиды камеры, поэтому размер его окна не зависит от поворота камеры,
+ * а матрица привязывается к сетке текселей - тени не дрожат при движении.
+ *
+ * Окно каскада сдвигается, только когда центр отрезка уходит дальше
+ * запаса cacheSlack от радиуса. Пока окно стоит, слой статических теней
+ * каскада не перерисовывается.
+ *
+ * Размер карты задаётся для каждого каскада отдельно. Буферы OpenGL
+ * создаются и пересоздаются при первом update() после смены размера,
+ * поэтому update() вызывается при текущем контексте.
+ */
+class FuryShadowCascades
+{
+public:
+    //! Наибольшее количество каскадов
+    static constexpr int maxCascades = 4;
+
+    //! Конструктор трёх каскадов 4096, 2048 и 1024
+    FuryShadowCascades();
+    //! Деструктор. Вызывается при текущем контексте OpenGL
+    ~FuryShadowCascades();
+
+    /*!
+     * \brief Установка количества каскадов
+     * \param[in] _count - Количество каскадов [1; maxCascades]
+     */
+    void setCascadeCount(int _count);
+
+    /*!
+     * \brief Получение количества каскадов
+     * \return Возвращает количество каскадов
+     */
+    inline int cascadeCount() const
+    { return m_cascadeCount; }
+
+    /*!
+     * \brief Установка размера карты каскада
+     * \param[in] _cascade - Номер каскада
+     * \param[in] _resolution - Ширина и высота карты в текселях
+     */
+    void setResolution(int _cascade, int _resolution);
+
+    /*!
+     * \brief Получение размера карты каскада
+     * \param[in] _cascade - Номер каскада
+     * \return Возвращает ширину и высоту карты в текселях
+     */
+    inline int resolution(int _cascade) const
+    { return m_cascades[_cascade].resolution; }
+
+    /*!
+     * \brief Установка дальности теней
+     * \param[in] _near - Расстояние от камеры, с которого начинаются тени
+     * \param[in] _far - Расстояние от камеры, на котором тени заканчиваются
+     * \param[in] _firstSplit - Дальняя граница первого, самого чёткого каскада
+     * \param[in] _casterDistance - Запас глубины в сторону света для тел
+     * вне пирамиды камеры, отбрасывающих в неё тень
+     */
+    void setRange(float _near, float _far, float _firstSplit, float _casterDistance);
+
+    /*!
+     * \brief Подгонка каскадов под пирамиду камеры и создание буферов
+     * \param[in] _camera - Камера
+     * \param[in] _aspect - Отношение ширины кадра к высоте
+     * \param[in] _dirLightPosition - Направление на свет. Для теней округляется до шага 5 градусов
+     */
+    void update(Camera* _camera, float _aspect, const glm::vec3& _dirLightPosition);
+
+    /*!
+     * \brief Проверка, нужно ли перерисовать слой статических теней каскада
+     * \param[in] _cascade - Номер каскада
+     * \param[in] _staticVersion - Номер изменения статических записей списка отрисовки
+     * \return Возвращает признак необходимости перерисовки
+     */
+    inline bool needStaticRedraw(int _cascade, quint32 _staticVersion) const
+    { return !m_cascades[_cascade].staticValid || m_cascades[_cascade].staticVersion != _staticVersion; }
+
+    /*!
+     * \brief Отметка о перерисовке слоя статических теней каскада
+     * \param[in] _cascade - Номер каскада
+     * \param[in] _staticVersion - Номер изменения статических записей списка отрисовки
+     */
+    void markStaticDrawn(int _cascade, quint32 _staticVersion);
+
+    /*!
+     * \brief Получение матрицы пространства теней каскада
+     * \param[in] _cascade - Номер каскада
+     * \return Возвращает произведение матриц проекции и вида света
+     */
+    inline const glm::mat4& lightSpaceMatrix(int _cascade) const
+    { return m_cascades[_cascade].lightSpaceMatrix; }
+
+    /*!
+     * \brief Получение дальней границы каскада
+     * \param[in] _cascade - Номер каскада
+     * \return Возвращает расстояние от камеры вдоль её направления
+     */
+    inline float splitFar(int _cascade) const
+    { return m_cascades[_cascade].splitFar; }
+
+    inline GLuint depthMapFBO(int _cascade) const
+    { return m_cascades[_cascade].depthMapFBO; }
+
+    inline GLuint depthMap(int _cascade) const
+    { return m_cascades[_cascade].depthMap; }
+
+    inline GLuint staticDepthMapFBO(int _cascade) const
+    { return m_cascades[_cascade].staticDepthMapFBO; }
+
+private:
+    //! Каскад
+    struct Cascade
+    {
+        //! Заданный размер карты
+        int resolution = 0;
+        //! Размер созданных буферов. 0 - буферов нет
+        int bufferResolution = 0;
+        //! Буфер карты теней
+        GLuint depthMapFBO = 0;
+        //! Текстура карты теней
+        GLuint depthMap = 0;
+        //! Буфер слоя статических теней
+        GLuint staticDepthMapFBO = 0;
+        //! Текстура слоя статических теней
+        GLuint staticDepthMap = 0;
+        //! Матрица пространства теней
+        glm::mat4 lightSpaceMatrix = glm::mat4(1.0f);
+        //! Центр окна каскада
+        glm::vec3 center = glm::vec3(0.0f);
+        //! Радиус сферы отрезка пирамиды камеры
+        float radius = 0;
+        //! Дальняя граница каскада
+        float splitFar = 0;
+        //! Окно каскада ещё не строилось или устарело
+        bool windowDirty = true;
+        //! Слой статических теней соответствует окну
+        bool staticValid = false;
+        //! Номер изменения статических записей в слое
+        quint32 staticVersion = 0;
+    };
+
+    /*!
+     * \brief Создание карты глубины
+     * \param[in] _resolution - Ширина и высота карты
+     * \param[out] _depthMapFBO - Буфер глубины
+     * \param[out] _depthMap - Текстура буфера
+     */
+    static void createDepthMap(int _resolution, GLuint* _depthMapFBO, GLuint* _depthMap);
+
+    /*!
+     * \brief Пересоздание буферов каскада под заданный размер
+     * \param[in] _cascade - Каскад
+     */
+    void updateBuffers(Cascade& _cascade);
+
+    /*!
+     * \brief Удаление буферов каскада
+     * \param[in] _cascade - Каскад
+     */
+    void deleteBuffers(Cascade& _cascade);
+
+    /*!
+     * \brief Подгонка окна каскада под отрезок пирамиды камеры
+     * \param[in] _cascade - Каскад
+     * \param[in] _corners - 8 углов отрезка пирамиды камеры
+     * \param[in] _lightDirection - Нормированное направление на свет
+     */
+    void fitWindow(Cascade& _cascade, const glm::vec3* _corners, const glm::vec3& _lightDirection);
+
+private:
+    //! Каскады
+    Cascade m_cascades[maxCascades];
+    //! Количество каскадов
+    int m_cascadeCount;
+    //! Начало теней от камеры
+    float m_near;
+    //! Конец теней от камеры
+    float m_far;
+    //! Дальняя граница первого каскада
+    float m_firstSplit;
+    //! Запас глубины в сторону света
+    float m_casterDistance;
+    //! Направление на свет, по которому построены окна
+    glm::vec3 m_lightDirection;
+};
+
+#endif // FURYSHADOWCASCADES_H
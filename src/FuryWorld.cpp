@@ -1,16 +1,15 @@
 #include "FuryWorld.h"
 
 #include "Camera.h"
-#include "FuryMesh.h"
-#include "FuryModel.h"
 #include "FuryObject.h"
-#include "FuryModelCache.h"
 #include "Logger/FuryLogger.h"
 #include "FuryPbrMaterial.h"
 #include "Managers/FuryTextureManager.h"
 #include "Managers/FuryMaterialManager.h"
-#include "Widgets/FuryRenderer.h"
 #include "FuryObjectsFactory.h"
+#include "FuryRenderList.h"
+#include "Physics/FuryRaySensor.h"
+#include "Physics/FuryVehicleSystem.h"
 
 #include <reactphysics3d/reactphysics3d.h>
 
@@ -24,19 +23,23 @@
 FuryWorld::FuryWorld(reactphysics3d::PhysicsCommon *_physicsCommon) :
     QObject(nullptr),
     m_physicsCommon(_physicsCommon),
+    m_trackBody(nullptr),
     m_currentCamera(nullptr),
+    m_objectsVersion(0),
+    m_updateListsDirty(true),
     m_started(true),
     m_dirLightPosition(glm::vec3(10, 10, -10)),
     m_envCubemap(0),
     m_irradianceMap(0),
     m_prefilterMap(0),
     m_brdfLUTTexture(0),
-    m_shadowMapEnabled(false),
-    m_depthMapFBO(0),
-    m_depthMap(0)
+    m_shadowCascades(nullptr)
 {
     Debug(ru("Создание игрового мира"));
     m_physicsWorld = m_physicsCommon->createPhysicsWorld();
+    m_raySensor = new FuryRaySensor(this);
+    m_vehicleSystem = new FuryVehicleSystem(this);
+    m_renderList = new FuryRenderList(this);
 
     initConnections();
 }
@@ -53,7 +56,21 @@ FuryWorld::~FuryWorld()
         }
     }
 
+    delete m_vehicleSystem;
+    m_vehicleSystem = nullptr;
+
+    delete m_renderList;
+    m_renderList = nullptr;
+
+    delete m_raySensor;
+    m_raySensor = nullptr;
+
     m_physicsCommon->destroyPhysicsWorld(m_physicsWorld);
+
+    for (rp3d::BoxShape* shape : m_boxShapes)
+    {
+        m_physicsCommon->destroyBoxShape(shape);
+    }
 }
 
 void FuryWorld::tick(double _dt)
@@ -62,15 +79,22 @@ void FuryWorld::tick(double _dt)
     {
         m_physicsWorld->update(_dt);
 
-        for (FuryObject* object : m_objects)
+        if (m_updateListsDirty)
+        {
+            rebuildUpdateLists();
+        }
+
+        for (FuryObject* object : m_dynamicObjects)
         {
             object->postPhysics();
         }
 
-        for (FuryObject* object : m_objects)
+        for (FuryObject* object : m_tickObjects)
         {
             object->tick(_dt);
         }
+
+        m_vehicleSystem->tick(_dt);
     }
 }
 
@@ -85,15 +109,55 @@ void FuryWorld::resetWorld()
 void FuryWorld::addRootObject(FuryObject* _object)
 {
     m_objects.push_back(_object);
+    m_updateListsDirty = true;
+    m_renderList->invalidate();
 }
 
 void FuryWorld::addObject(FuryObject *_object)
 {
     m_allObjects.append(_object);
+    ++m_objectsVersion;
+    m_updateListsDirty = true;
+    m_raySensor->invalidate();
+    m_renderList->invalidate();
     connect(_object, &FuryObject::parentChangedSignal,
             this, &FuryWorld::parentChangedSlot);
 }
 
+void FuryWorld::removeObject(FuryObject *_object)
+{
+    m_allObjects.removeOne(_object);
+    ++m_objectsVersion;
+    m_dynamicObjects.removeOne(_object);
+    m_tickObjects.removeOne(_object);
+    m_raySensor->invalidate();
+    m_renderList->invalidate();
+}
+
+void FuryWorld::rebuildUpdateLists()
+{
+    m_dynamicObjects.clear();
+    m_tickObjects.clear();
+
+    for (FuryObject* object : m_allObjects)
+    {
+        if (object->physicsBody()->getType() != rp3d::BodyType::STATIC)
+        {
+            m_dynamicObjects.append(object);
+        }
+    }
+
+    for (FuryObject* object : m_objects)
+    {
+        if (object->hasTick())
+        {
+            m_tickObjects.append(object);
+        }
+    }
+
+    m_updateListsDirty = false;
+}
+
 void FuryWorld::setCamera(Camera* _camera)
 {
     m_currentCamera = _camera;
@@ -243,18 +307,13 @@ void FuryWorld::createTextures()
     manager->addTexture("textures/smoke_ver2.png", "smoke_ver2");
 }
 
-void FuryWorld::createPbrCubemap(const QString &_cubemapHdrName)
-{
-    FuryRenderer* renderer = FuryRenderer::instance();
-    renderer->createPBRTextures(_cubemapHdrName, &m_envCubemap,
-                                &m_irradianceMap, &m_prefilterMap, &m_brdfLUTTexture);
-}
-
-void FuryWorld::createDepthMap()
+void FuryWorld::setPbrCubemap(GLuint _envCubemap, GLuint _irradianceMap,
+                              GLuint _prefilterMap, GLuint _brdfLUTTexture)
 {
-    FuryRenderer* renderer = FuryRenderer::instance();
-    renderer->createDepthMap(&m_depthMapFBO, &m_depthMap);
-    m_shadowMapEnabled = true;
+    m_envCubemap = _envCubemap;
+    m_irradianceMap = _irradianceMap;
+    m_prefilterMap = _prefilterMap;
+    m_brdfLUTTexture = _brdfLUTTexture;
 }
 
 void FuryWorld::save()
@@ -270,6 +329,7 @@ void FuryWorld::save()
     }
 
     world["objects"] = objects;
+    world["ghostCars"] = m_vehicleSystem->ghostMode();
 
     QJsonDocument document(world);
     QFile file("scene/testWorld.json");
@@ -294,6 +354,7 @@ void FuryWorld::load()
         QJsonObject world = doc.object();
 
         qDebug() << "load world" << world["name"].toString();
+        m_vehicleSystem->setGhostMode(world["ghostCars"].toBool());
 
         QJsonArray objects = world["objects"].toArray();
         FuryObjectsFactory* factory = FuryObjectsFactory::instance();
@@ -305,77 +366,126 @@ void FuryWorld::load()
             addRootObject(object);
         }
     }
-}
 
-void FuryWorld::parentChangedSlot()
-{
-    FuryObject* obj = qobject_cast<FuryObject*>(sender());
-    emit parentChangedSignal(obj);
+    buildTriggerIndex();
+    mergeStaticTrack();
+    m_raySensor->invalidate();
 }
 
-void FuryWorld::fillDrawComponents(QVector<QPair<FuryObject *, FuryMesh *> > &_solidComponents,
-                                   QVector<QPair<FuryObject *, FuryMesh *> > &_transparentComponents)
+void FuryWorld::buildTriggerIndex()
 {
-    FuryMaterialManager* materialManager = FuryMaterialManager::instance();
+    const QString triggerPrefix("Trigger ");
+    m_triggers.clear();
 
+    for (FuryObject* object : m_allObjects)
+    {
+        bool ok = false;
+        int number = -1;
 
-    QVector<FuryObject*> testWorldObjects = getRootObjects();
+        if (object->objectName().startsWith(triggerPrefix))
+        {
+            number = object->objectName().mid(triggerPrefix.size()).toInt(&ok);
+        }
 
-    for (int i = 0; i < testWorldObjects.size(); ++i)
-    {
-        FuryObject* obj = testWorldObjects[i];
-        foreach (QObject* child, obj->children())
+        if (ok && number >= 0)
         {
-            FuryObject* obj = qobject_cast<FuryObject*>(child);
-            if (obj != nullptr)
+            object->setObjectTag(FuryObject::TagTrigger, number);
+            object->setCollisionCategory(FuryObject::CategoryTrigger);
+
+            if (number >= m_triggers.size())
             {
-                testWorldObjects.append(obj);
+                m_triggers.resize(number + 1, nullptr);
             }
+
+            m_triggers[number] = object;
+        }
+        else if (object->objectTag() == FuryObject::TagTrigger)
+        {
+            object->setObjectTag(FuryObject::TagNone);
         }
+    }
+
+    Debug(ru("Триггеров трассы в мире (%1): %2").arg(objectName()).arg(m_triggers.size()));
+}
+
+void FuryWorld::mergeStaticTrack()
+{
+    int mergedCount = 0;
+
+    for (FuryObject* object : m_allObjects)
+    {
+        rp3d::RigidBody* body = object->physicsBody();
 
-        if (!obj->visible())
+        // Тела в иерархии могут держать соединения, их не трогаем
+        bool hasHierarchy = qobject_cast<FuryObject*>(object->parent()) != nullptr
+                || object->findChild<FuryObject*>(QString(), Qt::FindDirectChildrenOnly) != nullptr;
+
+        if (body->getType() != rp3d::BodyType::STATIC
+                || body->getNbColliders() != 1
+                || object->collisionCategory() != FuryObject::CategoryTrack
+                || object->mergedCollider() != nullptr
+                || hasHierarchy)
         {
             continue;
         }
 
-        const FuryModel& model = obj->modelCache()->model();
-        FuryPbrMaterial* objMat = nullptr;
-        if (materialManager->materialExist(obj->materialName()))
+        rp3d::Collider* collider = body->getCollider(0);
+
+        if (collider->getIsTrigger())
         {
-            objMat = dynamic_cast<FuryPbrMaterial*>(materialManager->materialByName(obj->materialName()));
+            continue;
         }
 
-        foreach (FuryMesh* mesh, model.meshes())
+        if (m_trackBody == nullptr)
         {
-            float opacity = 1;
+            m_trackBody = m_physicsWorld->createRigidBody(rp3d::Transform::identity());
+            m_trackBody->setType(rp3d::BodyType::STATIC);
+        }
 
-            if (objMat == nullptr)
-            {
-                FuryMaterial* material = materialManager->materialByName(mesh->materialName());
-                if (FuryPbrMaterial* pbr = dynamic_cast<FuryPbrMaterial*>(material); pbr != nullptr)
-                {
-                    opacity = pbr->opacity();
-                }
-                else if (material != nullptr)
-                {
-                    opacity = material->opacity();
-                }
-            }
-            else
-            {
-                opacity = objMat->opacity();
-            }
+        rp3d::Transform localTransform = collider->getLocalToBodyTransform();
+        rp3d::Collider* merged = m_trackBody->addCollider(collider->getCollisionShape(),
+                                                          body->getTransform() * localTransform);
+        merged->setMaterial(collider->getMaterial());
+        merged->setCollisionCategoryBits(collider->getCollisionCategoryBits());
+        merged->setCollideWithMaskBits(collider->getCollideWithMaskBits());
+        merged->setUserData(object);
 
-            if (opacity >= 0.95)
-            {
-                _solidComponents.append(qMakePair(obj, mesh));
-            }
-            else
-            {
-                _transparentComponents.append(qMakePair(obj, mesh));
-            }
+        body->removeCollider(collider);
+        body->setIsActive(false);
+        object->setMergedCollider(merged, localTransform);
+
+        ++mergedCount;
+    }
+
+    if (mergedCount > 0)
+    {
+        m_raySensor->invalidate();
+    }
+
+    Debug(ru("Статических объектов трассы объединено в мире (%1): %2; форм коробок: %3")
+          .arg(objectName()).arg(mergedCount).arg(m_boxShapes.size()));
+}
+
+rp3d::BoxShape *FuryWorld::boxShape(const reactphysics3d::Vector3 &_halfExtents)
+{
+    for (rp3d::BoxShape* shape : m_boxShapes)
+    {
+        if (shape->getHalfExtents() == _halfExtents)
+        {
+            return shape;
         }
     }
+
+    rp3d::BoxShape* shape = m_physicsCommon->createBoxShape(_halfExtents);
+    m_boxShapes.append(shape);
+    return shape;
+}
+
+void FuryWorld::parentChangedSlot()
+{
+    FuryObject* obj = qobject_cast<FuryObject*>(sender());
+    m_renderList->invalidate();
+    emit parentChangedSignal(obj);
 }
 
 void FuryWorld::initConnections()
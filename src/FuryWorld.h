@@ -11,13 +11,19 @@
 #include <QObject>
 
 class Camera;
-class FuryMesh;
 class FuryObject;
+class FuryRaySensor;
+class FuryRenderList;
+class FuryShadowCascades;
+class FuryVehicleSystem;
 
 namespace reactphysics3d
 {
     class PhysicsCommon;
     class PhysicsWorld;
+    class RigidBody;
+    class BoxShape;
+    struct Vector3;
 }
 
 
@@ -64,6 +70,16 @@ public:
      */
     void addObject(FuryObject* _object);
 
+    /*!
+     * \brief Удаление объекта из списков мира. Вызывается из деструктора объекта
+     * \param[in] _object - Объект
+     */
+    void removeObject(FuryObject* _object);
+
+    //! Пересборка списков обновления в следующем тике. Вызывается при смене типа тела
+    inline void invalidateUpdateLists()
+    { m_updateListsDirty = true; }
+
     /*!
      * \brief Установка камеры
      * \param[in] _camera - Камера
@@ -85,6 +101,57 @@ public:
      */
     const QVector<FuryObject*>& getAllObjects();
 
+    /*!
+     * \brief Получение номера изменения списка всех объектов
+     * \return Возвращает номер, который растёт при добавлении и удалении объектов
+     */
+    inline quint32 objectsVersion() const
+    { return m_objectsVersion; }
+
+    /*!
+     * \brief Получение триггера трассы по номеру
+     * \param[in] _number - Номер триггера
+     * \return Возвращает триггер или nullptr, если его нет
+     */
+    inline FuryObject* triggerByNumber(int _number) const
+    { return (_number >= 0 && _number < m_triggers.size()) ? m_triggers[_number] : nullptr; }
+
+    /*!
+     * \brief Получение количества номеров триггеров трассы
+     * \return Возвращает наибольший номер триггера + 1
+     */
+    inline int triggerCount() const
+    { return m_triggers.size(); }
+
+    /*!
+     * \brief Построение реестра триггеров трассы. Объекты "Trigger N" получают
+     * метку триггера с номером N. Вызывается после загрузки мира.
+     */
+    void buildTriggerIndex();
+
+    /*!
+     * \brief Объединение статической геометрии трассы. Коллайдеры статических
+     * объектов категории трассы переносятся в одно статическое тело, а тела
+     * объектов выключаются. Дерево широкой фазы и список тел, которые обходят
+     * шаг физики и лучи, становятся меньше. Вызывается после загрузки мира.
+     */
+    void mergeStaticTrack();
+
+    /*!
+     * \brief Получение общего тела статической геометрии трассы
+     * \return Возвращает тело или nullptr, если трасса ещё не объединена
+     */
+    inline reactphysics3d::RigidBody* trackBody() const
+    { return m_trackBody; }
+
+    /*!
+     * \brief Получение формы коробки. Одинаковые формы создаются один раз
+     * на мир и удаляются вместе с ним
+     * \param[in] _halfExtents - Половины размеров коробки
+     * \return Возвращает форму коробки
+     */
+    reactphysics3d::BoxShape* boxShape(const reactphysics3d::Vector3& _halfExtents);
+
     /*!
      * \brief Получение текущей камеры
      * \return Возврашает текущую камеру
@@ -106,30 +173,54 @@ public:
     inline reactphysics3d::PhysicsWorld* physicsWorld() const
     { return m_physicsWorld; }
 
+    /*!
+     * \brief Получение пакетного датчика лучей
+     * \return Возвращает пакетный датчик лучей мира
+     */
+    inline FuryRaySensor* raySensor() const
+    { return m_raySensor; }
+
+    /*!
+     * \brief Получение подвески и шин машин мира
+     * \return Возвращает систему машин мира
+     */
+    inline FuryVehicleSystem* vehicleSystem() const
+    { return m_vehicleSystem; }
+
+    /*!
+     * \brief Получение списка отрисовки
+     * \return Возвращает список отрисовки мира
+     */
+    inline FuryRenderList* renderList() const
+    { return m_renderList; }
+
     //! Создание материалов
     void createMaterials();
     //! Создание текстур
     void createTextures();
 
-    //! Создание окружения для pbr
-    void createPbrCubemap(const QString& _cubemapHdrName);
+    /*!
+     * \brief Установка текстур окружения для pbr
+     * \param[in] _envCubemap - Текстура окружения
+     * \param[in] _irradianceMap - Карта освещенности
+     * \param[in] _prefilterMap - Карта предварительной фильтрации
+     * \param[in] _brdfLUTTexture - Текстура brdfLUT
+     */
+    void setPbrCubemap(GLuint _envCubemap, GLuint _irradianceMap,
+                       GLuint _prefilterMap, GLuint _brdfLUTTexture);
 
-    //! Создать карту теней
-    void createDepthMap();
+    /*!
+     * \brief Установка каскадных карт теней. Мир не владеет каскадами
+     * \param[in] _shadowCascades - Каскады теней. nullptr - мир без теней
+     */
+    inline void setShadowCascades(FuryShadowCascades* _shadowCascades)
+    { m_shadowCascades = _shadowCascades; }
 
     //! Сохранение мира в JSON
     void save();
     //! Загрузка мира из JSON
     void load();
 
-    /*!
-     * \brief Заполнение компонент для отрисовки
-     * \param[out] _solidComponents - Непрозрачный компоненты
-     * \param[out] _transparentComponents - Прозрачные компоненты
-     */
-    void fillDrawComponents(QVector<QPair<FuryObject*, FuryMesh*>>& _solidComponents,
-                            QVector<QPair<FuryObject*, FuryMesh*>>& _transparentComponents);
-
     /*!
      * \brief Позиция направленного света
      * \return Возвращает позицию направленного света
@@ -150,13 +241,10 @@ public:
     { return m_brdfLUTTexture; }
 
     inline bool shadowMapEnabled() const
-    { return m_shadowMapEnabled; }
-
-    inline GLuint depthMapFBO() const
-    { return m_depthMapFBO; }
+    { return m_shadowCascades != nullptr; }
 
-    inline GLuint depthMap() const
-    { return m_depthMap; }
+    inline FuryShadowCascades* shadowCascades() const
+    { return m_shadowCascades; }
 
 signals:
     /*!
@@ -179,11 +267,24 @@ private:
     //! Инициализация соединений сигналов и слотов
     void initConnections();
 
+    //! Сборка списков нестатических тел и объектов с tick
+    void rebuildUpdateLists();
+
 private:
     //! Главный объект физики, к которому принадлежит мир
     reactphysics3d::PhysicsCommon* m_physicsCommon;
     //! Физический мир
     reactphysics3d::PhysicsWorld* m_physicsWorld;
+    //! Пакетный датчик лучей
+    FuryRaySensor* m_raySensor;
+    //! Подвеска и шины машин
+    FuryVehicleSystem* m_vehicleSystem;
+    //! Список отрисовки
+    FuryRenderList* m_renderList;
+    //! Общее тело статической геометрии трассы
+    reactphysics3d::RigidBody* m_trackBody;
+    //! Формы коробок без повторов
+    QVector<reactphysics3d::BoxShape*> m_boxShapes;
 
     //! Текущая камера
     Camera* m_currentCamera;
@@ -191,6 +292,16 @@ private:
     QVector<FuryObject*> m_objects;
     //! Список всех объектов
     QVector<FuryObject*> m_allObjects;
+    //! Номер изменения списка всех объектов
+    quint32 m_objectsVersion;
+    //! Объекты с нестатическими телами, которым нужен postPhysics
+    QVector<FuryObject*> m_dynamicObjects;
+    //! Корневые объекты, которым нужен tick
+    QVector<FuryObject*> m_tickObjects;
+    //! Списки обновления устарели
+    bool m_updateListsDirty;
+    //! Триггеры трассы по номерам
+    QVector<FuryObject*> m_triggers;
 
     //! Запущена ли симуляция
     bool m_started;
@@ -200,10 +311,8 @@ private:
     GLuint m_irradianceMap;
     GLuint m_prefilterMap;
     GLuint m_brdfLUTTexture;
-    bool m_shadowMapEnabled;
-
-    GLuint m_depthMapFBO;
-    GLuint m_depthMap;
+    //! Каскадные карты теней
+    FuryShadowCascades* m_shadowCascades;
 };
 
 #endif // WORLD_H
@@ -0,0 +1,200 @@
+#include "FuryAsyncLearner.h"
+
+#include "FuryReplayBuffer.h"
+#include "FuryPolicyNetwork.h"
+#include "Logger/FuryLogger.h"
+#include "Managers/FuryScriptManager.h"
+
+#include <QThread>
+#include <cstring>
+
+
+/*!
+ * \brief Добавление значений в конец вектора без перевыделения в пределах ёмкости
+ * \param[in,out] _vector - Вектор
+ * \param[in] _data - Значения. nullptr - нули
+ * \param[in] _count - Количество значений
+ */
+static void appendValues(QVector<float>& _vector, const float* _data, int _count)
+{
+    int offset = _vector.size();
+    _vector.resize(offset + _count);
+
+    if (_data != nullptr)
+    {
+        std::memcpy(_vector.data() + offset, _data, _count * sizeof(float));
+    }
+    else
+    {
+        std::memset(_vector.data() + offset, 0, _count * sizeof(float));
+    }
+}
+
+
+FuryAsyncLearner::FuryAsyncLearner(int _observationSize, int _actionCount, int _queueCapacity) :
+    m_observationSize(_observationSize),
+    m_actionCount(_actionCount),
+    m_queueCapacity(qMax(1, _queueCapacity)),
+    m_publishPeriod(100),
+    m_droppedCount(0),
+    m_policyVersion(0),
+    m_actorPolicyVersion(0),
+    m_explorationProbability(0.05f),
+    m_random(QRandomGenerator::global()->generate()),
+    m_thread(nullptr),
+    m_stopRequested(0)
+{
+    Debug(ru("Создание асинхронного обучения"));
+}
+
+FuryAsyncLearner::~FuryAsyncLearner()
+{
+    Debug(ru("Удаление асинхронного обучения"));
+
+    stop();
+}
+
+void FuryAsyncLearner::start(const QString &_scriptName)
+{
+    if (m_thread != nullptr)
+    {
+        return;
+    }
+
+    // Интерпретатор создаётся в вызывающем (главном) потоке
+    FuryScriptManager* scriptManager = FuryScriptManager::instance();
+
+    m_stopRequested.storeRelease(0);
+    m_thread = QThread::create([this, scriptManager, _scriptName]()
+    {
+        scriptManager->runLearner(_scriptName, this);
+    });
+
+    m_thread->setObjectName("FuryLearner");
+    m_thread->start();
+
+    Debug(ru("Старт потока обучения (%1)").arg(_scriptName));
+}
+
+void FuryAsyncLearner::stop()
+{
+    if (m_thread == nullptr)
+    {
+        return;
+    }
+
+    m_stopRequested.storeRelease(1);
+
+    m_queueMutex.lock();
+    m_queueCondition.wakeAll();
+    m_queueMutex.unlock();
+
+    m_thread->wait();
+    delete m_thread;
+    m_thread = nullptr;
+
+    Debug(ru("Поток обучения остановлен. Отброшено переходов: %1").arg(droppedCount()));
+}
+
+int FuryAsyncLearner::selectAction(const float *_observation)
+{
+    int version = m_policyVersion.loadAcquire();
+
+    if (version != m_actorPolicyVersion)
+    {
+        QMutexLocker locker(&m_policyMutex);
+        m_actorPolicy = m_publishedPolicy;
+        m_actorPolicyVersion = version;
+    }
+
+    if (m_actorPolicy.isNull() || m_random.generateDouble() < m_explorationProbability.load())
+    {
+        return m_random.bounded(m_actionCount);
+    }
+
+    return m_actorPolicy->predictAction(_observation);
+}
+
+void FuryAsyncLearner::pushTransition(const float *_observation, int _action, float _reward,
+                                      const float *_nextObservation)
+{
+    QMutexLocker locker(&m_queueMutex);
+
+    if (m_incoming.actions.size() >= m_queueCapacity)
+    {
+        m_droppedCount.fetchAndAddRelaxed(1);
+        return;
+    }
+
+    appendValues(m_incoming.observations, _observation, m_observationSize);
+    appendValues(m_incoming.nextObservations, _nextObservation, m_observationSize);
+    m_incoming.actions.append(_action);
+    m_incoming.rewards.append(_reward);
+    m_incoming.dones.append(_nextObservation == nullptr);
+
+    m_queueCondition.wakeOne();
+}
+
+int FuryAsyncLearner::drain(FuryReplayBuffer &_buffer)
+{
+    {
+        // Под мьютексом только обмен очередями: поток симуляции не ждёт копирования
+        QMutexLocker locker(&m_queueMutex);
+        std::swap(m_incoming, m_draining);
+    }
+
+    int count = m_draining.actions.size();
+
+    _buffer.addBatch(m_draining.observations.constData(),
+                     m_draining.actions.constData(),
+                     m_draining.rewards.constData(),
+                     m_draining.nextObservations.constData(),
+                     m_draining.dones.constData(),
+                     count);
+
+    // Ёмкость сохраняется: следующий обмен обойдётся без выделения памяти
+    m_draining.observations.clear();
+    m_draining.nextObservations.clear();
+    m_draining.actions.clear();
+    m_draining.rewards.clear();
+    m_draining.dones.clear();
+
+    return count;
+}
+
+bool FuryAsyncLearner::waitForTransitions(int _timeout)
+{
+    QMutexLocker locker(&m_queueMutex);
+
+    if (m_incoming.actions.isEmpty() && !stopRequested())
+    {
+        m_queueCondition.wait(&m_queueMutex, _timeout);
+    }
+
+    return !m_incoming.actions.isEmpty();
+}
+
+bool FuryAsyncLearner::publishPolicy(const QByteArray &_weights)
+{
+    QSharedPointer<FuryPolicyNetwork> policy(new FuryPolicyNetwork);
+
+    if (!policy->loadFromData(_weights))
+    {
+        return false;
+    }
+
+    if (policy->inputSize() != m_observationSize || policy->outputSize() != m_actionCount)
+    {
+        Debug(ru("Размеры опубликованной политики (%1 -> %2) не совпадают с актором")
+              .arg(policy->inputSize()).arg(policy->outputSize()));
+        return false;
+    }
+
+    {
+        QMutexLocker locker(&m_policyMutex);
+        m_publishedPolicy = policy;
+    }
+
+    m_policyVersion.fetchAndAddRelease(1);
+    return true;
+}
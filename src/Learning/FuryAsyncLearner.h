@@ -0,0 +1,218 @@
+#ifndef FURYASYNCLEARNER_H
+#define FURYASYNCLEARNER_H
+
+#include <QMutex>
+#include <QVector>
+#include <QString>
+#include <QAtomicInt>
+#include <QSharedPointer>
+#include <QWaitCondition>
+#include <QRandomGenerator>
+
+#include <atomic>
+
+class QThread;
+class FuryReplayBuffer;
+class FuryPolicyNetwork;
+
+
+/*!
+ * \brief Асинхронное обучение: актор в потоке симуляции, обучение в отдельном потоке.
+ *
+ * Поток симуляции только выбирает действия нативной нейросетью политики
+ * (см. FuryPolicyNetwork) и складывает переходы в очередь. Поток обучения
+ * выполняет функцию run(learner) скрипта Python: забирает переходы в буфер
+ * воспроизведения, обучает сеть и с заданной периодичностью публикует
+ * новые веса. Скорость симуляции не зависит от стоимости шага обучения.
+ */
+class FuryAsyncLearner
+{
+public:
+    /*!
+     * \brief Конструктор
+     * \param[in] _observationSize - Размер наблюдения
+     * \param[in] _actionCount - Количество действий
+     * \param[in] _queueCapacity - Наибольшее количество переходов в очереди.
+     * Если поток обучения не успевает, новые переходы отбрасываются
+     */
+    FuryAsyncLearner(int _observationSize, int _actionCount, int _queueCapacity = 100000);
+    //! Деструктор. Останавливает поток обучения
+    ~FuryAsyncLearner();
+
+    /*!
+     * \brief Запуск потока обучения со скриптом
+     * \param[in] _scriptName - Модуль скрипта с функцией run(learner)
+     */
+    void start(const QString& _scriptName);
+
+    //! Остановка потока обучения с ожиданием его завершения
+    void stop();
+
+    /*!
+     * \brief Выбор действия актором: случайное с вероятностью исследования,
+     * иначе по последней опубликованной политике. Вызывается из потока симуляции
+     * \param[in] _observation - Наблюдение
+     * \return Возвращает действие
+     */
+    int selectAction(const float* _observation);
+
+    /*!
+     * \brief Добавление перехода в очередь. Вызывается из потока симуляции
+     * \param[in] _observation - Наблюдение
+     * \param[in] _action - Действие
+     * \param[in] _reward - Награда
+     * \param[in] _nextObservation - Следующее наблюдение. nullptr - конец эпизода
+     */
+    void pushTransition(const float* _observation, int _action, float _reward,
+                        const float* _nextObservation);
+
+    /*!
+     * \brief Перенос накопленных переходов в буфер воспроизведения.
+     * Вызывается из потока обучения
+     * \param[in] _buffer - Буфер воспроизведения
+     * \return Возвращает количество перенесённых переходов
+     */
+    int drain(FuryReplayBuffer& _buffer);
+
+    /*!
+     * \brief Ожидание новых переходов или запроса остановки
+     * \param[in] _timeout - Наибольшее время ожидания в миллисекундах
+     * \return Возвращает признак наличия переходов в очереди
+     */
+    bool waitForTransitions(int _timeout);
+
+    /*!
+     * \brief Публикация новых весов политики. Актор подхватит их на следующем действии
+     * \param[in] _weights - Веса в формате файла весов (MLP.export)
+     * \return Возвращает признак успешной публикации
+     */
+    bool publishPolicy(const QByteArray& _weights);
+
+    /*!
+     * \brief Получить признак запроса остановки потока обучения
+     * \return Возвращает признак запроса остановки
+     */
+    inline bool stopRequested() const
+    { return m_stopRequested.loadAcquire() != 0; }
+
+    /*!
+     * \brief Установка вероятности случайного действия актора
+     * \param[in] _probability - Вероятность [0; 1]
+     */
+    inline void setExplorationProbability(float _probability)
+    { m_explorationProbability.store(_probability); }
+
+    /*!
+     * \brief Получить вероятность случайного действия актора
+     * \return Возвращает вероятность случайного действия
+     */
+    inline float explorationProbability() const
+    { return m_explorationProbability.load(); }
+
+    /*!
+     * \brief Установка периода публикации весов
+     * \param[in] _steps - Количество шагов обучения между публикациями
+     */
+    inline void setPublishPeriod(int _steps)
+    { m_publishPeriod = qMax(1, _steps); }
+
+    /*!
+     * \brief Получить период публикации весов
+     * \return Возвращает количество шагов обучения между публикациями
+     */
+    inline int publishPeriod() const
+    { return m_publishPeriod; }
+
+    /*!
+     * \brief Получить размер наблюдения
+     * \return Возвращает размер наблюдения
+     */
+    inline int observationSize() const
+    { return m_observationSize; }
+
+    /*!
+     * \brief Получить количество действий
+     * \return Возвращает количество действий
+     */
+    inline int actionCount() const
+    { return m_actionCount; }
+
+    /*!
+     * \brief Получить номер опубликованной политики
+     * \return Возвращает количество публикаций
+     */
+    inline int policyVersion() const
+    { return m_policyVersion.loadAcquire(); }
+
+    /*!
+     * \brief Получить количество отброшенных переходов
+     * \return Возвращает количество переходов, не поместившихся в очередь
+     */
+    inline int droppedCount() const
+    { return m_droppedCount.loadRelaxed(); }
+
+private:
+    //! Очередь переходов
+    struct TransitionQueue
+    {
+        //! Наблюдения
+        QVector<float> observations;
+        //! Следующие наблюдения
+        QVector<float> nextObservations;
+        //! Действия
+        QVector<int> actions;
+        //! Награды
+        QVector<float> rewards;
+        //! Признаки конца эпизода
+        QVector<bool> dones;
+    };
+
+private:
+    //! Размер наблюдения
+    int m_observationSize;
+    //! Количество действий
+    int m_actionCount;
+    //! Наибольшее количество переходов в очереди
+    int m_queueCapacity;
+    //! Количество шагов обучения между публикациями весов
+    int m_publishPeriod;
+
+    //! Очередь, которую пополняет поток симуляции
+    TransitionQueue m_incoming;
+    //! Очередь, которую разбирает поток обучения. Меняется местами с m_incoming
+    TransitionQueue m_draining;
+    //! Мьютекс очереди
+    QMutex m_queueMutex;
+    //! Условие появления переходов в очереди
+    QWaitCondition m_queueCondition;
+    //! Количество отброшенных переходов
+    QAtomicInt m_droppedCount;
+
+    //! Последняя опубликованная политика
+    QSharedPointer<FuryPolicyNetwork> m_publishedPolicy;
+    //! Мьютекс опубликованной политики
+    QMutex m_policyMutex;
+    //! Номер опубликованной политики
+    QAtomicInt m_policyVersion;
+
+    //! Политика, которой пользуется актор
+    QSharedPointer<FuryPolicyNetwork> m_actorPolicy;
+    //! Номер политики актора
+    int m_actorPolicyVersion;
+    //! Вероятность случайного действия актора
+    std::atomic<float> m_explorationProbability;
+    //! Генератор случайных чисел актора
+    QRandomGenerator m_random;
+
+    //! Поток обучения
+    QThread* m_thread;
+    //! Признак запроса остановки
+    QAtomicInt m_stopRequested;
+
+    //! Запрещаем конструктор копирования
+    FuryAsyncLearner(const FuryAsyncLearner&) = delete;
+    //! Запрещаем оператор присваивания
+    FuryAsyncLearner& operator=(const FuryAsyncLearner&) = delete;
+};
+
+#endif // FURYASYNCLEARNER_H
@@ -0,0 +1,338 @@
+#include "FuryPolicyNetwork.h"
+
+#include "Logger/FuryLogger.h"
+
+#include <QFile>
+#include <QBuffer>
+#include <QDataStream>
+#include <QVarLengthArray>
+#include <algorithm>
+
+#if defined(__AVX__) || defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+
+//! Сигнатура файла весов: "FPOL"
+static const quint32 policyFileMagic = 0x4C4F5046;
+//! Версия формата файла весов
+static const quint32 policyFileVersion = 1;
+//! Количество строк пакета, которые считаются вместе на одних загрузках весов
+static const int rowTile = 4;
+
+
+#if defined(__AVX__)
+
+typedef __m256 SimdFloat;
+//! Ширина регистра SIMD в float
+static const int simdWidth = 8;
+
+static inline SimdFloat simdLoad(const float* _data)
+{ return _mm256_loadu_ps(_data); }
+
+static inline void simdStore(float* _data, SimdFloat _value)
+{ _mm256_storeu_ps(_data, _value); }
+
+static inline SimdFloat simdSet(float _value)
+{ return _mm256_set1_ps(_value); }
+
+static inline SimdFloat simdMax(SimdFloat _a, SimdFloat _b)
+{ return _mm256_max_ps(_a, _b); }
+
+static inline SimdFloat simdMul(SimdFloat _a, SimdFloat _b)
+{ return _mm256_mul_ps(_a, _b); }
+
+static inline SimdFloat simdMulAdd(SimdFloat _a, SimdFloat _b, SimdFloat _c)
+{
+#if defined(__FMA__)
+    return _mm256_fmadd_ps(_a, _b, _c);
+#else
+    return _mm256_add_ps(_mm256_mul_ps(_a, _b), _c);
+#endif
+}
+
+#elif defined(__SSE2__) || defined(_M_X64)
+
+typedef __m128 SimdFloat;
+//! Ширина регистра SIMD в float
+static const int simdWidth = 4;
+
+static inline SimdFloat simdLoad(const float* _data)
+{ return _mm_loadu_ps(_data); }
+
+static inline void simdStore(float* _data, SimdFloat _value)
+{ _mm_storeu_ps(_data, _value); }
+
+static inline SimdFloat simdSet(float _value)
+{ return _mm_set1_ps(_value); }
+
+static inline SimdFloat simdMax(SimdFloat _a, SimdFloat _b)
+{ return _mm_max_ps(_a, _b); }
+
+static inline SimdFloat simdMul(SimdFloat _a, SimdFloat _b)
+{ return _mm_mul_ps(_a, _b); }
+
+static inline SimdFloat simdMulAdd(SimdFloat _a, SimdFloat _b, SimdFloat _c)
+{ return _mm_add_ps(_mm_mul_ps(_a, _b), _c); }
+
+#else
+
+typedef float SimdFloat;
+//! Ширина регистра SIMD в float
+static const int simdWidth = 1;
+
+static inline SimdFloat simdLoad(const float* _data)
+{ return *_data; }
+
+static inline void simdStore(float* _data, SimdFloat _value)
+{ *_data = _value; }
+
+static inline SimdFloat simdSet(float _value)
+{ return _value; }
+
+static inline SimdFloat simdMax(SimdFloat _a, SimdFloat _b)
+{ return (_a > _b) ? _a : _b; }
+
+static inline SimdFloat simdMul(SimdFloat _a, SimdFloat _b)
+{ return _a * _b; }
+
+static inline SimdFloat simdMulAdd(SimdFloat _a, SimdFloat _b, SimdFloat _c)
+{ return _a * _b + _c; }
+
+#endif
+
+
+/*!
+ * \brief Дополнение размера до кратного 8 (наибольшей ширине SIMD)
+ * \param[in] _size - Размер
+ * \return Возвращает дополненный размер
+ */
+static inline int paddedSize(int _size)
+{
+    return (_size + 7) / 8 * 8;
+}
+
+
+FuryPolicyNetwork::FuryPolicyNetwork() :
+    m_maxWidth(0)
+{
+
+}
+
+bool FuryPolicyNetwork::load(const QString &_path)
+{
+    QFile file(_path);
+
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        Debug(ru("Не удалось открыть файл весов политики: %1").arg(_path));
+        return false;
+    }
+
+    return read(&file, _path);
+}
+
+bool FuryPolicyNetwork::loadFromData(const QByteArray &_data)
+{
+    QBuffer buffer;
+    buffer.setData(_data);
+    buffer.open(QIODevice::ReadOnly);
+
+    return read(&buffer, ru("память"));
+}
+
+bool FuryPolicyNetwork::read(QIODevice *_device, const QString &_sourceName)
+{
+    QDataStream stream(_device);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    qint32 layerCount = 0;
+    stream >> magic >> version >> layerCount;
+
+    if (magic != policyFileMagic || version != policyFileVersion || layerCount <= 0)
+    {
+        Debug(ru("Неверный формат файла весов политики: %1").arg(_sourceName));
+        return false;
+    }
+
+    QVector<Layer> layers;
+    int maxWidth = 0;
+
+    for (int i = 0; i < layerCount; ++i)
+    {
+        qint32 inputSize = 0;
+        qint32 outputSize = 0;
+        qint32 activation = 0;
+        float alpha = 0;
+        stream >> inputSize >> outputSize >> activation >> alpha;
+
+        bool sizeMatches = layers.isEmpty() || layers.last().outputSize == inputSize;
+
+        if (inputSize <= 0 || outputSize <= 0 || !sizeMatches
+                || activation < ActivationIdentity || activation > ActivationLeakyRelu)
+        {
+            Debug(ru("Неверный слой %1 в файле весов политики: %2").arg(i).arg(_sourceName));
+            return false;
+        }
+
+        Layer layer;
+        layer.inputSize = inputSize;
+        layer.outputSize = outputSize;
+        layer.paddedOutputSize = paddedSize(outputSize);
+        layer.activation = Activation(activation);
+        layer.alpha = alpha;
+        layer.weights.fill(0, inputSize * layer.paddedOutputSize);
+        layer.biases.fill(0, layer.paddedOutputSize);
+
+        // Дополнительные столбцы остаются нулевыми: их выход 0 при любой активации
+        for (int row = 0; row < inputSize; ++row)
+        {
+            float* weights = layer.weights.data() + row * layer.paddedOutputSize;
+
+            for (int column = 0; column < outputSize; ++column)
+            {
+                stream >> weights[column];
+            }
+        }
+
+        for (int column = 0; column < outputSize; ++column)
+        {
+            stream >> layer.biases[column];
+        }
+
+        maxWidth = qMax(maxWidth, layer.paddedOutputSize);
+        layers.append(layer);
+    }
+
+    if (stream.status() != QDataStream::Ok)
+    {
+        Debug(ru("Файл весов политики обрезан: %1").arg(_sourceName));
+        return false;
+    }
+
+    m_layers = layers;
+    m_maxWidth = maxWidth;
+
+    Debug(ru("Загружена политика %1 -> %2, слоёв: %3")
+          .arg(inputSize()).arg(outputSize()).arg(m_layers.size()));
+    return true;
+}
+
+void FuryPolicyNetwork::evaluate(const float *_inputs, int _count, float *_outputs) const
+{
+    if (m_layers.isEmpty() || _count <= 0)
+    {
+        return;
+    }
+
+    // Два промежуточных буфера по очереди: выход одного слоя - вход следующего.
+    // Небольшие пакеты считаются на стеке
+    QVarLengthArray<float, 1024> scratch(2 * _count * m_maxWidth);
+    float* buffers[2] = { scratch.data(), scratch.data() + _count * m_maxWidth };
+
+    const float* input = _inputs;
+    int inputStride = inputSize();
+
+    for (int i = 0; i < m_layers.size(); ++i)
+    {
+        const Layer& layer = m_layers.at(i);
+        float* output = buffers[i % 2];
+
+        forwardLayer(layer, input, inputStride, output, layer.paddedOutputSize, _count);
+
+        input = output;
+        inputStride = layer.paddedOutputSize;
+    }
+
+    int size = outputSize();
+
+    for (int row = 0; row < _count; ++row)
+    {
+        std::copy(input + row * inputStride, input + row * inputStride + size, _outputs + row * size);
+    }
+}
+
+void FuryPolicyNetwork::predictActions(const float *_observations, int _count, int *_actions) const
+{
+    int size = outputSize();
+
+    if (size == 0 || _count <= 0)
+    {
+        return;
+    }
+
+    QVarLengthArray<float, 256> scores(_count * size);
+    evaluate(_observations, _count, scores.data());
+
+    for (int row = 0; row < _count; ++row)
+    {
+        const float* rowScores = scores.constData() + row * size;
+        _actions[row] = int(std::max_element(rowScores, rowScores + size) - rowScores);
+    }
+}
+
+int FuryPolicyNetwork::predictAction(const float *_observation) const
+{
+    int action = 0;
+    predictActions(_observation, 1, &action);
+    return action;
+}
+
+void FuryPolicyNetwork::forwardLayer(const Layer &_layer, const float *_input, int _inputStride,
+                                     float *_output, int _outputStride, int _rows)
+{
+    const float* weights = _layer.weights.constData();
+    const float* biases = _layer.biases.constData();
+    const SimdFloat alpha = simdSet(_layer.alpha);
+
+    for (int row = 0; row < _rows; row += rowTile)
+    {
+        // Строки за концом пакета считаются по последней строке и не записываются
+        const float* inputs[rowTile];
+        float* outputs[rowTile];
+        int tileRows = qMin(rowTile, _rows - row);
+
+        for (int r = 0; r < rowTile; ++r)
+        {
+            int index = row + qMin(r, tileRows - 1);
+            inputs[r] = _input + index * _inputStride;
+            outputs[r] = _output + index * _outputStride;
+        }
+
+        for (int column = 0; column < _layer.paddedOutputSize; column += simdWidth)
+        {
+            SimdFloat sums[rowTile];
+
+            for (int r = 0; r < rowTile; ++r)
+            {
+                sums[r] = simdLoad(biases + column);
+            }
+
+            // Одна загрузка столбца весов на все строки блока
+            for (int i = 0; i < _layer.inputSize; ++i)
+            {
+                SimdFloat weight = simdLoad(weights + i * _layer.paddedOutputSize + column);
+
+                for (int r = 0; r < rowTile; ++r)
+                {
+                    sums[r] = simdMulAdd(simdSet(inputs[r][i]), weight, sums[r]);
+                }
+            }
+
+            for (int r = 0; r < tileRows; ++r)
+            {
+                SimdFloat value = sums[r];
+
+                if (_layer.activation == ActivationLeakyRelu)
+                {
+                    value = simdMax(value, simdMul(value, alpha));
+                }
+
+                simdStore(outputs[r] + column, value);
+            }
+        }
+    }
+}
@@ -0,0 +1,137 @@
+#ifndef FURYPOLICYNETWORK_H
+#define FURYPOLICYNETWORK_H
+
+#include <QVector>
+#include <QString>
+
+class QIODevice;
+
+
+/*!
+ * \brief Нейросеть политики машины без Python.
+ *
+ * Полносвязная сеть (MLP из scripts/model.py), веса которой выгружаются
+ * скриптом в saved-model/policy.bin. Прямой проход считается пакетом
+ * на SIMD (AVX / SSE). Объект только читает веса, поэтому одну сеть
+ * можно использовать из нескольких потоков одновременно.
+ */
+class FuryPolicyNetwork
+{
+public:
+    //! Функция активации слоя
+    enum Activation
+    {
+        ActivationIdentity = 0, //!< Без активации
+        ActivationLeakyRelu     //!< max(x, alpha * x)
+    };
+
+    //! Конструктор
+    FuryPolicyNetwork();
+
+    /*!
+     * \brief Загрузка весов, выгруженных MLP.export
+     * \param[in] _path - Путь к файлу весов
+     * \return Возвращает признак успешной загрузки
+     */
+    bool load(const QString& _path);
+
+    /*!
+     * \brief Загрузка весов из памяти, в формате файла весов.
+     * Так обучающий поток публикует новые веса без записи на диск
+     * \param[in] _data - Веса
+     * \return Возвращает признак успешной загрузки
+     */
+    bool loadFromData(const QByteArray& _data);
+
+    /*!
+     * \brief Прямой проход для пакета входов
+     * \param[in] _inputs - Входы, _count x inputSize
+     * \param[in] _count - Размер пакета
+     * \param[out] _outputs - Выходы, _count x outputSize
+     */
+    void evaluate(const float* _inputs, int _count, float* _outputs) const;
+
+    /*!
+     * \brief Выбор действий для пакета наблюдений: номер выхода с наибольшей оценкой
+     * \param[in] _observations - Наблюдения, _count x inputSize
+     * \param[in] _count - Размер пакета
+     * \param[out] _actions - Действия, _count значений
+     */
+    void predictActions(const float* _observations, int _count, int* _actions) const;
+
+    /*!
+     * \brief Выбор действия для одного наблюдения
+     * \param[in] _observation - Наблюдение
+     * \return Возвращает действие
+     */
+    int predictAction(const float* _observation) const;
+
+    /*!
+     * \brief Получить признак загруженных весов
+     * \return Возвращает признак загруженных весов
+     */
+    inline bool isLoaded() const
+    { return !m_layers.isEmpty(); }
+
+    /*!
+     * \brief Получить размер входа
+     * \return Возвращает размер входа
+     */
+    inline int inputSize() const
+    { return m_layers.isEmpty() ? 0 : m_layers.first().inputSize; }
+
+    /*!
+     * \brief Получить размер выхода (количество действий)
+     * \return Возвращает размер выхода
+     */
+    inline int outputSize() const
+    { return m_layers.isEmpty() ? 0 : m_layers.last().outputSize; }
+
+private:
+    //! Полносвязный слой
+    struct Layer
+    {
+        //! Размер входа
+        int inputSize;
+        //! Размер выхода
+        int outputSize;
+        //! Размер выхода, дополненный нулями до ширины SIMD
+        int paddedOutputSize;
+        //! Функция активации
+        Activation activation;
+        //! Наклон отрицательной части leaky ReLU
+        float alpha;
+        //! Веса, inputSize x paddedOutputSize по строкам
+        QVector<float> weights;
+        //! Смещения, paddedOutputSize
+        QVector<float> biases;
+    };
+
+    /*!
+     * \brief Чтение весов из потока
+     * \param[in] _device - Источник весов
+     * \param[in] _sourceName - Название источника для сообщений
+     * \return Возвращает признак успешного чтения
+     */
+    bool read(QIODevice* _device, const QString& _sourceName);
+
+    /*!
+     * \brief Прямой проход одного слоя для пакета строк
+     * \param[in] _layer - Слой
+     * \param[in] _input - Входы
+     * \param[in] _inputStride - Шаг строк входа
+     * \param[out] _output - Выходы
+     * \param[in] _outputStride - Шаг строк выхода
+     * \param[in] _rows - Количество строк
+     */
+    static void forwardLayer(const Layer& _layer, const float* _input, int _inputStride,
+                             float* _output, int _outputStride, int _rows);
+
+private:
+    //! Слои
+    QVector<Layer> m_layers;
+    //! Наибольший дополненный размер выхода слоя
+    int m_maxWidth;
+};
+
+#endif // FURYPOLICYNETWORK_H
@@ -0,0 +1,382 @@
+#include "FuryReplayBuffer.h"
+
+#include "Logger/FuryLogger.h"
+#include "Logger/FuryException.h"
+
+#include <QFile>
+#include <cmath>
+#include <limits>
+#include <cstring>
+
+
+//! Сигнатура файла буфера: "FRPB"
+static const quint32 replayFileMagic = 0x42505246;
+//! Версия формата файла буфера
+static const quint32 replayFileVersion = 1;
+//! Минимальный приоритет, чтобы переход с нулевой ошибкой оставался в выборке
+static const double minPriority = 1e-6;
+
+
+/*!
+ * \brief Запись массива в отображённую память
+ * \param[in] _cursor - Позиция записи
+ * \param[in] _array - Массив
+ * \return Возвращает позицию после массива
+ */
+template<typename T>
+static uchar* writeArray(uchar* _cursor, const QVector<T>& _array)
+{
+    std::memcpy(_cursor, _array.constData(), _array.size() * sizeof(T));
+    return _cursor + _array.size() * sizeof(T);
+}
+
+/*!
+ * \brief Чтение массива из отображённой памяти
+ * \param[in] _cursor - Позиция чтения
+ * \param[out] _array - Массив. Размер должен быть уже установлен
+ * \return Возвращает позицию после массива
+ */
+template<typename T>
+static const uchar* readArray(const uchar* _cursor, QVector<T>& _array)
+{
+    std::memcpy(_array.data(), _cursor, _array.size() * sizeof(T));
+    return _cursor + _array.size() * sizeof(T);
+}
+
+
+FuryReplayBuffer::FuryReplayBuffer(int _capacity, int _observationSize, int _batchSize,
+                                   int _actionCount, float _alpha) :
+    m_capacity(_capacity),
+    m_observationSize(_observationSize),
+    m_batchSize(_batchSize),
+    m_actionCount(_actionCount),
+    m_alpha(_alpha),
+    m_size(0),
+    m_position(0),
+    m_maxPriority(1),
+    m_treeCapacity(1),
+    m_random(QRandomGenerator::global()->generate())
+{
+    if (_capacity <= 0 || _observationSize <= 0 || _batchSize <= 0 || _actionCount <= 0)
+    {
+        throw FuryException(ru("Неверные размеры буфера воспроизведения"),
+                            "_capacity <= 0 || _observationSize <= 0 || _batchSize <= 0 || _actionCount <= 0",
+                            Q_FUNC_INFO);
+    }
+
+    Debug(ru("Создание буфера воспроизведения на %1 переходов").arg(_capacity));
+
+    while (m_treeCapacity < m_capacity)
+    {
+        m_treeCapacity *= 2;
+    }
+
+    m_observations.fill(0, m_capacity * m_observationSize);
+    m_nextObservations.fill(0, m_capacity * m_observationSize);
+    m_actions.fill(0, m_capacity);
+    m_rewards.fill(0, m_capacity);
+    m_nextMasks.fill(0, m_capacity);
+
+    m_sumTree.fill(0, 2 * m_treeCapacity);
+    m_minTree.fill(std::numeric_limits<double>::max(), 2 * m_treeCapacity);
+
+    m_batchObservations.fill(0, m_batchSize * m_observationSize);
+    m_batchActionMasks.fill(0, m_batchSize * m_actionCount);
+    m_batchRewards.fill(0, m_batchSize);
+    m_batchNextObservations.fill(0, m_batchSize * m_observationSize);
+    m_batchNextMasks.fill(0, m_batchSize);
+    m_batchIndices.fill(0, m_batchSize);
+    m_batchWeights.fill(1, m_batchSize);
+}
+
+void FuryReplayBuffer::add(const float *_observation, int _action, float _reward,
+                           const float *_nextObservation)
+{
+    int index = m_position;
+    float* observation = m_observations.data() + index * m_observationSize;
+    float* nextObservation = m_nextObservations.data() + index * m_observationSize;
+
+    std::memcpy(observation, _observation, m_observationSize * sizeof(float));
+
+    if (_nextObservation != nullptr)
+    {
+        std::memcpy(nextObservation, _nextObservation, m_observationSize * sizeof(float));
+        m_nextMasks[index] = 1;
+    }
+    else
+    {
+        std::memset(nextObservation, 0, m_observationSize * sizeof(float));
+        m_nextMasks[index] = 0;
+    }
+
+    m_actions[index] = _action;
+    m_rewards[index] = _reward;
+
+    // Новый переход получает максимальный приоритет, чтобы попасть в выборку хотя бы раз
+    setTreeValue(index, std::pow(m_maxPriority, double(m_alpha)));
+
+    m_position = (m_position + 1) % m_capacity;
+    m_size = qMin(m_size + 1, m_capacity);
+}
+
+void FuryReplayBuffer::addBatch(const float *_observations, const int *_actions,
+                                const float *_rewards, const float *_nextObservations,
+                                const bool *_dones, int _count)
+{
+    for (int i = 0; i < _count; ++i)
+    {
+        add(_observations + i * m_observationSize,
+            _actions[i],
+            _rewards[i],
+            _dones[i] ? nullptr : _nextObservations + i * m_observationSize);
+    }
+}
+
+void FuryReplayBuffer::sampleUniform()
+{
+    if (m_size == 0)
+    {
+        return;
+    }
+
+    for (int row = 0; row < m_batchSize; ++row)
+    {
+        copyToBatch(row, m_random.bounded(m_size), 1);
+    }
+}
+
+void FuryReplayBuffer::samplePrioritized(float _beta)
+{
+    if (m_size == 0)
+    {
+        return;
+    }
+
+    // Выборка по слоям: сумма приоритетов делится на batchSize равных отрезков,
+    // из каждого берётся по одному переходу
+    double segment = m_sumTree[1] / m_batchSize;
+    double minValue = m_minTree[1];
+
+    for (int row = 0; row < m_batchSize; ++row)
+    {
+        int index = findPrefixSum(segment * (row + m_random.generateDouble()));
+        double value = m_sumTree[m_treeCapacity + index];
+
+        // w = (N * P(i))^-beta / max(w) = (p_i / p_min)^-beta
+        float weight = float(std::pow(value / minValue, -double(_beta)));
+        copyToBatch(row, index, weight);
+    }
+}
+
+void FuryReplayBuffer::updatePriorities(const int *_indices, const float *_priorities, int _count)
+{
+    for (int i = 0; i < _count; ++i)
+    {
+        int index = _indices[i];
+
+        if (index < 0 || index >= m_size)
+        {
+            continue;
+        }
+
+        double priority = qMax(double(std::abs(_priorities[i])), minPriority);
+        m_maxPriority = qMax(m_maxPriority, priority);
+        setTreeValue(index, std::pow(priority, double(m_alpha)));
+    }
+}
+
+bool FuryReplayBuffer::save(const QString &_path) const
+{
+    QFile file(_path);
+
+    if (!file.open(QIODevice::ReadWrite | QIODevice::Truncate))
+    {
+        Debug(ru("Не удалось открыть файл буфера воспроизведения: %1").arg(_path));
+        return false;
+    }
+
+    qint64 size = fileSize();
+    uchar* data = file.resize(size) ? file.map(0, size) : nullptr;
+
+    if (data == nullptr)
+    {
+        Debug(ru("Не удалось отобразить файл буфера воспроизведения: %1").arg(_path));
+        return false;
+    }
+
+    FileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    header.magic = replayFileMagic;
+    header.version = replayFileVersion;
+    header.capacity = m_capacity;
+    header.observationSize = m_observationSize;
+    header.actionCount = m_actionCount;
+    header.size = m_size;
+    header.position = m_position;
+    header.alpha = m_alpha;
+    header.maxPriority = m_maxPriority;
+
+    std::memcpy(data, &header, sizeof(header));
+
+    // Деревья приоритетов сохраняются вместе с переходами:
+    // при восстановлении их не нужно пересчитывать
+    uchar* cursor = data + sizeof(header);
+    cursor = writeArray(cursor, m_observations);
+    cursor = writeArray(cursor, m_nextObservations);
+    cursor = writeArray(cursor, m_actions);
+    cursor = writeArray(cursor, m_rewards);
+    cursor = writeArray(cursor, m_nextMasks);
+    cursor = writeArray(cursor, m_sumTree);
+    writeArray(cursor, m_minTree);
+
+    file.unmap(data);
+    file.close();
+
+    Debug(ru("Буфер воспроизведения сохранён: %1 переходов").arg(m_size));
+    return true;
+}
+
+bool FuryReplayBuffer::restore(const QString &_path)
+{
+    QFile file(_path);
+
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        Debug(ru("Не удалось открыть файл буфера воспроизведения: %1").arg(_path));
+        return false;
+    }
+
+    if (file.size() != fileSize())
+    {
+        Debug(ru("Размер файла буфера воспроизведения не совпадает: %1").arg(_path));
+        return false;
+    }
+
+    const uchar* data = file.map(0, file.size());
+
+    if (data == nullptr)
+    {
+        Debug(ru("Не удалось отобразить файл буфера воспроизведения: %1").arg(_path));
+        return false;
+    }
+
+    FileHeader header;
+    std::memcpy(&header, data, sizeof(header));
+
+    if (header.magic != replayFileMagic || header.version != replayFileVersion
+            || header.capacity != m_capacity || header.observationSize != m_observationSize
+            || header.actionCount != m_actionCount || header.alpha != m_alpha)
+    {
+        Debug(ru("Файл буфера воспроизведения не подходит к буферу: %1").arg(_path));
+        file.unmap(const_cast<uchar*>(data));
+        return false;
+    }
+
+    // Пока буфер не заполнен, запись идёт подряд с начала
+    if (header.size < 0 || header.size > m_capacity
+            || header.position < 0 || header.position >= m_capacity
+            || !std::isfinite(header.maxPriority) || header.maxPriority <= 0
+            || (header.size < m_capacity && header.position != header.size % m_capacity))
+    {
+        Debug(ru("Повреждён заголовок файла буфера воспроизведения: %1").arg(_path));
+        file.unmap(const_cast<uchar*>(data));
+        return false;
+    }
+
+    const uchar* cursor = data + sizeof(header);
+    cursor = readArray(cursor, m_observations);
+    cursor = readArray(cursor, m_nextObservations);
+    cursor = readArray(cursor, m_actions);
+    cursor = readArray(cursor, m_rewards);
+    cursor = readArray(cursor, m_nextMasks);
+    cursor = readArray(cursor, m_sumTree);
+    readArray(cursor, m_minTree);
+
+    m_size = header.size;
+    m_position = header.position;
+    m_maxPriority = header.maxPriority;
+
+    file.unmap(const_cast<uchar*>(data));
+    file.close();
+
+    Debug(ru("Буфер воспроизведения восстановлен: %1 переходов").arg(m_size));
+    return true;
+}
+
+void FuryReplayBuffer::clear()
+{
+    m_size = 0;
+    m_position = 0;
+    m_maxPriority = 1;
+
+    m_sumTree.fill(0);
+    m_minTree.fill(std::numeric_limits<double>::max());
+}
+
+void FuryReplayBuffer::setTreeValue(int _index, double _value)
+{
+    int node = m_treeCapacity + _index;
+    m_sumTree[node] = _value;
+    m_minTree[node] = _value;
+
+    for (node /= 2; node >= 1; node /= 2)
+    {
+        m_sumTree[node] = m_sumTree[2 * node] + m_sumTree[2 * node + 1];
+        m_minTree[node] = qMin(m_minTree[2 * node], m_minTree[2 * node + 1]);
+    }
+}
+
+int FuryReplayBuffer::findPrefixSum(double _prefixSum) const
+{
+    int node = 1;
+
+    while (node < m_treeCapacity)
+    {
+        if (m_sumTree[2 * node] > _prefixSum)
+        {
+            node = 2 * node;
+        }
+        else
+        {
+            _prefixSum -= m_sumTree[2 * node];
+            node = 2 * node + 1;
+        }
+    }
+
+    // Ошибка округления может увести в пустой лист за концом буфера
+    return qMin(node - m_treeCapacity, m_size - 1);
+}
+
+void FuryReplayBuffer::copyToBatch(int _row, int _index, float _weight)
+{
+    std::memcpy(m_batchObservations.data() + _row * m_observationSize,
+                m_observations.constData() + _index * m_observationSize,
+                m_observationSize * sizeof(float));
+    std::memcpy(m_batchNextObservations.data() + _row * m_observationSize,
+                m_nextObservations.constData() + _index * m_observationSize,
+                m_observationSize * sizeof(float));
+
+    float* actionMask = m_batchActionMasks.data() + _row * m_actionCount;
+    std::memset(actionMask, 0, m_actionCount * sizeof(float));
+
+    int action = m_actions.at(_index);
+
+    if (action >= 0 && action < m_actionCount)
+    {
+        actionMask[action] = 1;
+    }
+
+    m_batchRewards[_row] = m_rewards.at(_index);
+    m_batchNextMasks[_row] = m_nextMasks.at(_index);
+    m_batchIndices[_row] = _index;
+    m_batchWeights[_row] = _weight;
+}
+
+qint64 FuryReplayBuffer::fileSize() const
+{
+    return qint64(sizeof(FileHeader))
+            + qint64(m_observations.size() + m_nextObservations.size()
+                     + m_rewards.size() + m_nextMasks.size()) * sizeof(float)
+            + qint64(m_actions.size()) * sizeof(int)
+            + qint64(m_sumTree.size() + m_minTree.size()) * sizeof(double);
+}
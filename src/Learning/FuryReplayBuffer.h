@@ -0,0 +1,286 @@
+#ifndef FURYREPLAYBUFFER_H
+#define FURYREPLAYBUFFER_H
+
+#include <QVector>
+#include <QString>
+#include <QRandomGenerator>
+
+
+/*!
+ * \brief Буфер воспроизведения опыта для обучения с подкреплением.
+ *
+ * Кольцевой буфер переходов (наблюдение, действие, награда, следующее
+ * наблюдение). Наблюдения лежат одним непрерывным блоком float, мини-пакеты
+ * выбираются равномерно или по приоритетам (дерево сумм) и копируются
+ * в заранее выделенные массивы пакета. Буфер целиком сохраняется в файл
+ * и восстанавливается из него через отображение файла в память.
+ */
+class FuryReplayBuffer
+{
+public:
+    /*!
+     * \brief Конструктор
+     * \param[in] _capacity - Максимальное количество переходов
+     * \param[in] _observationSize - Размер наблюдения
+     * \param[in] _batchSize - Размер мини-пакета
+     * \param[in] _actionCount - Количество действий
+     * \param[in] _alpha - Степень приоритетов. 0 - равномерная выборка
+     * \throw FuryException - При неположительных размерах
+     */
+    FuryReplayBuffer(int _capacity, int _observationSize, int _batchSize,
+                     int _actionCount, float _alpha = 0.6f);
+
+    /*!
+     * \brief Добавление перехода. Самый старый переход вытесняется при заполнении
+     * \param[in] _observation - Наблюдение
+     * \param[in] _action - Действие
+     * \param[in] _reward - Награда
+     * \param[in] _nextObservation - Следующее наблюдение. nullptr - конец эпизода
+     */
+    void add(const float* _observation, int _action, float _reward,
+             const float* _nextObservation);
+
+    /*!
+     * \brief Добавление пакета переходов, например шага векторной среды
+     * \param[in] _observations - Наблюдения, _count x observationSize
+     * \param[in] _actions - Действия
+     * \param[in] _rewards - Награды
+     * \param[in] _nextObservations - Следующие наблюдения, _count x observationSize
+     * \param[in] _dones - Признаки конца эпизода. Для них следующее наблюдение не берётся
+     * \param[in] _count - Количество переходов
+     */
+    void addBatch(const float* _observations, const int* _actions, const float* _rewards,
+                  const float* _nextObservations, const bool* _dones, int _count);
+
+    /*!
+     * \brief Равномерная выборка мини-пакета (с повторениями) в массивы пакета.
+     * Веса важности пакета равны 1
+     */
+    void sampleUniform();
+
+    /*!
+     * \brief Выборка мини-пакета пропорционально приоритетам в массивы пакета
+     * \param[in] _beta - Степень поправки весов важности. 1 - полная поправка
+     */
+    void samplePrioritized(float _beta);
+
+    /*!
+     * \brief Обновление приоритетов переходов, обычно по модулю ошибки TD
+     * \param[in] _indices - Индексы переходов
+     * \param[in] _priorities - Новые приоритеты
+     * \param[in] _count - Количество переходов
+     */
+    void updatePriorities(const int* _indices, const float* _priorities, int _count);
+
+    /*!
+     * \brief Сохранение буфера в файл
+     * \param[in] _path - Путь к файлу
+     * \return Возвращает признак успешного сохранения
+     */
+    bool save(const QString& _path) const;
+
+    /*!
+     * \brief Восстановление буфера из файла.
+     * Размеры буфера должны совпадать с сохранёнными
+     * \param[in] _path - Путь к файлу
+     * \return Возвращает признак успешного восстановления
+     */
+    bool restore(const QString& _path);
+
+    //! Очистка буфера
+    void clear();
+
+    /*!
+     * \brief Установка зерна генератора случайных чисел
+     * \param[in] _seed - Зерно
+     */
+    inline void setSeed(quint32 _seed)
+    { m_random.seed(_seed); }
+
+    /*!
+     * \brief Получить максимальное количество переходов
+     * \return Возвращает максимальное количество переходов
+     */
+    inline int capacity() const
+    { return m_capacity; }
+
+    /*!
+     * \brief Получить количество переходов
+     * \return Возвращает количество переходов
+     */
+    inline int size() const
+    { return m_size; }
+
+    /*!
+     * \brief Получить размер наблюдения
+     * \return Возвращает размер наблюдения
+     */
+    inline int observationSize() const
+    { return m_observationSize; }
+
+    /*!
+     * \brief Получить размер мини-пакета
+     * \return Возвращает размер мини-пакета
+     */
+    inline int batchSize() const
+    { return m_batchSize; }
+
+    /*!
+     * \brief Получить количество действий
+     * \return Возвращает количество действий
+     */
+    inline int actionCount() const
+    { return m_actionCount; }
+
+    /*!
+     * \brief Получить индекс последнего добавленного перехода
+     * \return Возвращает индекс последнего перехода. -1 - буфер пуст
+     */
+    inline int latestIndex() const
+    { return (m_size == 0) ? -1 : (m_position + m_capacity - 1) % m_capacity; }
+
+    /*!
+     * \brief Получить наблюдение перехода
+     * \param[in] _index - Индекс перехода
+     * \return Возвращает указатель на observationSize значений
+     */
+    inline float* observationAt(int _index)
+    { return m_observations.data() + _index * m_observationSize; }
+
+    //! Наблюдения пакета, batchSize x observationSize
+    inline float* batchObservations()
+    { return m_batchObservations.data(); }
+
+    //! Маски действий пакета (one-hot), batchSize x actionCount
+    inline float* batchActionMasks()
+    { return m_batchActionMasks.data(); }
+
+    //! Награды пакета, batchSize
+    inline float* batchRewards()
+    { return m_batchRewards.data(); }
+
+    //! Следующие наблюдения пакета, batchSize x observationSize
+    inline float* batchNextObservations()
+    { return m_batchNextObservations.data(); }
+
+    //! Маски следующих наблюдений пакета (0 - конец эпизода), batchSize
+    inline float* batchNextMasks()
+    { return m_batchNextMasks.data(); }
+
+    //! Индексы переходов пакета, batchSize
+    inline int* batchIndices()
+    { return m_batchIndices.data(); }
+
+    //! Веса важности пакета, batchSize
+    inline float* batchWeights()
+    { return m_batchWeights.data(); }
+
+private:
+    //! Заголовок файла буфера
+    struct FileHeader
+    {
+        //! Сигнатура файла
+        quint32 magic;
+        //! Версия формата
+        quint32 version;
+        //! Максимальное количество переходов
+        qint32 capacity;
+        //! Размер наблюдения
+        qint32 observationSize;
+        //! Количество действий
+        qint32 actionCount;
+        //! Количество переходов
+        qint32 size;
+        //! Позиция записи следующего перехода
+        qint32 position;
+        //! Степень приоритетов
+        float alpha;
+        //! Максимальный приоритет
+        double maxPriority;
+    };
+
+    /*!
+     * \brief Установка приоритета листа дерева с пересчётом предков
+     * \param[in] _index - Индекс перехода
+     * \param[in] _value - Приоритет в степени alpha
+     */
+    void setTreeValue(int _index, double _value);
+
+    /*!
+     * \brief Поиск перехода по префиксной сумме приоритетов
+     * \param[in] _prefixSum - Префиксная сумма
+     * \return Возвращает индекс перехода
+     */
+    int findPrefixSum(double _prefixSum) const;
+
+    /*!
+     * \brief Копирование перехода в строку пакета
+     * \param[in] _row - Строка пакета
+     * \param[in] _index - Индекс перехода
+     * \param[in] _weight - Вес важности
+     */
+    void copyToBatch(int _row, int _index, float _weight);
+
+    /*!
+     * \brief Получить размер файла буфера
+     * \return Возвращает размер файла в байтах
+     */
+    qint64 fileSize() const;
+
+private:
+    //! Максимальное количество переходов
+    int m_capacity;
+    //! Размер наблюдения
+    int m_observationSize;
+    //! Размер мини-пакета
+    int m_batchSize;
+    //! Количество действий
+    int m_actionCount;
+    //! Степень приоритетов
+    float m_alpha;
+
+    //! Количество переходов
+    int m_size;
+    //! Позиция записи следующего перехода
+    int m_position;
+    //! Максимальный приоритет. Его получают новые переходы
+    double m_maxPriority;
+
+    //! Наблюдения, capacity x observationSize
+    QVector<float> m_observations;
+    //! Следующие наблюдения, capacity x observationSize
+    QVector<float> m_nextObservations;
+    //! Действия
+    QVector<int> m_actions;
+    //! Награды
+    QVector<float> m_rewards;
+    //! Маски следующих наблюдений
+    QVector<float> m_nextMasks;
+
+    //! Количество листьев дерева (степень двойки)
+    int m_treeCapacity;
+    //! Дерево сумм приоритетов. Корень - 1, листья с m_treeCapacity
+    QVector<double> m_sumTree;
+    //! Дерево минимумов приоритетов
+    QVector<double> m_minTree;
+
+    //! Наблюдения пакета
+    QVector<float> m_batchObservations;
+    //! Маски действий пакета
+    QVector<float> m_batchActionMasks;
+    //! Награды пакета
+    QVector<float> m_batchRewards;
+    //! Следующие наблюдения пакета
+    QVector<float> m_batchNextObservations;
+    //! Маски следующих наблюдений пакета
+    QVector<float> m_batchNextMasks;
+    //! Индексы переходов пакета
+    QVector<int> m_batchIndices;
+    //! Веса важности пакета
+    QVector<float> m_batchWeights;
+
+    //! Генератор случайных чисел
+    QRandomGenerator m_random;
+};
+
+#endif // FURYREPLAYBUFFER_H
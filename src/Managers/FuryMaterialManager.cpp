@@ -13,7 +13,8 @@ FuryMaterialManager* FuryMaterialManager::s_instance = nullptr;
 
 
 FuryMaterialManager::FuryMaterialManager() :
-    m_defaultMaterial(new FuryPbrMaterial)
+    m_defaultMaterial(new FuryPbrMaterial),
+    m_version(0)
 {
     Debug(ru("Создание менеджера материалов"));
 }
@@ -110,6 +111,7 @@ void FuryMaterialManager::deleteMaterial(const QString &_name)
     FuryMaterial* material = m_materials.value(_name);
     delete material;
     m_materials.remove(_name);
+    ++m_version;
 }
 
 bool FuryMaterialManager::materialExist(const QString &_name)
@@ -153,6 +155,7 @@ bool FuryMaterialManager::tryLoadMaterial(const QString &_name)
 
     Debug(ru("Импортирован материал: (%1)").arg(_name));
     m_materials.insert(_name, mat);
+    ++m_version;
 
     return true;
 }
@@ -114,6 +114,14 @@ public:
     //! Сохранение материалов
     void saveMaterials();
 
+    /*!
+     * \brief Получение номера изменения набора материалов. Растёт при каждом
+     * добавлении и удалении, чтобы кэши указателей на материалы знали о замене
+     * \return Возвращает номер изменения
+     */
+    inline quint32 version() const
+    { return m_version; }
+
 private:
     //! Конструктор
     FuryMaterialManager();
@@ -132,6 +140,8 @@ private:
     QMap<QString, FuryMaterial*> m_materials;
     //! Материал по умолчанию
     FuryMaterial* m_defaultMaterial;
+    //! Номер изменения набора материалов
+    quint32 m_version;
 };
 
 
@@ -150,6 +160,7 @@ T *FuryMaterialManager::createUserMaterial(const QString &_name)
 
     T* material = new T;
     m_materials.insert(_name, material);
+    ++m_version;
     return material;
 }
 
@@ -164,6 +175,7 @@ void FuryMaterialManager::insertUserMaterial(const QString &_name, T* _material)
 
     Debug(ru("Добавлен материал: (%1)").arg(_name));
     m_materials.insert(_name, _material);
+    ++m_version;
 }
 
 #endif // FURYMATERIALMANAGER_H
@@ -3,6 +3,8 @@
 #include "FuryObject.h"
 #include "Logger/FuryLogger.h"
 #include "Logger/FuryException.h"
+#include "Learning/FuryAsyncLearner.h"
+#include "Simulation/FuryVectorEnvironment.h"
 
 
 using namespace boost::python;
@@ -12,13 +14,39 @@ using namespace boost::python;
 extern "C" PyObject* PyInit_glm();
 extern "C" PyObject* PyInit_FuryObject();
 extern "C" PyObject* PyInit_CarObject();
+extern "C" PyObject* PyInit_FuryEnvironment();
+extern "C" PyObject* PyInit_FuryLearning();
+
+
+//! Захват GIL на время работы с Python из любого потока
+class FuryGilLocker
+{
+public:
+    //! Конструктор. Захватывает GIL
+    FuryGilLocker() :
+        m_state(PyGILState_Ensure())
+    {
+
+    }
+
+    //! Деструктор. Отпускает GIL
+    ~FuryGilLocker()
+    {
+        PyGILState_Release(m_state);
+    }
+
+private:
+    //! Состояние захвата
+    PyGILState_STATE m_state;
+};
 
 
 
 FuryScriptManager* FuryScriptManager::s_instance = nullptr;
 
 
-FuryScriptManager::FuryScriptManager()
+FuryScriptManager::FuryScriptManager() :
+    m_mainThreadState(nullptr)
 {
     Debug(ru("Создание менеджера скриптов"));
 
@@ -26,24 +54,36 @@ FuryScriptManager::FuryScriptManager()
     qputenv("PYTHONPATH", ".");
 
     Py_Initialize();
+    PyEval_InitThreads();
 
     object __main__ = object(handle<>(borrowed(PyImport_AddModule("__main__"))));
 
     m_modules.insert("glm", object(handle<>(borrowed(PyInit_glm()))));
     m_modules.insert("FuryObject", object(handle<>(borrowed(PyInit_FuryObject()))));
     m_modules.insert("CarObject", object(handle<>(borrowed(PyInit_CarObject()))));
+    m_modules.insert("FuryEnvironment", object(handle<>(borrowed(PyInit_FuryEnvironment()))));
+    m_modules.insert("FuryLearning", object(handle<>(borrowed(PyInit_FuryLearning()))));
 
     QMapIterator<QString, object> iter(m_modules);
     while (iter.hasNext())
     {
         iter.next();
         objects::add_to_namespace(__main__, qUtf8Printable(iter.key()), iter.value());
+
+        // Чтобы модули были доступны через import из скриптов
+        PyDict_SetItemString(PyImport_GetModuleDict(), qUtf8Printable(iter.key()), iter.value().ptr());
     }
+
+    // Отпускаем GIL: дальше его захватывает каждый вызов менеджера
+    m_mainThreadState = PyEval_SaveThread();
 }
 
 FuryScriptManager::~FuryScriptManager()
 {
     Debug(ru("Удаление менеджера скриптов"));
+
+    // Объекты Python удаляются под GIL
+    PyEval_RestoreThread(m_mainThreadState);
 }
 
 FuryScriptManager *FuryScriptManager::instance()
@@ -80,6 +120,8 @@ void FuryScriptManager::deleteInstance()
 
 void FuryScriptManager::importScript(const QString &_name)
 {
+    FuryGilLocker gilLocker;
+
     if (m_scripts.contains(_name))
     {
         return;
@@ -105,6 +147,8 @@ void FuryScriptManager::importScript(const QString &_name)
 
 void FuryScriptManager::closeScript(const QString &_name)
 {
+    FuryGilLocker gilLocker;
+
     if (!m_scripts.contains(_name))
     {
         return;
@@ -115,6 +159,8 @@ void FuryScriptManager::closeScript(const QString &_name)
 
 void FuryScriptManager::createObject(FuryObject *_object, const QString &_scriptName)
 {
+    FuryGilLocker gilLocker;
+
     if (_object == nullptr || !m_scripts.contains(_scriptName))
     {
         return;
@@ -123,8 +169,15 @@ void FuryScriptManager::createObject(FuryObject *_object, const QString &_script
     try
     {
         object type = m_scripts.value(_scriptName).attr("Behaviour");
-        object pythonObject = type(boost::python::ptr(_object));
-        m_objects.insert(_object, pythonObject);
+
+        // Связанные методы ищем один раз, а не на каждом тике
+        ScriptObject scriptObject;
+        scriptObject.instance = type(boost::python::ptr(_object));
+        scriptObject.start = scriptObject.instance.attr("start");
+        scriptObject.update = scriptObject.instance.attr("update");
+        scriptObject.stop = scriptObject.instance.attr("stop");
+
+        m_objects.insert(_object, scriptObject);
     }
     catch (error_already_set)
     {
@@ -134,6 +187,8 @@ void FuryScriptManager::createObject(FuryObject *_object, const QString &_script
 
 void FuryScriptManager::removeObject(FuryObject *_object)
 {
+    FuryGilLocker gilLocker;
+
     if (!m_objects.contains(_object))
     {
         return;
@@ -144,44 +199,77 @@ void FuryScriptManager::removeObject(FuryObject *_object)
 
 void FuryScriptManager::processStart()
 {
-    foreach (object pythonObject, m_objects)
+    callMethod(&ScriptObject::start);
+}
+
+void FuryScriptManager::processUpdate()
+{
+    callMethod(&ScriptObject::update, true);
+}
+
+void FuryScriptManager::processStop()
+{
+    callMethod(&ScriptObject::stop);
+}
+
+void FuryScriptManager::runEnvironment(const QString &_scriptName, FuryVectorEnvironment *_environment)
+{
+    FuryGilLocker gilLocker;
+
+    importScript(_scriptName);
+
+    if (_environment == nullptr || !m_scripts.contains(_scriptName))
     {
-        try
-        {
-            object startFunc = pythonObject.attr("start");
-            startFunc();
-        }
-        catch (error_already_set)
-        {
-            PyErr_Print();
-        }
+        return;
+    }
+
+    try
+    {
+        object runFunc = m_scripts.value(_scriptName).attr("run");
+        runFunc(boost::python::ptr(_environment));
+    }
+    catch (error_already_set)
+    {
+        PyErr_Print();
     }
 }
 
-void FuryScriptManager::processUpdate()
+void FuryScriptManager::runLearner(const QString &_scriptName, FuryAsyncLearner *_learner)
 {
-    foreach (object pythonObject, m_objects)
+    FuryGilLocker gilLocker;
+
+    importScript(_scriptName);
+
+    if (_learner == nullptr || !m_scripts.contains(_scriptName))
     {
-        try
-        {
-            object startFunc = pythonObject.attr("update");
-            startFunc();
-        }
-        catch (error_already_set)
-        {
-            PyErr_Print();
-        }
+        return;
+    }
+
+    try
+    {
+        object runFunc = m_scripts.value(_scriptName).attr("run");
+        runFunc(boost::python::ptr(_learner));
+    }
+    catch (error_already_set)
+    {
+        PyErr_Print();
     }
 }
 
-void FuryScriptManager::processStop()
+void FuryScriptManager::callMethod(object ScriptObject::* _method, bool _onlyRequired)
 {
-    foreach (object pythonObject, m_objects)
+    FuryGilLocker gilLocker;
+
+    for (QMap<FuryObject*, ScriptObject>::Iterator iter = m_objects.begin(); iter != m_objects.end(); ++iter)
     {
+        if (_onlyRequired && !iter.key()->isScriptUpdateRequired())
+        {
+            continue;
+        }
+
         try
         {
-            object startFunc = pythonObject.attr("stop");
-            startFunc();
+            (iter.value().*_method)();
         }
         catch (error_already_set)
         {
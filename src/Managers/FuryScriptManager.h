@@ -8,9 +8,16 @@
 
 
 class FuryObject;
+class FuryAsyncLearner;
+class FuryVectorEnvironment;
 
 
-//! Менеджер скриптов
+/*!
+ * \brief Менеджер скриптов.
+ *
+ * Главный поток не держит GIL между вызовами: каждый метод захватывает его
+ * сам, поэтому скрипты можно вызывать и из потока обучения (см. FuryAsyncLearner).
+ */
 class FuryScriptManager
 {
 public:
@@ -45,11 +52,27 @@ public:
 
     //! Обработка метода start для объектов-скриптов
     void processStart();
-    //! Обработка метода update для объектов-скриптов
+    //! Обработка метода update для объектов-скриптов, которым нужно новое решение
     void processUpdate();
     //! Обработка метода stop для объектов-скриптов
     void processStop();
 
+    /*!
+     * \brief Запуск обучения на векторной среде: вызов функции run(env) модуля.
+     * Цикл шагов ведёт сам скрипт через env.step(actions)
+     * \param[in] _scriptName - Название модуля скрипта
+     * \param[in] _environment - Векторная среда
+     */
+    void runEnvironment(const QString& _scriptName, FuryVectorEnvironment* _environment);
+
+    /*!
+     * \brief Выполнение функции run(learner) модуля обучения.
+     * Вызывается из потока обучения и возвращается после остановки
+     * \param[in] _scriptName - Название модуля скрипта
+     * \param[in] _learner - Асинхронное обучение
+     */
+    void runLearner(const QString& _scriptName, FuryAsyncLearner* _learner);
+
 private:
     FuryScriptManager();
     ~FuryScriptManager();
@@ -58,13 +81,37 @@ private:
     FuryScriptManager(const FuryScriptManager&) = delete;
     FuryScriptManager& operator=(const FuryScriptManager&) = delete;
 
+private:
+    //! Экземпляр объекта-скрипта с заранее найденными методами
+    struct ScriptObject
+    {
+        //! Экземпляр объекта-скрипта
+        boost::python::object instance;
+        //! Метод start
+        boost::python::object start;
+        //! Метод update
+        boost::python::object update;
+        //! Метод stop
+        boost::python::object stop;
+    };
+
+    /*!
+     * \brief Вызов метода объектов-скриптов
+     * \param[in] _method - Указатель на поле с методом в ScriptObject
+     * \param[in] _onlyRequired - Пропускать объекты, которым вызов сейчас
+     * не нужен (см. FuryObject::isScriptUpdateRequired)
+     */
+    void callMethod(boost::python::object ScriptObject::* _method, bool _onlyRequired = false);
+
 private:
     //! Модули, созданные с обёрткой boost::python для классов C++
     QMap<QString, boost::python::object> m_modules;
     //! Испортированные модули (скрипты)
     QMap<QString, boost::python::object> m_scripts;
     //! Экземпляры объектов-скриптов
-    QMap<FuryObject*, boost::python::object> m_objects;
+    QMap<FuryObject*, ScriptObject> m_objects;
+    //! Состояние главного потока Python, отпустившего GIL
+    PyThreadState* m_mainThreadState;
 };
 
 #endif // FURYSCRIPTMANAGER_H
@@ -8,7 +8,8 @@ FuryShaderManager* FuryShaderManager::s_instance = nullptr;
 
 
 FuryShaderManager::FuryShaderManager() :
-    m_defaultShader(new Shader())
+    m_defaultShader(new Shader()),
+    m_version(0)
 {
     Debug(ru("Создание менеджера шейдеров"));
 }
@@ -76,11 +77,22 @@ Shader *FuryShaderManager::createShader(const QString &_name,
         return m_shaders.value(_name);
     }
 
+#if NEED_OPENGL == 1
     Debug(ru("Создание шейдера: (%1)").arg(_name));
 
     Shader* shader = new Shader(_vertexPath, _fragmentPath, _geometryPath);
     m_shaders.insert(_name, shader);
+    ++m_version;
     return shader;
+#else
+    Q_UNUSED(_vertexPath)
+    Q_UNUSED(_fragmentPath)
+    Q_UNUSED(_geometryPath)
+
+    // Без OpenGL шейдер не собрать, объекты получат шейдер по умолчанию
+    Debug(ru("[ ВНИМАНИЕ ] Шейдер (%1) не создан: сборка без OpenGL").arg(_name));
+    return m_defaultShader;
+#endif
 }
 
 Shader *FuryShaderManager::shaderByName(const QString &_name)
@@ -105,6 +117,7 @@ void FuryShaderManager::deleteShader(const QString &_name)
     Shader* shader = m_shaders.value(_name);
     delete shader;
     m_shaders.remove(_name);
+    ++m_version;
 }
 
 bool FuryShaderManager::containsShader(const QString &_name)
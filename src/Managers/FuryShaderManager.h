@@ -30,6 +30,14 @@ public:
 
     QStringList allShaderNames() const;
 
+    /*!
+     * \brief Получение номера изменения набора шейдеров. Растёт при каждом
+     * создании и удалении шейдера
+     * \return Возвращает номер изменения
+     */
+    inline quint32 version() const
+    { return m_version; }
+
 private:
     FuryShaderManager();
     ~FuryShaderManager();
@@ -41,6 +49,8 @@ private:
 private:
     QMap<QString, Shader*> m_shaders;
     Shader* m_defaultShader;
+    //! Номер изменения набора шейдеров
+    quint32 m_version;
 };
 
 #endif // FURYSHADERMANAGER_H
@@ -139,6 +139,7 @@ QString FuryTextureManager::pathByName(const QString &_name) const
 
 void FuryTextureManager::loadTexturePart()
 {
+#if NEED_OPENGL == 1
     QMutexLocker mutexLocker(&m_bindMutex);
 
     while (!m_textureBindQueue.isEmpty())
@@ -190,6 +191,7 @@ void FuryTextureManager::loadTexturePart()
         Debug(ru("Текстура загружена: (%1) (id %2)").arg(texture->path().section('/', -1, -1))
                                                     .arg(textureID));
     }
+#endif
 }
 
 void FuryTextureManager::stopLoopAndWait()
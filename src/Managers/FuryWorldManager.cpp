@@ -29,6 +29,9 @@ FuryWorldManager::~FuryWorldManager()
 
     m_worlds.clear();
 
+    qDeleteAll(m_isolatedPhysicsCommons);
+    m_isolatedPhysicsCommons.clear();
+
     Debug(ru("Удаление мира по умолчанию"));
     delete m_defaultWorld;
     m_defaultWorld = nullptr;
@@ -88,6 +91,25 @@ FuryWorld &FuryWorldManager::createWorld(const QString &_name)
     return *m_worlds[_name];
 }
 
+FuryWorld &FuryWorldManager::createIsolatedWorld(const QString &_name)
+{
+    QMutexLocker locker(&m_worldsMutex);
+
+    if (m_worlds.contains(_name))
+    {
+        Debug(ru("Попытка повторного создания мира (%1)").arg(_name));
+        return *m_worlds[_name];
+    }
+
+    rp3d::PhysicsCommon* physicsCommon = new rp3d::PhysicsCommon;
+    m_isolatedPhysicsCommons.insert(_name, physicsCommon);
+
+    FuryWorld* newWorld = new FuryWorld(physicsCommon);
+    newWorld->setObjectName(_name);
+    m_worlds.insert(_name, newWorld);
+    return *m_worlds[_name];
+}
+
 FuryWorld &FuryWorldManager::worldByName(const QString &_name) const
 {
     QMutexLocker locker(&m_worldsMutex);
@@ -110,6 +132,9 @@ void FuryWorldManager::deleteWorldByName(const QString &_name)
         delete m_worlds[_name];
         m_worlds[_name] = nullptr;
         m_worlds.remove(_name);
+
+        // Главный объект физики удаляем только после его мира
+        delete m_isolatedPhysicsCommons.take(_name);
     }
     else
     {
@@ -41,6 +41,15 @@ public:
      */
     FuryWorld& createWorld(const QString& _name);
 
+    /*!
+     * \brief Создание изолированного мира со своим главным объектом физики.
+     * Такие миры можно обновлять параллельно в разных потоках: общий
+     * rp3d::PhysicsCommon делит между мирами аллокатор кадра.
+     * \param[in] _name - Название мира
+     * \return Возвращает созданный мир
+     */
+    FuryWorld& createIsolatedWorld(const QString& _name);
+
     /*!
      * \brief Получение мира по названию
      * \param[in] _name - Название мира
@@ -75,7 +84,10 @@ private:
     FuryWorldManager& operator=(const FuryWorldManager&) = delete;
 
 private:
+    //! Главный объект физики, общий для обычных миров
     rp3d::PhysicsCommon* m_physicsCommon;
+    //! Отображение: Название изолированного мира -> Его главный объект физики
+    QMap<QString, rp3d::PhysicsCommon*> m_isolatedPhysicsCommons;
 
     //! Отображение: Название мира -> Мир
     QMap<QString, FuryWorld*> m_worlds;
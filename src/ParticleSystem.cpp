@@ -8,26 +8,28 @@
 static double chance_create_particle = 0.15;
 static double default_particle_size = 1.0;
 
-ParticleSystem::ParticleSystem(glm::vec3& pos, const QString &_textureName, int count) {
+ParticleSystem::ParticleSystem(glm::vec3& pos, const QString &_textureName, int count, quint32 _seed) :
+    m_random(_seed)
+{
     this->position = pos;
     this->m_textureName = _textureName;
     this->count = count;
     this->particle_shader = Shader("particle.vs", "particle.fs");
     //SetupParticleMesh();
 
-    if ((double)(rand() % 100) / 100.0 < chance_create_particle) {
+    if ((double)m_random.bounded(100) / 100.0 < chance_create_particle) {
         glm::vec3 pos = position;
-        pos += glm::vec3((((double)(rand() % 100) / 100.0) * 2 - 1) * 0.5,
-            (((double)(rand() % 100) / 100.0) * 2 - 1) * 0.5,
-            (((double)(rand() % 100) / 100.0) * 2 - 1) * 0.5);
-        glm::vec3 speed((((double)(rand() % 100) / 100.0) * 2 - 1),
-            ((double)(rand() % 100) / 100.0 * 2),
-            (((double)(rand() % 100) / 100.0) * 2 - 1));
+        pos += glm::vec3((((double)m_random.bounded(100) / 100.0) * 2 - 1) * 0.5,
+            (((double)m_random.bounded(100) / 100.0) * 2 - 1) * 0.5,
+            (((double)m_random.bounded(100) / 100.0) * 2 - 1) * 0.5);
+        glm::vec3 speed((((double)m_random.bounded(100) / 100.0) * 2 - 1),
+            ((double)m_random.bounded(100) / 100.0 * 2),
+            (((double)m_random.bounded(100) / 100.0) * 2 - 1));
         glm::vec4 color(0, 1, 0, 1);
 
         double particle_scale = default_particle_size;
 
-        Particle* new_particle = new Particle(pos, particle_scale, speed, color, m_textureName, 2 + (rand() % 10) / 10.0f * 2 - 1.0f, &particle_shader);
+        Particle* new_particle = new Particle(pos, particle_scale, speed, color, m_textureName, 2 + m_random.bounded(10) / 10.0f * 2 - 1.0f, &particle_shader);
         //new_particle.SetMeshBuffers(particleVBO, particleEBO, particleVAO);
         m_particles.push_back(new_particle);
     }
@@ -39,17 +41,17 @@ void ParticleSystem::Tick(float deltaTime) {
 
         if (m_particles[i]->Is_Dead()) {
             glm::vec3 pos = position;
-            pos += glm::vec3((((double)(rand() % 100) / 100.0) * 2 - 1) * 0.5,
-                (((double)(rand() % 100) / 100.0) * 2 - 1) * 0.5,
-                (((double)(rand() % 100) / 100.0) * 2 - 1) * 0.5);
-            glm::vec3 speed((((double)(rand() % 100) / 100.0) * 2 - 1),
-                ((double)(rand() % 100) / 100.0 * 2),
-                (((double)(rand() % 100) / 100.0) * 2 - 1));
+            pos += glm::vec3((((double)m_random.bounded(100) / 100.0) * 2 - 1) * 0.5,
+                (((double)m_random.bounded(100) / 100.0) * 2 - 1) * 0.5,
+                (((double)m_random.bounded(100) / 100.0) * 2 - 1) * 0.5);
+            glm::vec3 speed((((double)m_random.bounded(100) / 100.0) * 2 - 1),
+                ((double)m_random.bounded(100) / 100.0 * 2),
+                (((double)m_random.bounded(100) / 100.0) * 2 - 1));
             glm::vec4 color(0, 1, 0, 1);
 
             double particle_scale = default_particle_size;
 
-            Particle* new_particle = new Particle(pos, particle_scale, speed, color, m_textureName, 2 + (rand() % 10) / 10.0f * 2 - 1.0f, &particle_shader);
+            Particle* new_particle = new Particle(pos, particle_scale, speed, color, m_textureName, 2 + m_random.bounded(10) / 10.0f * 2 - 1.0f, &particle_shader);
             //new_particle.SetMeshBuffers(particleVBO, particleEBO, particleVAO);
             delete m_particles[i];
             m_particles[i] = new_particle;
@@ -61,19 +63,19 @@ void ParticleSystem::Tick(float deltaTime) {
     }
 
     if (m_particles.size() < count) {
-        if ((double)(rand() % 100) / 100.0 < chance_create_particle) {
+        if ((double)m_random.bounded(100) / 100.0 < chance_create_particle) {
             glm::vec3 pos = position;
-            pos += glm::vec3((((double)(rand() % 100) / 100.0) * 2 - 1) * 0.5,
-                (((double)(rand() % 100) / 100.0) * 2 - 1) * 0.5,
-                (((double)(rand() % 100) / 100.0) * 2 - 1) * 0.5);
-            glm::vec3 speed((((double)(rand() % 100) / 100.0) * 2 - 1),
-                ((double)(rand() % 100) / 100.0 * 2),
-                (((double)(rand() % 100) / 100.0) * 2 - 1));
+            pos += glm::vec3((((double)m_random.bounded(100) / 100.0) * 2 - 1) * 0.5,
+                (((double)m_random.bounded(100) / 100.0) * 2 - 1) * 0.5,
+                (((double)m_random.bounded(100) / 100.0) * 2 - 1) * 0.5);
+            glm::vec3 speed((((double)m_random.bounded(100) / 100.0) * 2 - 1),
+                ((double)m_random.bounded(100) / 100.0 * 2),
+                (((double)m_random.bounded(100) / 100.0) * 2 - 1));
             glm::vec4 color(0, 1, 0, 1);
 
             double particle_scale = default_particle_size;
 
-            Particle* new_particle = new Particle(pos, particle_scale, speed, color, m_textureName, 2 + (rand() % 10) / 10.0f * 2 - 1.0f, &particle_shader);
+            Particle* new_particle = new Particle(pos, particle_scale, speed, color, m_textureName, 2 + m_random.bounded(10) / 10.0f * 2 - 1.0f, &particle_shader);
             //new_particle.SetMeshBuffers(particleVBO, particleEBO, particleVAO);
             m_particles.push_back(new_particle);
         }
@@ -3,13 +3,22 @@
 
 
 #include <QVector>
+#include <QRandomGenerator>
 
 #include "Shader.h"
 #include "Particle.h"
 
 class ParticleSystem {
 public:
-    ParticleSystem(glm::vec3& position, const QString& _textureName, int count);
+    /*!
+     * \brief Конструктор
+     * \param[in] position - Позиция источника
+     * \param[in] _textureName - Название текстуры частиц
+     * \param[in] count - Наибольшее количество частиц
+     * \param[in] _seed - Зерно генератора частиц. Свой генератор вместо
+     * общего rand(), чтобы не сбивать последовательности других систем
+     */
+    ParticleSystem(glm::vec3& position, const QString& _textureName, int count, quint32 _seed = 1);
     void Tick(float deltaTime);
     void Draw(Camera& camera, int width, int height);
     QVector<Particle*> m_particles;
@@ -21,6 +30,8 @@ private:
     QString m_textureName;
     int count;
     Shader particle_shader;
+    //! Генератор случайных чисел частиц
+    QRandomGenerator m_random;
 
     unsigned int particleVBO, particleEBO, particleVAO;
 };
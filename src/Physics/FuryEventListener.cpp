@@ -3,67 +3,34 @@
 #include "FuryObject.h"
 #include "CarObject.h"
 
-#include <QDebug>
+#include <reactphysics3d/reactphysics3d.h>
 
-FuryEventListener::FuryEventListener() :
-    m_carObject(nullptr)
+FuryEventListener::FuryEventListener()
 {
 
 }
 
-void FuryEventListener::setCarObject(CarObject *_carObject)
-{
-    m_carObject = _carObject;
-}
-
 void FuryEventListener::onContact(const CallbackData &_callbackData)
 {
-    // For each contact pair
-    for (uint p = 0; p < _callbackData.getNbContactPairs(); p++) {
-
-        // Get the contact pair
+    for (uint p = 0; p < _callbackData.getNbContactPairs(); p++)
+    {
         CollisionCallback::ContactPair contactPair = _callbackData.getContactPair(p);
 
-        FuryObject* tempObj = static_cast<FuryObject*>(contactPair.getBody1()->getUserData());
-
-//        if (tempObj != nullptr)
-//        {
-//            qDebug() << "body1" << tempObj->name();
-//        }
-//        else
-//        {
-//            qDebug() << "body1" << "nullptr";
-//        }
-
-        tempObj = static_cast<FuryObject*>(contactPair.getBody2()->getUserData());
-
-//        if (tempObj != nullptr)
-//        {
-//            qDebug() << "body2" << tempObj->name();
-//        }
-//        else
-//        {
-//            qDebug() << "body2" << "nullptr";
-//        }
-
-        // For each contact point of the contact pair
-        for (uint c = 0; c < contactPair.getNbContactPoints(); c++) {
-
-            // Get the contact point
-            CollisionCallback::ContactPoint contactPoint = contactPair.getContactPoint(c);
-
-            // Get the contact point on the first collider and convert it in world-space
-//            reactphysics3d::Vector3 worldPoint = contactPair.getCollider1()->getLocalToWorldTransform()
-//                    * contactPoint.getLocalPointOnCollider1();
+        if (contactPair.getNbContactPoints() == 0)
+        {
+            continue;
+        }
 
-//            qDebug() << worldPoint.x
-//                     << worldPoint.y
-//                     << worldPoint.z;
+        // Контакт засчитывается каждой машине пары. Две машины в одной паре
+        // бывают только без режима призраков
+        if (CarObject* car = carByBody(contactPair.getBody1()))
+        {
+            car->onContact();
+        }
 
-            if (m_carObject != nullptr)
-            {
-                m_carObject->onContact();
-            }
+        if (CarObject* car = carByBody(contactPair.getBody2()))
+        {
+            car->onContact();
         }
     }
 }
@@ -83,64 +50,45 @@ void FuryEventListener::onTrigger(const reactphysics3d::OverlapCallback::Callbac
             continue;
         }
 
+        CarObject* car = carByBody(overlapPair.getBody1());
+        FuryObject* trigger = static_cast<FuryObject*>(overlapPair.getBody2()->getUserData());
 
-        FuryObject* tempObj1 = static_cast<FuryObject*>(overlapPair.getBody1()->getUserData());
-        FuryObject* tempObj2 = static_cast<FuryObject*>(overlapPair.getBody2()->getUserData());
-
-        if (tempObj2->objectName() == "AI_car")
+        if (car == nullptr)
         {
-            FuryObject* tempObj3 = tempObj1;
-            tempObj1 = tempObj2;
-            tempObj2 = tempObj3;
+            car = carByBody(overlapPair.getBody2());
+            trigger = static_cast<FuryObject*>(overlapPair.getBody1()->getUserData());
         }
-        else if (tempObj1->objectName() != "AI_car")
+
+        if (car == nullptr || trigger == nullptr)
         {
-            // Столкновение колёс, их не считаем
+            // Пересечение без машины, например колёс. Его не считаем
             continue;
         }
 
-
-
-
         if (eventType == reactphysics3d::OverlapCallback::OverlapPair::EventType::OverlapStart)
         {
-//            qDebug() << "EventType::OverlapStart";
-//            tempObj2->setTextureName("greenCheckBox");
-            tempObj2->setMaterialName("greenRaceTriggerMaterial");
+            trigger->setMaterialName("greenRaceTriggerMaterial");
 
-            if (m_carObject != nullptr)
+            if (trigger->objectTag() == FuryObject::TagTrigger)
             {
-                int number = tempObj2->objectName().split(' ').last().toInt();
-                m_carObject->onTrigger(number);
+                car->onTrigger(trigger->tagNumber());
             }
         }
         else if (eventType == reactphysics3d::OverlapCallback::OverlapPair::EventType::OverlapExit)
         {
-//            qDebug() << "EventType::OverlapExit";
-//            tempObj2->setTextureName("redCheckBox");
-            tempObj2->setMaterialName("redRaceTriggerMaterial");
-        }
-        else
-        {
-//            qDebug() << "EventType::OverlapStay";
+            trigger->setMaterialName("redRaceTriggerMaterial");
         }
+    }
+}
 
-        if (tempObj1 != nullptr)
-        {
-//            qDebug() << "body1" << tempObj1->name();
-        }
-        else
-        {
-//            qDebug() << "body1" << "nullptr";
-        }
+CarObject *FuryEventListener::carByBody(reactphysics3d::CollisionBody *_body)
+{
+    FuryObject* object = static_cast<FuryObject*>(_body->getUserData());
 
-        if (tempObj2 != nullptr)
-        {
-//            qDebug() << "body2" << tempObj2->name();
-        }
-        else
-        {
-//            qDebug() << "body2" << "nullptr";
-        }
+    if (object == nullptr || object->objectTag() != FuryObject::TagCar)
+    {
+        return nullptr;
     }
+
+    return qobject_cast<CarObject*>(object);
 }
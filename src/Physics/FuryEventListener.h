@@ -3,21 +3,26 @@
 
 #include <reactphysics3d/engine/EventListener.h>
 
+namespace reactphysics3d
+{
+    class CollisionBody;
+}
+
 class CarObject;
 
-//! Класс прослушивания событий физического движка
+/*!
+ * \brief Класс прослушивания событий физического движка.
+ *
+ * Контакты и триггеры отправляются той машине, чьё тело участвует в событии.
+ * Машина находится по пользовательским данным тела, поэтому в одном мире
+ * может ездить сколько угодно машин.
+ */
 class FuryEventListener : public reactphysics3d::EventListener
 {
 public:
     //! Конструктор
     FuryEventListener();
 
-    /*!
-     * \brief Установка объекта машины
-     * \param[in] _carObject - Объект машины
-     */
-    void setCarObject(CarObject* _carObject);
-
     /*!
      * \brief Вызывается при возникновении некоторых контактов
      * \param[in] _callbackData - Информация обо всех контактах
@@ -31,8 +36,12 @@ public:
     void onTrigger(const reactphysics3d::OverlapCallback::CallbackData & _callbackData) override;
 
 private:
-    //! Объект машины. Чтобы напрямую отправлять информацию для обучения.
-    CarObject* m_carObject;
+    /*!
+     * \brief Получение машины по телу физики
+     * \param[in] _body - Тело
+     * \return Возвращает машину или nullptr, если тело не машины
+     */
+    static CarObject* carByBody(reactphysics3d::CollisionBody* _body);
 };
 
 #endif // FURYEVENTLISTENER_H
@@ -0,0 +1,194 @@
+#include "FuryRaySensor.h"
+
+#include "FuryWorld.h"
+#include "FuryObject.h"
+
+
+FuryRaySensor::FuryRaySensor(FuryWorld *_world) :
+    m_world(_world),
+    m_dirty(true)
+{
+
+}
+
+void FuryRaySensor::raycast(const Ray *_rays, int _count, float *_result, rp3d::Vector3 *_normals)
+{
+    if (_count <= 0)
+    {
+        return;
+    }
+
+    if (m_dirty)
+    {
+        rebuild();
+    }
+
+    updateDynamicBounds();
+
+    int groupStart = 0;
+
+    while (groupStart < _count)
+    {
+        // Группа - подряд идущие лучи одного тела, обычно одной машины
+        const rp3d::CollisionBody* owner = _rays[groupStart].ignoreBody;
+        rp3d::Vector3 groupMin = rp3d::Vector3::min(_rays[groupStart].start, _rays[groupStart].end);
+        rp3d::Vector3 groupMax = rp3d::Vector3::max(_rays[groupStart].start, _rays[groupStart].end);
+        int groupEnd = groupStart + 1;
+
+        while (groupEnd < _count && _rays[groupEnd].ignoreBody == owner)
+        {
+            groupMin = rp3d::Vector3::min(groupMin, rp3d::Vector3::min(_rays[groupEnd].start, _rays[groupEnd].end));
+            groupMax = rp3d::Vector3::max(groupMax, rp3d::Vector3::max(_rays[groupEnd].start, _rays[groupEnd].end));
+            ++groupEnd;
+        }
+
+        collectCandidates(rp3d::AABB(groupMin, groupMax));
+
+        for (int i = groupStart; i < groupEnd; ++i)
+        {
+            castRay(_rays[i], _result + 2 * i, (_normals != nullptr) ? _normals + i : nullptr);
+        }
+
+        groupStart = groupEnd;
+    }
+}
+
+void FuryRaySensor::castRay(const Ray &_ray, float *_result, rp3d::Vector3 *_normal)
+{
+    rp3d::Vector3 direction = _ray.end - _ray.start;
+    rp3d::Vector3 directionInverse(1 / direction.x, 1 / direction.y, 1 / direction.z);
+
+    float hitFraction = 1;
+    rp3d::Vector3 normal(0, 1, 0);
+
+    for (const ColliderEntry& entry : m_candidates)
+    {
+        if (entry.body != _ray.ignoreBody && (entry.categoryBits & _ray.categoryMask) != 0)
+        {
+            raycastCollider(entry, _ray, directionInverse, hitFraction, normal);
+        }
+    }
+
+    bool needTriggered = false;
+
+    if (_ray.needTriggerNumber >= 0)
+    {
+        const QVector<int> triggerIndices = m_triggersByNumber.value(_ray.needTriggerNumber);
+
+        for (int index : triggerIndices)
+        {
+            float triggerFraction = hitFraction;
+            rp3d::Vector3 triggerNormal;
+
+            if (raycastCollider(m_triggerColliders[index], _ray, directionInverse,
+                                triggerFraction, triggerNormal))
+            {
+                needTriggered = true;
+                break;
+            }
+        }
+    }
+
+    _result[0] = hitFraction;
+    _result[1] = needTriggered ? 1.0f : -1.0f;
+
+    if (_normal != nullptr)
+    {
+        *_normal = normal;
+    }
+}
+
+void FuryRaySensor::rebuild()
+{
+    m_solidColliders.clear();
+    m_triggerColliders.clear();
+    m_triggersByNumber.clear();
+
+    for (FuryObject* object : m_world->getAllObjects())
+    {
+        addBodyColliders(object->physicsBody(), object->tagNumber());
+    }
+
+    // Объединённая статическая геометрия трассы. Триггеров в ней нет
+    if (m_world->trackBody() != nullptr)
+    {
+        addBodyColliders(m_world->trackBody(), -1);
+    }
+
+    m_dirty = false;
+}
+
+void FuryRaySensor::addBodyColliders(rp3d::RigidBody *_body, int _tagNumber)
+{
+    for (rp3d::uint i = 0; i < _body->getNbColliders(); ++i)
+    {
+        ColliderEntry entry;
+        entry.collider = _body->getCollider(i);
+        entry.body = _body;
+        entry.aabb = entry.collider->getWorldAABB();
+        entry.isStatic = (_body->getType() == rp3d::BodyType::STATIC);
+        entry.categoryBits = entry.collider->getCollisionCategoryBits();
+
+        if ((entry.categoryBits & FuryObject::CategoryDebug) != 0)
+        {
+            continue;
+        }
+
+        if ((entry.categoryBits & FuryObject::CategoryTrigger) != 0)
+        {
+            m_triggersByNumber[_tagNumber].append(m_triggerColliders.size());
+            m_triggerColliders.append(entry);
+        }
+        else
+        {
+            m_solidColliders.append(entry);
+        }
+    }
+}
+
+void FuryRaySensor::updateDynamicBounds()
+{
+    // Границы подвижных тел меняются каждый тик
+    for (ColliderEntry& entry : m_solidColliders)
+    {
+        if (!entry.isStatic)
+        {
+            entry.aabb = entry.collider->getWorldAABB();
+        }
+    }
+}
+
+void FuryRaySensor::collectCandidates(const rp3d::AABB &_groupAABB)
+{
+    m_candidates.clear();
+
+    for (const ColliderEntry& entry : m_solidColliders)
+    {
+        if (_groupAABB.testCollision(entry.aabb))
+        {
+            m_candidates.append(entry);
+        }
+    }
+}
+
+bool FuryRaySensor::raycastCollider(const ColliderEntry &_entry, const Ray &_ray,
+                                    const rp3d::Vector3 &_directionInverse,
+                                    float &_hitFraction, rp3d::Vector3 &_normal) const
+{
+    if (!_entry.aabb.testRayIntersect(_ray.start, _directionInverse, _hitFraction))
+    {
+        return false;
+    }
+
+    rp3d::RaycastInfo info;
+
+    if (!_entry.collider->raycast(rp3d::Ray(_ray.start, _ray.end, _hitFraction), info)
+            || info.hitFraction >= _hitFraction)
+    {
+        return false;
+    }
+
+    _hitFraction = info.hitFraction;
+    _normal = info.worldNormal;
+    return true;
+}
@@ -0,0 +1,134 @@
+#ifndef FURYRAYSENSOR_H
+#define FURYRAYSENSOR_H
+
+#include <reactphysics3d/reactphysics3d.h>
+
+#include <QHash>
+#include <QVector>
+
+class FuryWorld;
+
+
+/*!
+ * \brief Пакетный датчик лучей.
+ *
+ * Вместо отдельного PhysicsWorld::raycast на каждый луч кэширует коллайдеры
+ * мира и границы статических коллайдеров. Лучи пакета делятся на группы:
+ * подряд идущие лучи с одним ignoreBody, то есть лучи одной машины. Для каждой
+ * группы отбираются коллайдеры, попадающие в её границы, и лучи группы
+ * проверяются только по ним. Так пакет со всех машин трассы не сводится
+ * к проверке каждого луча по всем коллайдерам. Триггеры трассы лучи
+ * не останавливают, а только отмечаются.
+ */
+class FuryRaySensor
+{
+public:
+    //! Луч пакетного запроса
+    struct Ray
+    {
+        //! Начало луча (в глобальных координатах)
+        rp3d::Vector3 start;
+        //! Конец луча (в глобальных координатах)
+        rp3d::Vector3 end;
+        //! Номер триггера, пересечение с которым надо отметить. -1 - не отмечать
+        int needTriggerNumber = -1;
+        //! Тело, которое луч не видит. Обычно сама машина
+        const rp3d::CollisionBody* ignoreBody = nullptr;
+        //! Категории тел (FuryObject::CollisionCategory), которые останавливают луч
+        unsigned short categoryMask = 0xFFFF;
+    };
+
+    /*!
+     * \brief Конструктор
+     * \param[in] _world - Мир
+     */
+    explicit FuryRaySensor(FuryWorld* _world);
+
+    //! Сброс кэша коллайдеров. Он будет собран заново при следующем запросе
+    inline void invalidate()
+    { m_dirty = true; }
+
+    /*!
+     * \brief Пакетный raycast. Лучи одного тела должны идти подряд
+     * \param[in] _rays - Лучи
+     * \param[in] _count - Количество лучей
+     * \param[out] _result - 2 * _count значений: для каждого луча доля длины до
+     * препятствия [0; 1] и признак пересечения нужного триггера до препятствия (1 / -1)
+     * \param[out] _normals - Нормали в точках пересечения, _count значений. Может быть nullptr
+     */
+    void raycast(const Ray* _rays, int _count, float* _result, rp3d::Vector3* _normals = nullptr);
+
+private:
+    //! Коллайдер в кэше датчика
+    struct ColliderEntry
+    {
+        //! Коллайдер
+        rp3d::Collider* collider;
+        //! Тело коллайдера
+        const rp3d::CollisionBody* body;
+        //! Границы коллайдера. Для статических тел кэшируются
+        rp3d::AABB aabb;
+        //! Статическое ли тело
+        bool isStatic;
+        //! Биты категории столкновений коллайдера
+        unsigned short categoryBits;
+    };
+
+    //! Сборка кэша коллайдеров мира
+    void rebuild();
+
+    /*!
+     * \brief Добавление коллайдеров тела в кэш
+     * \param[in] _body - Тело
+     * \param[in] _tagNumber - Номер триггера для коллайдеров-триггеров
+     */
+    void addBodyColliders(rp3d::RigidBody* _body, int _tagNumber);
+
+    //! Обновление границ коллайдеров подвижных тел. Вызывается раз на пакет
+    void updateDynamicBounds();
+
+    /*!
+     * \brief Отбор коллайдеров, попадающих в границы группы лучей
+     * \param[in] _groupAABB - Границы всех лучей группы
+     */
+    void collectCandidates(const rp3d::AABB& _groupAABB);
+
+    /*!
+     * \brief Проверка луча по коллайдерам текущей группы и нужному триггеру
+     * \param[in] _ray - Луч
+     * \param[out] _result - 2 значения: доля длины до препятствия и признак триггера
+     * \param[out] _normal - Нормаль в точке пересечения. Может быть nullptr
+     */
+    void castRay(const Ray& _ray, float* _result, rp3d::Vector3* _normal);
+
+    /*!
+     * \brief Проверка пересечения луча с коллайдером
+     * \param[in] _entry - Коллайдер
+     * \param[in] _ray - Луч
+     * \param[in] _directionInverse - Обратное направление луча
+     * \param[in,out] _hitFraction - Доля длины до ближайшего пересечения
+     * \param[out] _normal - Нормаль в точке пересечения
+     * \return Возвращает признак пересечения ближе _hitFraction
+     */
+    bool raycastCollider(const ColliderEntry& _entry, const Ray& _ray,
+                         const rp3d::Vector3& _directionInverse,
+                         float& _hitFraction, rp3d::Vector3& _normal) const;
+
+private:
+    //! Мир
+    FuryWorld* m_world;
+    //! Признак устаревшего кэша
+    bool m_dirty;
+
+    //! Коллайдеры, останавливающие лучи. Отладочные тела в кэш не попадают
+    QVector<ColliderEntry> m_solidColliders;
+    //! Коллайдеры триггеров
+    QVector<ColliderEntry> m_triggerColliders;
+    //! Отображение: Номер триггера -> Индексы в m_triggerColliders
+    QHash<int, QVector<int>> m_triggersByNumber;
+
+    //! Коллайдеры текущей группы лучей. Переиспользуется между запросами
+    QVector<ColliderEntry> m_candidates;
+};
+
+#endif // FURYRAYSENSOR_H
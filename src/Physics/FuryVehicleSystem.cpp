@@ -0,0 +1,393 @@
+#include "FuryVehicleSystem.h"
+
+#include "CarObject.h"
+#include "FuryWorld.h"
+
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+
+//! Коэффициент демпфера подвески
+static const float damperK = 20;
+//! Угол увода, на котором боковая сила шины достигает силы подвески
+static const float slipAnglePeak = 8.0f / 180.0f * 3.14f;
+//! Наибольшее отношение боковой силы шины к силе подвески
+static const float slipLimit = 2;
+//! Коэффициент сопротивления качению и воздуха
+static const float dragK = 0.003f;
+//! Наибольший квадрат продольной скорости колеса для сопротивления
+static const float dragVelocityLimit = 1000;
+//! Множитель силы тяги к силе подвески
+static const float tractionK = 1.5f;
+
+
+#if defined(__SSE2__) || defined(_M_X64)
+
+typedef __m128 SimdFloat;
+//! Ширина регистра SIMD в float
+static const int simdWidth = 4;
+
+static inline SimdFloat simdLoad(const float* _data)
+{ return _mm_loadu_ps(_data); }
+
+static inline void simdStore(float* _data, SimdFloat _value)
+{ _mm_storeu_ps(_data, _value); }
+
+static inline SimdFloat simdSet(float _value)
+{ return _mm_set1_ps(_value); }
+
+static inline SimdFloat simdAdd(SimdFloat _a, SimdFloat _b)
+{ return _mm_add_ps(_a, _b); }
+
+static inline SimdFloat simdSub(SimdFloat _a, SimdFloat _b)
+{ return _mm_sub_ps(_a, _b); }
+
+static inline SimdFloat simdMul(SimdFloat _a, SimdFloat _b)
+{ return _mm_mul_ps(_a, _b); }
+
+static inline SimdFloat simdDiv(SimdFloat _a, SimdFloat _b)
+{ return _mm_div_ps(_a, _b); }
+
+static inline SimdFloat simdMin(SimdFloat _a, SimdFloat _b)
+{ return _mm_min_ps(_a, _b); }
+
+static inline SimdFloat simdMax(SimdFloat _a, SimdFloat _b)
+{ return _mm_max_ps(_a, _b); }
+
+static inline SimdFloat simdSqrt(SimdFloat _a)
+{ return _mm_sqrt_ps(_a); }
+
+static inline SimdFloat simdAbs(SimdFloat _a)
+{ return _mm_andnot_ps(_mm_set1_ps(-0.0f), _a); }
+
+//! Маска: все биты дорожки установлены, если _a < _b
+static inline SimdFloat simdLess(SimdFloat _a, SimdFloat _b)
+{ return _mm_cmplt_ps(_a, _b); }
+
+//! Маска: все биты дорожки установлены, если _a != _b
+static inline SimdFloat simdNotEqual(SimdFloat _a, SimdFloat _b)
+{ return _mm_cmpneq_ps(_a, _b); }
+
+//! Выбор по маске: _a, где маска установлена, иначе _b
+static inline SimdFloat simdSelect(SimdFloat _mask, SimdFloat _a, SimdFloat _b)
+{ return _mm_or_ps(_mm_and_ps(_mask, _a), _mm_andnot_ps(_mask, _b)); }
+
+#else
+
+typedef float SimdFloat;
+//! Ширина регистра SIMD в float
+static const int simdWidth = 1;
+
+static inline SimdFloat simdLoad(const float* _data)
+{ return *_data; }
+
+static inline void simdStore(float* _data, SimdFloat _value)
+{ *_data = _value; }
+
+static inline SimdFloat simdSet(float _value)
+{ return _value; }
+
+static inline SimdFloat simdAdd(SimdFloat _a, SimdFloat _b)
+{ return _a + _b; }
+
+static inline SimdFloat simdSub(SimdFloat _a, SimdFloat _b)
+{ return _a - _b; }
+
+static inline SimdFloat simdMul(SimdFloat _a, SimdFloat _b)
+{ return _a * _b; }
+
+static inline SimdFloat simdDiv(SimdFloat _a, SimdFloat _b)
+{ return _a / _b; }
+
+static inline SimdFloat simdMin(SimdFloat _a, SimdFloat _b)
+{ return (_a < _b) ? _a : _b; }
+
+static inline SimdFloat simdMax(SimdFloat _a, SimdFloat _b)
+{ return (_a > _b) ? _a : _b; }
+
+static inline SimdFloat simdSqrt(SimdFloat _a)
+{ return std::sqrt(_a); }
+
+static inline SimdFloat simdAbs(SimdFloat _a)
+{ return std::fabs(_a); }
+
+//! Маска: 1, если _a < _b, иначе 0
+static inline SimdFloat simdLess(SimdFloat _a, SimdFloat _b)
+{ return (_a < _b) ? 1.0f : 0.0f; }
+
+//! Маска: 1, если _a != _b, иначе 0
+static inline SimdFloat simdNotEqual(SimdFloat _a, SimdFloat _b)
+{ return (_a != _b) ? 1.0f : 0.0f; }
+
+//! Выбор по маске: _a, где маска установлена, иначе _b
+static inline SimdFloat simdSelect(SimdFloat _mask, SimdFloat _a, SimdFloat _b)
+{ return (_mask != 0) ? _a : _b; }
+
+#endif
+
+/*!
+ * \brief Арктангенс для |_x| <= tan(slipLimit * slipAnglePeak) ~ 0.29.
+ * Ряд Тейлора до x^9, ошибка порядка 1e-7 радиана
+ * \param[in] _x - Аргумент
+ * \return Возвращает арктангенс
+ */
+static inline SimdFloat simdAtanSmall(SimdFloat _x)
+{
+    SimdFloat x2 = simdMul(_x, _x);
+    SimdFloat poly = simdSet(1.0f / 9);
+    poly = simdSub(simdSet(1.0f / 7), simdMul(x2, poly));
+    poly = simdSub(simdSet(1.0f / 5), simdMul(x2, poly));
+    poly = simdSub(simdSet(1.0f / 3), simdMul(x2, poly));
+    poly = simdSub(simdSet(1.0f), simdMul(x2, poly));
+    return simdMul(_x, poly);
+}
+
+
+FuryVehicleSystem::FuryVehicleSystem(FuryWorld *_world) :
+    m_world(_world),
+    m_ghostMode(false),
+    m_paddedCount(0)
+{
+
+}
+
+void FuryVehicleSystem::addVehicle(CarObject *_car)
+{
+    m_vehicles.append(_car);
+    _car->setCollideWithMask(ghostCollideMask());
+}
+
+void FuryVehicleSystem::removeVehicle(CarObject *_car)
+{
+    m_vehicles.removeOne(_car);
+}
+
+void FuryVehicleSystem::setGhostMode(bool _ghostMode)
+{
+    m_ghostMode = _ghostMode;
+
+    for (CarObject* car : m_vehicles)
+    {
+        car->setCollideWithMask(ghostCollideMask());
+    }
+}
+
+unsigned short FuryVehicleSystem::ghostCollideMask() const
+{
+    if (m_ghostMode)
+    {
+        return FuryObject::collideAllMask & ~FuryObject::CategoryCar;
+    }
+
+    return FuryObject::collideAllMask;
+}
+
+void FuryVehicleSystem::tick(double _dt)
+{
+    if (m_vehicles.isEmpty())
+    {
+        return;
+    }
+
+    gatherWheels();
+    computeForces(float(_dt));
+    applyForces();
+}
+
+void FuryVehicleSystem::gatherWheels()
+{
+    int wheelCount = 0;
+
+    for (CarObject* car : m_vehicles)
+    {
+        wheelCount += car->wheels().size();
+    }
+
+    m_rays.resize(wheelCount);
+    m_rayResults.resize(2 * wheelCount);
+    m_normals.resize(wheelCount);
+
+    int index = 0;
+
+    for (CarObject* car : m_vehicles)
+    {
+        for (FuryObject* wheel : car->wheels())
+        {
+            const glm::vec3& position = wheel->worldPosition();
+
+            FuryRaySensor::Ray& ray = m_rays[index];
+            ray.start = rp3d::Vector3(position.x, position.y, position.z);
+            ray.end = wheel->physicsBody()->getWorldPoint(rp3d::Vector3(0, -car->springLenght(), 0));
+            ray.ignoreBody = car->physicsBody();
+            ray.categoryMask = rayMask();
+            ++index;
+        }
+    }
+
+    // Лучи колёс одной машины идут подряд: датчик отбирает коллайдеры
+    // по границам каждой машины, а не всего пакета
+    m_world->raySensor()->raycast(m_rays.constData(), wheelCount, m_rayResults.data(), m_normals.data());
+
+    // Хвост до кратного ширине SIMD заполняется колёсами в воздухе
+    m_paddedCount = (wheelCount + simdWidth - 1) / simdWidth * simdWidth;
+
+    QVector<float>* arrays[] = { &m_fraction, &m_normalX, &m_normalY, &m_normalZ,
+                                 &m_velocityX, &m_velocityZ, &m_forwardInput,
+                                 &m_springLenght, &m_springK, &m_lastLenght,
+                                 &m_forceX, &m_forceY, &m_forceZ };
+
+    for (QVector<float>* array : arrays)
+    {
+        array->fill(0, m_paddedCount);
+    }
+
+    for (int i = wheelCount; i < m_paddedCount; ++i)
+    {
+        m_fraction[i] = 1;
+        m_normalY[i] = 1;
+        m_springLenght[i] = 1;
+        m_lastLenght[i] = 1;
+    }
+
+    index = 0;
+
+    for (CarObject* car : m_vehicles)
+    {
+        const QVector<FuryObject*>& wheels = car->wheels();
+        rp3d::Quaternion steerInverse = rp3d::Quaternion::fromEulerAngles(0, car->steerAngle(), 0).getInverse();
+
+        for (int i = 0; i < wheels.size(); ++i)
+        {
+            rp3d::RigidBody* wheelBody = wheels[i]->physicsBody();
+            rp3d::Vector3 localVelocity = wheelBody->getLocalVector(wheelBody->getLinearVelocity());
+
+            if (i < CarObject::steeredWheelCount && car->steerAngle() != 0)
+            {
+                // Скорость в осях повёрнутого колеса без изменения трансформации тела
+                localVelocity = steerInverse * localVelocity;
+            }
+
+            m_fraction[index] = m_rayResults[2 * index];
+            m_normalX[index] = m_normals[index].x;
+            m_normalY[index] = m_normals[index].y;
+            m_normalZ[index] = m_normals[index].z;
+            m_velocityX[index] = localVelocity.x;
+            m_velocityZ[index] = localVelocity.z;
+            m_forwardInput[index] = car->forwardInput();
+            m_springLenght[index] = car->springLenght();
+            m_springK[index] = car->springK();
+            m_lastLenght[index] = car->lastSuspentionLenght(i);
+            ++index;
+        }
+    }
+}
+
+void FuryVehicleSystem::computeForces(float _dt)
+{
+    const SimdFloat zero = simdSet(0);
+    const SimdFloat one = simdSet(1);
+    const SimdFloat minusOne = simdSet(-1);
+    const SimdFloat hitLimit = simdSet(1 - rp3d::MACHINE_EPSILON);
+    const SimdFloat damper = simdSet(damperK / _dt);
+    const SimdFloat slipScale = simdSet(1 / slipAnglePeak);
+    const SimdFloat slipMax = simdSet(slipLimit);
+    const SimdFloat slipMin = simdSet(-slipLimit);
+    // Дальше tan(slipLimit * slipAnglePeak) боковая сила всё равно упирается в предел
+    const SimdFloat ratioMax = simdSet(std::tan(slipLimit * slipAnglePeak));
+    const SimdFloat ratioMin = simdSet(-std::tan(slipLimit * slipAnglePeak));
+    const SimdFloat tiny = simdSet(1e-30f);
+    const SimdFloat traction = simdSet(tractionK);
+    const SimdFloat drag = simdSet(-dragK);
+    const SimdFloat dragLimit = simdSet(dragVelocityLimit);
+
+    for (int i = 0; i < m_paddedCount; i += simdWidth)
+    {
+        SimdFloat fraction = simdLoad(m_fraction.constData() + i);
+        SimdFloat nx = simdLoad(m_normalX.constData() + i);
+        SimdFloat ny = simdLoad(m_normalY.constData() + i);
+        SimdFloat nz = simdLoad(m_normalZ.constData() + i);
+        SimdFloat vx = simdLoad(m_velocityX.constData() + i);
+        SimdFloat vz = simdLoad(m_velocityZ.constData() + i);
+        SimdFloat springLenght = simdLoad(m_springLenght.constData() + i);
+        SimdFloat lastLenght = simdLoad(m_lastLenght.constData() + i);
+
+        // Подвеска: пружина и демпфер
+        SimdFloat hit = simdLess(fraction, hitLimit);
+        SimdFloat currentLenght = simdMul(springLenght, fraction);
+        SimdFloat force = simdMul(simdLoad(m_springK.constData() + i), simdSub(springLenght, currentLenght));
+        force = simdAdd(force, simdMul(simdSub(lastLenght, currentLenght), damper));
+
+        // Оси колеса (1, 0, 0) и (0, 0, 1), спроецированные на плоскость дороги
+        SimdFloat forwardX = simdSub(one, simdMul(nx, nx));
+        SimdFloat forwardY = simdMul(simdSub(zero, nx), ny);
+        SimdFloat forwardZ = simdMul(simdSub(zero, nx), nz);
+        SimdFloat forwardInverse = simdDiv(one, simdSqrt(simdAdd(simdAdd(simdMul(forwardX, forwardX),
+                                                                         simdMul(forwardY, forwardY)),
+                                                                 simdMul(forwardZ, forwardZ))));
+
+        SimdFloat rightX = simdMul(simdSub(zero, nz), nx);
+        SimdFloat rightY = simdMul(simdSub(zero, nz), ny);
+        SimdFloat rightZ = simdSub(one, simdMul(nz, nz));
+        SimdFloat rightInverse = simdDiv(one, simdSqrt(simdAdd(simdAdd(simdMul(rightX, rightX),
+                                                                       simdMul(rightY, rightY)),
+                                                               simdMul(rightZ, rightZ))));
+
+        // Боковая сила по углу увода
+        SimdFloat ratio = simdDiv(simdSub(zero, vz), simdMax(simdAbs(vx), tiny));
+        ratio = simdSelect(simdNotEqual(vx, zero), ratio, zero);
+        ratio = simdMin(simdMax(ratio, ratioMin), ratioMax);
+        SimdFloat slip = simdMul(simdAtanSmall(ratio), slipScale);
+        SimdFloat forceRight = simdMul(force, simdMin(simdMax(slip, slipMin), slipMax));
+
+        // Тяга и сопротивление против продольной скорости
+        SimdFloat velocitySign = simdSelect(simdLess(vx, zero), minusOne, one);
+        SimdFloat resistance = simdMul(simdMul(drag, velocitySign), simdMin(simdMul(vx, vx), dragLimit));
+        SimdFloat forceForward = simdMul(force, simdAdd(simdMul(traction, simdLoad(m_forwardInput.constData() + i)),
+                                                        resistance));
+
+        forceRight = simdMul(forceRight, rightInverse);
+        forceForward = simdMul(forceForward, forwardInverse);
+
+        SimdFloat forceX = simdAdd(simdMul(nx, force), simdAdd(simdMul(rightX, forceRight), simdMul(forwardX, forceForward)));
+        SimdFloat forceY = simdAdd(simdMul(ny, force), simdAdd(simdMul(rightY, forceRight), simdMul(forwardY, forceForward)));
+        SimdFloat forceZ = simdAdd(simdMul(nz, force), simdAdd(simdMul(rightZ, forceRight), simdMul(forwardZ, forceForward)));
+
+        simdStore(m_forceX.data() + i, simdSelect(hit, forceX, zero));
+        simdStore(m_forceY.data() + i, simdSelect(hit, forceY, zero));
+        simdStore(m_forceZ.data() + i, simdSelect(hit, forceZ, zero));
+        simdStore(m_lastLenght.data() + i, simdSelect(hit, currentLenght, springLenght));
+    }
+}
+
+void FuryVehicleSystem::applyForces()
+{
+    int index = 0;
+
+    for (CarObject* car : m_vehicles)
+    {
+        rp3d::RigidBody* body = car->physicsBody();
+        const rp3d::Transform& transform = body->getTransform();
+        const rp3d::Quaternion& orientation = transform.getOrientation();
+        rp3d::Vector3 centerOfMass = transform * body->getLocalCenterOfMass();
+
+        rp3d::Vector3 totalForce(0, 0, 0);
+        rp3d::Vector3 totalTorque(0, 0, 0);
+        int wheelCount = car->wheels().size();
+
+        for (int i = 0; i < wheelCount; ++i, ++index)
+        {
+            car->setLastSuspentionLenght(i, m_lastLenght[index]);
+
+            // Сила в локальных координатах машины, приложенная в точке начала луча
+            rp3d::Vector3 worldForce = orientation * rp3d::Vector3(m_forceX[index], m_forceY[index], m_forceZ[index]);
+            totalForce += worldForce;
+            totalTorque += (m_rays[index].start - centerOfMass).cross(worldForce);
+        }
+
+        body->applyWorldForceAtCenterOfMass(totalForce);
+        body->applyWorldTorque(totalTorque);
+    }
+}
@@ -0,0 +1,145 @@
+#ifndef FURYVEHICLESYSTEM_H
+#define FURYVEHICLESYSTEM_H
+
+#include "FuryObject.h"
+#include "FuryRaySensor.h"
+
+#include <reactphysics3d/reactphysics3d.h>
+
+#include <QVector>
+
+class CarObject;
+class FuryWorld;
+
+
+/*!
+ * \brief Подвеска и шины всех машин мира за один проход.
+ *
+ * Лучи подвески всех колёс всех машин идут одним пакетом через FuryRaySensor.
+ * Силы подвески и шин считаются SIMD по 4 колеса над состоянием колёс,
+ * разложенным по массивам (структура массивов). Каждая машина получает
+ * суммарную силу и момент двумя вызовами вместо двух на колесо.
+ *
+ * Поворот передних колёс учитывается поворотом их локальной скорости,
+ * трансформации тел колёс не трогаются.
+ */
+class FuryVehicleSystem
+{
+public:
+    /*!
+     * \brief Конструктор
+     * \param[in] _world - Мир
+     */
+    explicit FuryVehicleSystem(FuryWorld* _world);
+
+    /*!
+     * \brief Добавление машины. Машина добавляет себя сама при создании
+     * \param[in] _car - Машина
+     */
+    void addVehicle(CarObject* _car);
+
+    /*!
+     * \brief Удаление машины. Машина удаляет себя сама при удалении
+     * \param[in] _car - Машина
+     */
+    void removeVehicle(CarObject* _car);
+
+    /*!
+     * \brief Получение машин мира
+     * \return Возвращает машины
+     */
+    inline const QVector<CarObject*>& vehicles() const
+    { return m_vehicles; }
+
+    /*!
+     * \brief Установка режима призраков: машины не сталкиваются друг с другом
+     * и не видят друг друга лучами подвески и датчиков, трасса остаётся общей
+     * \param[in] _ghostMode - Признак режима призраков
+     */
+    void setGhostMode(bool _ghostMode);
+
+    /*!
+     * \brief Получение режима призраков
+     * \return Возвращает признак режима призраков
+     */
+    inline bool ghostMode() const
+    { return m_ghostMode; }
+
+    /*!
+     * \brief Маска лучей машин: без других машин в режиме призраков
+     * \return Возвращает маску категорий
+     */
+    inline unsigned short rayMask() const
+    { return m_ghostMode ? FuryObject::CategoryTrack : FuryObject::raySolidMask; }
+
+    /*!
+     * \brief Силы подвески и шин всех машин после тика объектов
+     * \param[in] _dt - Шаг физики
+     */
+    void tick(double _dt);
+
+private:
+    //! Лучи подвески и сбор состояния колёс в массивы
+    void gatherWheels();
+
+    /*!
+     * \brief Расчёт сил всех колёс в локальных координатах машин
+     * \param[in] _dt - Шаг физики
+     */
+    void computeForces(float _dt);
+
+    //! Приложение суммарных сил и моментов к машинам
+    void applyForces();
+
+    /*!
+     * \brief Маска столкновений машин для текущего режима призраков
+     * \return Возвращает маску категорий
+     */
+    unsigned short ghostCollideMask() const;
+
+private:
+    //! Мир
+    FuryWorld* m_world;
+    //! Машины мира
+    QVector<CarObject*> m_vehicles;
+    //! Режим призраков: машины не сталкиваются друг с другом
+    bool m_ghostMode;
+
+    //! Лучи подвески, по одному на колесо
+    QVector<FuryRaySensor::Ray> m_rays;
+    //! Результат лучей: доля длины и признак триггера на колесо
+    QVector<float> m_rayResults;
+    //! Нормали в точках пересечения лучей
+    QVector<rp3d::Vector3> m_normals;
+
+    //! Количество колёс, кратное ширине SIMD
+    int m_paddedCount;
+    //! Доля длины луча до дороги. 1 - колесо в воздухе
+    QVector<float> m_fraction;
+    //! Нормаль дороги, x
+    QVector<float> m_normalX;
+    //! Нормаль дороги, y
+    QVector<float> m_normalY;
+    //! Нормаль дороги, z
+    QVector<float> m_normalZ;
+    //! Скорость колеса вдоль колеса с учётом поворота
+    QVector<float> m_velocityX;
+    //! Скорость колеса поперёк колеса с учётом поворота
+    QVector<float> m_velocityZ;
+    //! Управление движением вперёд машины колеса
+    QVector<float> m_forwardInput;
+    //! Длина пружины
+    QVector<float> m_springLenght;
+    //! Жёсткость пружины
+    QVector<float> m_springK;
+    //! Длина пружины в прошлом тике. После расчёта - в этом
+    QVector<float> m_lastLenght;
+    //! Сила колеса в локальных координатах машины, x
+    QVector<float> m_forceX;
+    //! Сила колеса в локальных координатах машины, y
+    QVector<float> m_forceY;
+    //! Сила колеса в локальных координатах машины, z
+    QVector<float> m_forceZ;
+};
+
+#endif // FURYVEHICLESYSTEM_H
@@ -1,6 +1,7 @@
 #include <boost/python.hpp>
 
 #include "CarObject.h"
+#include "FuryBuffer_Python.h"
 
 
 using namespace boost::python;
@@ -30,13 +31,30 @@ list getObservation(CarObject& _object)
     return result;
 }
 
+object observationBuffer(CarObject& _object)
+{
+    return floatBufferView(_object.observationBuffer(), CarObject::observationSize);
+}
+
+object actionBuffer(CarObject& _object)
+{
+    return intBufferView(_object.actionBuffer(), 1);
+}
+
 
 BOOST_PYTHON_MODULE(CarObject)
 {
     class_<CarObject, bases<FuryObject>, boost::noncopyable>("CarObject", no_init)
         .def("setBotAction", &CarObject::setBotAction)
+        .def("setActionRepeat", &CarObject::setActionRepeat)
+        .def("actionRepeat", &CarObject::actionRepeat)
+        .def("isDecisionRequired", &CarObject::isDecisionRequired)
         .def("getRays", getRays)
         .def("getObservation", getObservation)
+        .def("observationBuffer", observationBuffer)
+        .def("actionBuffer", actionBuffer)
+        .def("updateObservation", &CarObject::updateObservationBuffer)
+        .def("applyAction", &CarObject::applyActionBuffer)
         .def("getSpeed", &CarObject::getSpeed)
         .def("getAngularSpeed", &CarObject::getAngularSpeed)
         .def("getReward", &CarObject::getReward)
@@ -0,0 +1,195 @@
+#include "FuryBuffer_Python.h"
+
+#include <QtGlobal>
+#include <cstring>
+#include <algorithm>
+
+
+using namespace boost::python;
+
+
+/*!
+ * \brief Создание memoryview над памятью C++
+ * \param[in] _data - Данные
+ * \param[in] _format - Формат элемента в нотации struct. Должен быть строковым литералом
+ * \param[in] _itemSize - Размер элемента в байтах
+ * \param[in] _rows - Количество строк
+ * \param[in] _columns - Количество столбцов. 0 - одномерный буфер
+ * \return Возвращает memoryview
+ */
+static object bufferView(void* _data, const char* _format, Py_ssize_t _itemSize,
+                         int _rows, int _columns)
+{
+    // Форма копируется внутрь memoryview, формат хранится указателем
+    Py_ssize_t shape[2] = { _rows, _columns };
+
+    Py_buffer buffer;
+    buffer.buf = _data;
+    buffer.obj = nullptr;
+    buffer.len = _itemSize * _rows * (_columns > 0 ? _columns : 1);
+    buffer.itemsize = _itemSize;
+    buffer.readonly = 0;
+    buffer.ndim = (_columns > 0) ? 2 : 1;
+    buffer.format = const_cast<char*>(_format);
+    buffer.shape = shape;
+    buffer.strides = nullptr;
+    buffer.suboffsets = nullptr;
+    buffer.internal = nullptr;
+
+    return object(handle<>(PyMemoryView_FromBuffer(&buffer)));
+}
+
+object floatBufferView(float *_data, int _rows, int _columns)
+{
+    return bufferView(_data, "f", sizeof(float), _rows, _columns);
+}
+
+object intBufferView(int *_data, int _size)
+{
+    return bufferView(_data, "i", sizeof(int), _size, 0);
+}
+
+object boolBufferView(bool *_data, int _size)
+{
+    return bufferView(_data, "?", sizeof(bool), _size, 0);
+}
+
+/*!
+ * \brief Копирование с приведением типа
+ * \param[in] _source - Исходные данные
+ * \param[out] _destination - Буфер
+ * \param[in] _count - Количество значений
+ */
+template<typename S, typename T>
+static void convertValues(const void* _source, T* _destination, int _count)
+{
+    const S* source = static_cast<const S*>(_source);
+    std::transform(source, source + _count, _destination, [](const S& _value) { return T(_value); });
+}
+
+/*!
+ * \brief Копирование из буфера Python с приведением типа
+ * \param[in] _buffer - Буфер Python
+ * \param[out] _destination - Буфер
+ * \param[in] _count - Количество значений
+ * \return Возвращает признак известного формата элемента
+ */
+template<typename T>
+static bool convertBuffer(const Py_buffer& _buffer, T* _destination, int _count)
+{
+    // Последний символ: перед ним может стоять порядок байт ('<', '=')
+    char format = (_buffer.format != nullptr) ? _buffer.format[std::strlen(_buffer.format) - 1] : 'B';
+
+    switch (format)
+    {
+    case 'f':
+        convertValues<float>(_buffer.buf, _destination, _count);
+        return true;
+    case 'd':
+        convertValues<double>(_buffer.buf, _destination, _count);
+        return true;
+    case '?':
+        convertValues<bool>(_buffer.buf, _destination, _count);
+        return true;
+    case 'b':
+    case 'B':
+    case 'h':
+    case 'H':
+    case 'i':
+    case 'I':
+    case 'l':
+    case 'L':
+    case 'q':
+    case 'Q':
+        // Размер long зависит от платформы, поэтому целые разбираются по размеру
+        switch (_buffer.itemsize)
+        {
+        case 1:
+            convertValues<qint8>(_buffer.buf, _destination, _count);
+            return true;
+        case 2:
+            convertValues<qint16>(_buffer.buf, _destination, _count);
+            return true;
+        case 4:
+            convertValues<qint32>(_buffer.buf, _destination, _count);
+            return true;
+        case 8:
+            convertValues<qint64>(_buffer.buf, _destination, _count);
+            return true;
+        }
+        break;
+    }
+
+    return false;
+}
+
+/*!
+ * \brief Ошибка Python о несовпадении количества значений
+ */
+static void throwSizeError()
+{
+    PyErr_SetString(PyExc_ValueError, "buffer size does not match expected size");
+    throw_error_already_set();
+}
+
+/*!
+ * \brief Копирование значений из объекта Python в буфер
+ * \param[in] _source - Объект Python
+ * \param[out] _destination - Буфер
+ * \param[in] _count - Количество значений
+ */
+template<typename T>
+static void readBuffer(const object& _source, T* _destination, int _count)
+{
+    if (PyObject_CheckBuffer(_source.ptr()))
+    {
+        Py_buffer buffer;
+
+        if (PyObject_GetBuffer(_source.ptr(), &buffer, PyBUF_FORMAT | PyBUF_C_CONTIGUOUS) == 0)
+        {
+            bool sizeMatches = (buffer.itemsize > 0 && buffer.len == Py_ssize_t(_count) * buffer.itemsize);
+            bool converted = sizeMatches && convertBuffer(buffer, _destination, _count);
+
+            PyBuffer_Release(&buffer);
+
+            if (!sizeMatches)
+            {
+                throwSizeError();
+            }
+
+            if (converted)
+            {
+                return;
+            }
+        }
+        else
+        {
+            PyErr_Clear();
+        }
+    }
+
+    if (len(_source) != _count)
+    {
+        throwSizeError();
+    }
+
+    for (int i = 0; i < _count; ++i)
+    {
+        _destination[i] = extract<T>(_source[i]);
+    }
+}
+
+void readFloatBuffer(const object &_source, float *_destination, int _count)
+{
+    readBuffer(_source, _destination, _count);
+}
+
+void readIntBuffer(const object &_source, int *_destination, int _count)
+{
+    readBuffer(_source, _destination, _count);
+}
+
+void readBoolBuffer(const object &_source, bool *_destination, int _count)
+{
+    readBuffer(_source, _destination, _count);
+}
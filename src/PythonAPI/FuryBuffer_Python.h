@@ -0,0 +1,65 @@
+#ifndef FURYBUFFER_PYTHON_H
+#define FURYBUFFER_PYTHON_H
+
+#include <boost/python.hpp>
+
+
+/*!
+ * \brief Представление буфера float32 из C++ в Python без копирования.
+ * Память остаётся за C++ и должна жить дольше, чем представление.
+ * В скрипте превращается в массив NumPy через np.asarray() без копирования.
+ * \param[in] _data - Данные
+ * \param[in] _rows - Количество строк
+ * \param[in] _columns - Количество столбцов. 0 - одномерный буфер из _rows значений
+ * \return Возвращает memoryview с форматом 'f'
+ */
+boost::python::object floatBufferView(float* _data, int _rows, int _columns = 0);
+
+/*!
+ * \brief Представление буфера int32 из C++ в Python без копирования.
+ * Память остаётся за C++ и должна жить дольше, чем представление.
+ * \param[in] _data - Данные
+ * \param[in] _size - Количество значений
+ * \return Возвращает memoryview с форматом 'i'
+ */
+boost::python::object intBufferView(int* _data, int _size);
+
+/*!
+ * \brief Представление буфера bool из C++ в Python без копирования.
+ * Память остаётся за C++ и должна жить дольше, чем представление.
+ * \param[in] _data - Данные
+ * \param[in] _size - Количество значений
+ * \return Возвращает memoryview с форматом '?'
+ */
+boost::python::object boolBufferView(bool* _data, int _size);
+
+/*!
+ * \brief Копирование значений из объекта Python в буфер float.
+ * Объекты с протоколом буфера (массивы NumPy, memoryview) читаются одним проходом
+ * с приведением типа, остальные последовательности - поэлементно.
+ * \param[in] _source - Объект Python
+ * \param[out] _destination - Буфер
+ * \param[in] _count - Количество значений. Двумерные массивы читаются построчно
+ * \throw error_already_set - ValueError при несовпадении количества значений
+ */
+void readFloatBuffer(const boost::python::object& _source, float* _destination, int _count);
+
+/*!
+ * \brief Копирование значений из объекта Python в буфер int. См. readFloatBuffer
+ * \param[in] _source - Объект Python
+ * \param[out] _destination - Буфер
+ * \param[in] _count - Количество значений
+ * \throw error_already_set - ValueError при несовпадении количества значений
+ */
+void readIntBuffer(const boost::python::object& _source, int* _destination, int _count);
+
+/*!
+ * \brief Копирование значений из объекта Python в буфер bool. См. readFloatBuffer
+ * \param[in] _source - Объект Python
+ * \param[out] _destination - Буфер
+ * \param[in] _count - Количество значений
+ * \throw error_already_set - ValueError при несовпадении количества значений
+ */
+void readBoolBuffer(const boost::python::object& _source, bool* _destination, int _count);
+
+#endif // FURYBUFFER_PYTHON_H
@@ -0,0 +1,134 @@
+#include <boost/python.hpp>
+
+#include "CarObject.h"
+#include "FuryBuffer_Python.h"
+#include "FuryGilRelease_Python.h"
+#include "Logger/FuryException.h"
+#include "Simulation/FuryWorldSnapshot.h"
+#include "Simulation/FuryVectorEnvironment.h"
+
+
+using namespace boost::python;
+
+
+object environmentObservations(FuryVectorEnvironment& _environment)
+{
+    return floatBufferView(_environment.observationBuffer(),
+                           _environment.envCount(), CarObject::observationSize);
+}
+
+object environmentRewards(FuryVectorEnvironment& _environment)
+{
+    return floatBufferView(_environment.rewardBuffer(), _environment.envCount());
+}
+
+object environmentDones(FuryVectorEnvironment& _environment)
+{
+    return boolBufferView(_environment.doneBuffer(), _environment.envCount());
+}
+
+object environmentActions(FuryVectorEnvironment& _environment)
+{
+    return intBufferView(_environment.actionBuffer(), _environment.envCount());
+}
+
+/*!
+ * \brief Шаг среды: действия, ticksPerStep тиков физики, наблюдения.
+ * Все буферы принадлежат C++ и перезаписываются на следующем шаге.
+ * \param[in] _environment - Среда
+ * \param[in] _actions - Действия. None - взять уже записанные в actions()
+ * \return Возвращает кортеж (наблюдения, награды, признаки окончания эпизода)
+ */
+tuple environmentStep(FuryVectorEnvironment& _environment, const object& _actions)
+{
+    if (!_actions.is_none())
+    {
+        readIntBuffer(_actions, _environment.actionBuffer(), _environment.envCount());
+    }
+
+    // Миры шагают в пуле потоков без обращения к Python
+    {
+        FuryGilRelease gilRelease;
+        _environment.step();
+    }
+
+    return make_tuple(environmentObservations(_environment),
+                      environmentRewards(_environment),
+                      environmentDones(_environment));
+}
+
+tuple environmentStepWithoutActions(FuryVectorEnvironment& _environment)
+{
+    return environmentStep(_environment, object());
+}
+
+object environmentReset(FuryVectorEnvironment& _environment)
+{
+    _environment.reset();
+    return environmentObservations(_environment);
+}
+
+FuryWorldSnapshot environmentCaptureSnapshot(const FuryVectorEnvironment& _environment, int _index)
+{
+    if (_index < 0 || _index >= _environment.envCount())
+    {
+        PyErr_SetString(PyExc_IndexError, "environment index out of range");
+        throw_error_already_set();
+    }
+
+    FuryWorldSnapshot snapshot;
+    _environment.captureSnapshot(_index, snapshot);
+    return snapshot;
+}
+
+/*!
+ * \brief Восстановление снимка во все миры среды
+ * \param[in] _environment - Среда
+ * \param[in] _snapshot - Снимок
+ * \return Возвращает новые наблюдения
+ */
+object environmentRestoreSnapshot(FuryVectorEnvironment& _environment, const FuryWorldSnapshot& _snapshot)
+{
+    try
+    {
+        _environment.restoreSnapshot(_snapshot);
+    }
+    catch (const FuryException& _exception)
+    {
+        PyErr_SetString(PyExc_ValueError, _exception.userInfo().toStdString().c_str());
+        throw_error_already_set();
+    }
+
+    return environmentObservations(_environment);
+}
+
+int environmentObservationSize(const FuryVectorEnvironment&)
+{
+    return CarObject::observationSize;
+}
+
+
+BOOST_PYTHON_MODULE(FuryEnvironment)
+{
+    class_<FuryWorldSnapshot>("WorldSnapshot")
+        .def("isEmpty", &FuryWorldSnapshot::isEmpty)
+        .def("bodyCount", &FuryWorldSnapshot::bodyCount)
+        .def("clear", &FuryWorldSnapshot::clear)
+    ;
+
+    class_<FuryVectorEnvironment, boost::noncopyable>("VectorEnvironment", no_init)
+        .def("envCount", &FuryVectorEnvironment::envCount)
+        .def("observationSize", environmentObservationSize)
+        .def("ticksPerStep", &FuryVectorEnvironment::ticksPerStep)
+        .def("setTicksPerStep", &FuryVectorEnvironment::setTicksPerStep)
+        .def("observations", environmentObservations)
+        .def("rewards", environmentRewards)
+        .def("dones", environmentDones)
+        .def("actions", environmentActions)
+        .def("reset", environmentReset)
+        .def("captureSnapshot", environmentCaptureSnapshot)
+        .def("restoreSnapshot", environmentRestoreSnapshot)
+        .def("step", environmentStep)
+        .def("step", environmentStepWithoutActions)
+    ;
+};
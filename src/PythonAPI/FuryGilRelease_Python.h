@@ -0,0 +1,31 @@
+#ifndef FURYGILRELEASE_PYTHON_H
+#define FURYGILRELEASE_PYTHON_H
+
+#include <boost/python.hpp>
+
+
+/*!
+ * \brief Освобождение GIL на время жизни объекта. В отличие от пары
+ * Py_BEGIN_ALLOW_THREADS / Py_END_ALLOW_THREADS GIL возвращается
+ * и при выходе по исключению. Внутри области нельзя обращаться к Python
+ */
+class FuryGilRelease
+{
+public:
+    //! Конструктор. Освобождает GIL
+    FuryGilRelease() :
+        m_state(PyEval_SaveThread()) {}
+
+    //! Деструктор. Возвращает GIL
+    ~FuryGilRelease()
+    { PyEval_RestoreThread(m_state); }
+
+    FuryGilRelease(const FuryGilRelease&) = delete;
+    FuryGilRelease& operator=(const FuryGilRelease&) = delete;
+
+private:
+    //! Состояние потока Python на время без GIL
+    PyThreadState* m_state;
+};
+
+#endif // FURYGILRELEASE_PYTHON_H
@@ -0,0 +1,209 @@
+#include <boost/python.hpp>
+
+#include "FuryBuffer_Python.h"
+#include "FuryGilRelease_Python.h"
+#include "Learning/FuryAsyncLearner.h"
+#include "Learning/FuryReplayBuffer.h"
+
+
+using namespace boost::python;
+
+
+/*!
+ * \brief Представления массивов мини-пакета. Массивы принадлежат буферу
+ * и перезаписываются следующей выборкой
+ * \param[in] _buffer - Буфер воспроизведения
+ * \return Возвращает кортеж (наблюдения, маски действий, награды,
+ * следующие наблюдения, маски следующих наблюдений, индексы, веса важности)
+ */
+tuple replayBufferBatch(FuryReplayBuffer& _buffer)
+{
+    int batchSize = _buffer.batchSize();
+
+    return make_tuple(floatBufferView(_buffer.batchObservations(), batchSize, _buffer.observationSize()),
+                      floatBufferView(_buffer.batchActionMasks(), batchSize, _buffer.actionCount()),
+                      floatBufferView(_buffer.batchRewards(), batchSize),
+                      floatBufferView(_buffer.batchNextObservations(), batchSize, _buffer.observationSize()),
+                      floatBufferView(_buffer.batchNextMasks(), batchSize),
+                      intBufferView(_buffer.batchIndices(), batchSize),
+                      floatBufferView(_buffer.batchWeights(), batchSize));
+}
+
+tuple replayBufferSample(FuryReplayBuffer& _buffer)
+{
+    _buffer.sampleUniform();
+    return replayBufferBatch(_buffer);
+}
+
+tuple replayBufferSamplePrioritized(FuryReplayBuffer& _buffer, float _beta)
+{
+    _buffer.samplePrioritized(_beta);
+    return replayBufferBatch(_buffer);
+}
+
+/*!
+ * \brief Добавление перехода
+ * \param[in] _buffer - Буфер воспроизведения
+ * \param[in] _observation - Наблюдение
+ * \param[in] _action - Действие
+ * \param[in] _reward - Награда
+ * \param[in] _nextObservation - Следующее наблюдение. None - конец эпизода
+ */
+void replayBufferAdd(FuryReplayBuffer& _buffer, const object& _observation, int _action,
+                     float _reward, const object& _nextObservation)
+{
+    QVector<float> observations(2 * _buffer.observationSize());
+    float* observation = observations.data();
+    float* nextObservation = observation + _buffer.observationSize();
+
+    readFloatBuffer(_observation, observation, _buffer.observationSize());
+
+    if (_nextObservation.is_none())
+    {
+        nextObservation = nullptr;
+    }
+    else
+    {
+        readFloatBuffer(_nextObservation, nextObservation, _buffer.observationSize());
+    }
+
+    _buffer.add(observation, _action, _reward, nextObservation);
+}
+
+/*!
+ * \brief Добавление пакета переходов, например шага векторной среды
+ * \param[in] _buffer - Буфер воспроизведения
+ * \param[in] _observations - Наблюдения, N x observationSize
+ * \param[in] _actions - Действия
+ * \param[in] _rewards - Награды
+ * \param[in] _nextObservations - Следующие наблюдения, N x observationSize
+ * \param[in] _dones - Признаки конца эпизода
+ */
+void replayBufferAddBatch(FuryReplayBuffer& _buffer, const object& _observations,
+                          const object& _actions, const object& _rewards,
+                          const object& _nextObservations, const object& _dones)
+{
+    int count = len(_actions);
+    int observationSize = _buffer.observationSize();
+
+    QVector<float> observations(count * observationSize);
+    QVector<float> nextObservations(count * observationSize);
+    QVector<int> actions(count);
+    QVector<float> rewards(count);
+    QVector<bool> dones(count);
+
+    readFloatBuffer(_observations, observations.data(), count * observationSize);
+    readFloatBuffer(_nextObservations, nextObservations.data(), count * observationSize);
+    readIntBuffer(_actions, actions.data(), count);
+    readFloatBuffer(_rewards, rewards.data(), count);
+    readBoolBuffer(_dones, dones.data(), count);
+
+    _buffer.addBatch(observations.constData(), actions.constData(), rewards.constData(),
+                     nextObservations.constData(), dones.constData(), count);
+}
+
+/*!
+ * \brief Обновление приоритетов переходов последнего мини-пакета
+ * \param[in] _buffer - Буфер воспроизведения
+ * \param[in] _priorities - Приоритеты, по одному на строку пакета
+ */
+void replayBufferUpdatePriorities(FuryReplayBuffer& _buffer, const object& _priorities)
+{
+    QVector<float> priorities(_buffer.batchSize());
+    readFloatBuffer(_priorities, priorities.data(), priorities.size());
+
+    _buffer.updatePriorities(_buffer.batchIndices(), priorities.constData(), priorities.size());
+}
+
+object replayBufferObservation(FuryReplayBuffer& _buffer, int _index)
+{
+    if (_index < 0 || _index >= _buffer.size())
+    {
+        PyErr_SetString(PyExc_IndexError, "replay buffer index out of range");
+        throw_error_already_set();
+    }
+
+    return floatBufferView(_buffer.observationAt(_index), _buffer.observationSize());
+}
+
+bool replayBufferSave(const FuryReplayBuffer& _buffer, const std::string& _path)
+{
+    return _buffer.save(QString::fromStdString(_path));
+}
+
+bool replayBufferRestore(FuryReplayBuffer& _buffer, const std::string& _path)
+{
+    return _buffer.restore(QString::fromStdString(_path));
+}
+
+/*!
+ * \brief Ожидание новых переходов без GIL: поток симуляции в это время
+ * может продолжать работу, не дожидаясь обучения
+ * \param[in] _learner - Асинхронное обучение
+ * \param[in] _timeout - Наибольшее время ожидания в миллисекундах
+ * \return Возвращает признак наличия переходов в очереди
+ */
+bool learnerWaitForTransitions(FuryAsyncLearner& _learner, int _timeout)
+{
+    FuryGilRelease gilRelease;
+    return _learner.waitForTransitions(_timeout);
+}
+
+/*!
+ * \brief Публикация новых весов политики
+ * \param[in] _learner - Асинхронное обучение
+ * \param[in] _weights - Веса: bytes в формате MLP.export_bytes
+ * \return Возвращает признак успешной публикации
+ */
+bool learnerPublishPolicy(FuryAsyncLearner& _learner, const object& _weights)
+{
+    char* data = nullptr;
+    Py_ssize_t size = 0;
+
+    if (PyBytes_AsStringAndSize(_weights.ptr(), &data, &size) != 0)
+    {
+        throw_error_already_set();
+    }
+
+    return _learner.publishPolicy(QByteArray(data, int(size)));
+}
+
+
+BOOST_PYTHON_MODULE(FuryLearning)
+{
+    class_<FuryReplayBuffer, boost::noncopyable>("ReplayBuffer", init<int, int, int, int, optional<float>>())
+        .def("capacity", &FuryReplayBuffer::capacity)
+        .def("size", &FuryReplayBuffer::size)
+        .def("__len__", &FuryReplayBuffer::size)
+        .def("observationSize", &FuryReplayBuffer::observationSize)
+        .def("batchSize", &FuryReplayBuffer::batchSize)
+        .def("actionCount", &FuryReplayBuffer::actionCount)
+        .def("latestIndex", &FuryReplayBuffer::latestIndex)
+        .def("setSeed", &FuryReplayBuffer::setSeed)
+        .def("clear", &FuryReplayBuffer::clear)
+        .def("add", replayBufferAdd)
+        .def("addBatch", replayBufferAddBatch)
+        .def("sample", replayBufferSample)
+        .def("samplePrioritized", replayBufferSamplePrioritized)
+        .def("batch", replayBufferBatch)
+        .def("updatePriorities", replayBufferUpdatePriorities)
+        .def("observation", replayBufferObservation)
+        .def("save", replayBufferSave)
+        .def("restore", replayBufferRestore)
+    ;
+
+    class_<FuryAsyncLearner, boost::noncopyable>("AsyncLearner", no_init)
+        .def("observationSize", &FuryAsyncLearner::observationSize)
+        .def("actionCount", &FuryAsyncLearner::actionCount)
+        .def("stopRequested", &FuryAsyncLearner::stopRequested)
+        .def("drain", &FuryAsyncLearner::drain)
+        .def("waitForTransitions", learnerWaitForTransitions)
+        .def("publishPolicy", learnerPublishPolicy)
+        .def("publishPeriod", &FuryAsyncLearner::publishPeriod)
+        .def("setPublishPeriod", &FuryAsyncLearner::setPublishPeriod)
+        .def("explorationProbability", &FuryAsyncLearner::explorationProbability)
+        .def("setExplorationProbability", &FuryAsyncLearner::setExplorationProbability)
+        .def("policyVersion", &FuryAsyncLearner::policyVersion)
+        .def("droppedCount", &FuryAsyncLearner::droppedCount)
+    ;
+};
@@ -5,12 +5,6 @@
 #include <QFile>
 
 
-Shader::Shader() :
-    m_program(0)
-{
-
-}
-
 Shader::Shader(const QString &_vertexPath, const QString &_fragmentPath,
                const QString &_geometryPath) :
     m_program(0)
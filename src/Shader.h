@@ -12,8 +12,9 @@
 class Shader
 {
 public:
-    //! Конструктор по умолчанию
-    Shader();
+    //! Конструктор по умолчанию. Программа не создаётся, контекст OpenGL не нужен
+    Shader() :
+        m_program(0) {}
 
     /*!
      * \brief Конструктор
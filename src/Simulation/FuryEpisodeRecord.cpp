@@ -0,0 +1,336 @@
+#include "FuryEpisodeRecord.h"
+
+#include "CarObject.h"
+#include "FuryWorld.h"
+#include "FuryObject.h"
+#include "FurySimulation.h"
+#include "Logger/FuryLogger.h"
+
+#include <QFile>
+#include <QSysInfo>
+#include <QDataStream>
+#include <QVarLengthArray>
+#include <cstring>
+
+
+//! Сигнатура файла записи эпизода: "FREC"
+static const quint32 recordFileMagic = 0x43455246;
+//! Версия формата файла записи эпизода
+static const quint32 recordFileVersion = 2;
+//! Период контрольных сумм в тиках: раз в секунду симуляции
+static const quint64 checkpointPeriod = 60;
+
+
+FuryEpisodeRecord::FuryEpisodeRecord() :
+    m_seed(0),
+    m_timeStep(0),
+    m_tickCount(0)
+{
+
+}
+
+void FuryEpisodeRecord::begin(FurySimulation *_simulation)
+{
+    m_seed = _simulation->seed();
+    m_timeStep = _simulation->timeStep();
+    m_tickCount = 0;
+    m_inputs.clear();
+    m_resets.clear();
+    m_checkpoints.clear();
+
+    m_snapshot.capture(_simulation->world());
+    m_snapshot.restore(_simulation->world());
+
+    Debug(ru("Начало записи эпизода (зерно %1)").arg(m_seed));
+}
+
+void FuryEpisodeRecord::recordTick(FurySimulation *_simulation)
+{
+    CarObject* car = _simulation->carObject();
+    float forward = car->forwardInput();
+    float right = car->rightInput();
+
+    if (m_inputs.isEmpty() || m_inputs.last().forward != forward || m_inputs.last().right != right)
+    {
+        InputChange change;
+        change.tick = m_tickCount;
+        change.forward = forward;
+        change.right = right;
+        m_inputs.append(change);
+    }
+
+    if (m_tickCount % checkpointPeriod == checkpointPeriod - 1)
+    {
+        addCheckpoint(m_tickCount, _simulation->world());
+    }
+
+    ++m_tickCount;
+}
+
+void FuryEpisodeRecord::recordReset()
+{
+    if (m_tickCount > 0)
+    {
+        m_resets.append(m_tickCount - 1);
+    }
+}
+
+void FuryEpisodeRecord::finish(FurySimulation *_simulation)
+{
+    if (m_tickCount > 0)
+    {
+        addCheckpoint(m_tickCount - 1, _simulation->world());
+    }
+
+    Debug(ru("Запись эпизода завершена: тиков %1, изменений управления %2, сбросов %3")
+          .arg(m_tickCount).arg(m_inputs.size()).arg(m_resets.size()));
+}
+
+bool FuryEpisodeRecord::save(const QString &_path) const
+{
+    QFile file(_path);
+
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        Debug(ru("Не удалось открыть файл записи эпизода: %1").arg(_path));
+        return false;
+    }
+
+    // Состояния объектов в снимке - байты структур в порядке байтов машины,
+    // поэтому в файл пишется этот порядок и чужой файл не читается
+    QDataStream stream(&file);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+    stream << recordFileMagic << recordFileVersion << quint8(QSysInfo::ByteOrder)
+           << m_seed << m_tickCount;
+
+    stream.setFloatingPointPrecision(QDataStream::DoublePrecision);
+    stream << m_timeStep;
+    stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+    m_snapshot.write(stream);
+
+    stream << qint32(m_inputs.size());
+
+    for (const InputChange& change : m_inputs)
+    {
+        stream << change.tick << change.forward << change.right;
+    }
+
+    stream << qint32(m_resets.size());
+
+    for (quint64 tick : m_resets)
+    {
+        stream << tick;
+    }
+
+    stream << qint32(m_checkpoints.size());
+
+    for (const Checkpoint& checkpoint : m_checkpoints)
+    {
+        stream << checkpoint.tick << checkpoint.checksum;
+    }
+
+    if (stream.status() != QDataStream::Ok)
+    {
+        Debug(ru("Ошибка записи файла записи эпизода: %1").arg(_path));
+        return false;
+    }
+
+    Debug(ru("Запись эпизода сохранена: %1 (%2 байт)").arg(_path).arg(file.size()));
+    return true;
+}
+
+bool FuryEpisodeRecord::load(const QString &_path)
+{
+    QFile file(_path);
+
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        Debug(ru("Не удалось открыть файл записи эпизода: %1").arg(_path));
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    quint8 byteOrder = 0;
+    stream >> magic >> version >> byteOrder;
+
+    if (magic != recordFileMagic || version != recordFileVersion)
+    {
+        Debug(ru("Неверный формат файла записи эпизода: %1").arg(_path));
+        return false;
+    }
+
+    if (byteOrder != quint8(QSysInfo::ByteOrder))
+    {
+        Debug(ru("Файл записи эпизода сохранён на машине с другим порядком байтов: %1").arg(_path));
+        return false;
+    }
+
+    stream >> m_seed >> m_tickCount;
+
+    stream.setFloatingPointPrecision(QDataStream::DoublePrecision);
+    stream >> m_timeStep;
+    stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+    bool isValid = m_snapshot.read(stream);
+
+    qint32 inputCount = 0;
+    stream >> inputCount;
+    m_inputs.resize(qMax(0, inputCount));
+
+    for (InputChange& change : m_inputs)
+    {
+        stream >> change.tick >> change.forward >> change.right;
+    }
+
+    qint32 resetCount = 0;
+    stream >> resetCount;
+    m_resets.resize(qMax(0, resetCount));
+
+    for (quint64& tick : m_resets)
+    {
+        stream >> tick;
+    }
+
+    qint32 checkpointCount = 0;
+    stream >> checkpointCount;
+    m_checkpoints.resize(qMax(0, checkpointCount));
+
+    for (Checkpoint& checkpoint : m_checkpoints)
+    {
+        stream >> checkpoint.tick >> checkpoint.checksum;
+    }
+
+    if (!isValid || stream.status() != QDataStream::Ok)
+    {
+        Debug(ru("Файл записи эпизода повреждён: %1").arg(_path));
+        m_tickCount = 0;
+        m_inputs.clear();
+        m_resets.clear();
+        m_checkpoints.clear();
+        return false;
+    }
+
+    Debug(ru("Загружена запись эпизода: тиков %1, зерно %2").arg(m_tickCount).arg(m_seed));
+    return true;
+}
+
+bool FuryEpisodeRecord::replay(FurySimulation *_simulation, quint64 *_failedTick) const
+{
+    CarObject* car = _simulation->carObject();
+
+    if (car == nullptr || !qFuzzyCompare(_simulation->timeStep(), m_timeStep))
+    {
+        Debug(ru("Запись эпизода не подходит к симуляции"));
+        return false;
+    }
+
+    if (!m_snapshot.restore(_simulation->world()))
+    {
+        return false;
+    }
+
+    _simulation->setSeed(m_seed);
+
+    QVarLengthArray<float, 64> observation(CarObject::observationSize);
+    int inputIndex = 0;
+    int resetIndex = 0;
+    int checkpointIndex = 0;
+
+    for (quint64 tick = 0; tick < m_tickCount; ++tick)
+    {
+        while (inputIndex + 1 < m_inputs.size() && m_inputs[inputIndex + 1].tick <= tick)
+        {
+            ++inputIndex;
+        }
+
+        // Управление ставится в каждом тике: сброс эпизода восстанавливает
+        // управление из снимка, а запись хранит только изменения
+        if (inputIndex < m_inputs.size())
+        {
+            car->setInput(m_inputs[inputIndex].forward, m_inputs[inputIndex].right);
+        }
+
+        _simulation->tickWorld();
+
+        if (checkpointIndex < m_checkpoints.size() && m_checkpoints[checkpointIndex].tick == tick)
+        {
+            if (worldChecksum(_simulation->world()) != m_checkpoints[checkpointIndex].checksum)
+            {
+                Debug(ru("[ ВНИМАНИЕ ] Расхождение воспроизведения на тике %1").arg(tick));
+
+                if (_failedTick != nullptr)
+                {
+                    *_failedTick = tick;
+                }
+
+                return false;
+            }
+
+            ++checkpointIndex;
+        }
+
+        while (resetIndex < m_resets.size() && m_resets[resetIndex] == tick)
+        {
+            _simulation->resetEpisode(observation.data());
+            ++resetIndex;
+        }
+    }
+
+    return true;
+}
+
+quint64 FuryEpisodeRecord::worldChecksum(FuryWorld *_world)
+{
+    quint64 hash = 14695981039346656037ULL;
+    const QVector<FuryObject*>& objects = _world->getAllObjects();
+
+    for (FuryObject* object : objects)
+    {
+        rp3d::RigidBody* body = object->physicsBody();
+
+        if (body == nullptr || body->getType() == rp3d::BodyType::STATIC)
+        {
+            continue;
+        }
+
+        const rp3d::Transform& transform = body->getTransform();
+        const rp3d::Vector3& position = transform.getPosition();
+        const rp3d::Quaternion& orientation = transform.getOrientation();
+
+        // Побайтно по значениям, а не по структуре: выравнивание не попадает в хэш
+        const rp3d::decimal values[7] = { position.x, position.y, position.z,
+                                          orientation.x, orientation.y,
+                                          orientation.z, orientation.w };
+        unsigned char bytes[sizeof(values)];
+        std::memcpy(bytes, values, sizeof(values));
+
+        for (unsigned char byte : bytes)
+        {
+            hash ^= byte;
+            hash *= 1099511628211ULL;
+        }
+    }
+
+    return hash;
+}
+
+void FuryEpisodeRecord::addCheckpoint(quint64 _tick, FuryWorld *_world)
+{
+    if (!m_checkpoints.isEmpty() && m_checkpoints.last().tick == _tick)
+    {
+        return;
+    }
+
+    Checkpoint checkpoint;
+    checkpoint.tick = _tick;
+    checkpoint.checksum = worldChecksum(_world);
+    m_checkpoints.append(checkpoint);
+}
@@ -0,0 +1,142 @@
+#ifndef FURYEPISODERECORD_H
+#define FURYEPISODERECORD_H
+
+#include "FuryWorldSnapshot.h"
+
+#include <QVector>
+#include <QString>
+
+class FuryWorld;
+class FurySimulation;
+
+
+/*!
+ * \brief Запись эпизода для детерминированного воспроизведения.
+ *
+ * Хранит зерно симуляции, снимок мира на начало записи, управление машиной
+ * в каждом тике и контрольные суммы трансформаций тел. Управление снимается
+ * после тика, поэтому одинаково записываются действия Бота, нажатия клавиш
+ * и решения нейросети политики. В файл пишутся только изменения управления.
+ *
+ * Воспроизведение прогоняет те же тики без скриптов и отрисовки и сверяет
+ * трансформации бит в бит. Совпадение гарантируется, если запись начата
+ * на только что загруженном мире (безголовый запуск с --record): кэши
+ * контактов физики в снимок не входят. Сбросы эпизода через
+ * FurySimulation::resetEpisode записываются и повторяются, сбросы мира
+ * из скриптов Python - нет.
+ */
+class FuryEpisodeRecord
+{
+public:
+    //! Конструктор пустой записи
+    FuryEpisodeRecord();
+
+    /*!
+     * \brief Начало записи: снимок мира и зерно симуляции. Снимок сразу
+     * восстанавливается, чтобы запись и воспроизведение начинались одинаково
+     * \param[in] _simulation - Симуляция с машиной
+     */
+    void begin(FurySimulation* _simulation);
+
+    /*!
+     * \brief Запись управления и контрольной суммы после тика.
+     * Вызывается из FurySimulation::tickWorld
+     * \param[in] _simulation - Симуляция
+     */
+    void recordTick(FurySimulation* _simulation);
+
+    //! Запись сброса эпизода после последнего тика
+    void recordReset();
+
+    /*!
+     * \brief Завершение записи: контрольная сумма последнего тика
+     * \param[in] _simulation - Симуляция
+     */
+    void finish(FurySimulation* _simulation);
+
+    /*!
+     * \brief Сохранение записи в файл
+     * \param[in] _path - Путь к файлу
+     * \return Возвращает признак успешного сохранения
+     */
+    bool save(const QString& _path) const;
+
+    /*!
+     * \brief Загрузка записи из файла
+     * \param[in] _path - Путь к файлу
+     * \return Возвращает признак успешной загрузки
+     */
+    bool load(const QString& _path);
+
+    /*!
+     * \brief Воспроизведение записи со сверкой трансформаций. Скрипт,
+     * политика и обучение к симуляции подключены быть не должны
+     * \param[in] _simulation - Симуляция, загруженная из той же сцены
+     * \param[out] _failedTick - Первый тик с расхождением. Может быть nullptr
+     * \return Возвращает признак совпадения всех контрольных сумм
+     */
+    bool replay(FurySimulation* _simulation, quint64* _failedTick = nullptr) const;
+
+    /*!
+     * \brief Получение количества записанных тиков
+     * \return Возвращает количество тиков
+     */
+    inline quint64 tickCount() const
+    { return m_tickCount; }
+
+    /*!
+     * \brief Получение зерна симуляции на начало записи
+     * \return Возвращает зерно
+     */
+    inline quint32 seed() const
+    { return m_seed; }
+
+    /*!
+     * \brief Контрольная сумма трансформаций всех подвижных тел мира
+     * \param[in] _world - Мир
+     * \return Возвращает 64-битный хэш FNV-1a
+     */
+    static quint64 worldChecksum(FuryWorld* _world);
+
+private:
+    //! Изменение управления машиной
+    struct InputChange
+    {
+        //! Номер тика с начала записи, с которого действует управление
+        quint64 tick;
+        //! Движение вперёд
+        float forward;
+        //! Поворот направо
+        float right;
+    };
+
+    //! Контрольная сумма после тика
+    struct Checkpoint
+    {
+        //! Номер тика с начала записи
+        quint64 tick;
+        //! Контрольная сумма трансформаций
+        quint64 checksum;
+    };
+
+    //! Добавление контрольной суммы, если для тика её ещё нет
+    void addCheckpoint(quint64 _tick, FuryWorld* _world);
+
+private:
+    //! Зерно симуляции
+    quint32 m_seed;
+    //! Шаг физики при записи
+    double m_timeStep;
+    //! Снимок мира на начало записи
+    FuryWorldSnapshot m_snapshot;
+    //! Количество записанных тиков
+    quint64 m_tickCount;
+    //! Изменения управления по порядку тиков
+    QVector<InputChange> m_inputs;
+    //! Номера тиков, после которых был сброс эпизода
+    QVector<quint64> m_resets;
+    //! Контрольные суммы по порядку тиков
+    QVector<Checkpoint> m_checkpoints;
+};
+
+#endif // FURYEPISODERECORD_H
@@ -0,0 +1,394 @@
+#include "Managers/FuryScriptManager.h"
+
+#include "FurySimulation.h"
+
+#include "CarObject.h"
+#include "FuryWorld.h"
+#include "FuryObjectsFactory.h"
+#include "Logger/FuryLogger.h"
+#include "FuryEpisodeRecord.h"
+#include "Learning/FuryAsyncLearner.h"
+#include "Learning/FuryPolicyNetwork.h"
+#include "Physics/FuryEventListener.h"
+#include "Physics/FuryVehicleSystem.h"
+
+#include <reactphysics3d/reactphysics3d.h>
+
+#include <QJsonObject>
+
+
+FurySimulation::FurySimulation(FuryWorld *_world) :
+    m_world(_world),
+    m_eventListener(new FuryEventListener),
+    m_carObject(nullptr),
+    m_agentCount(1),
+    m_record(nullptr),
+    m_seed(1),
+    m_random(m_seed),
+    m_policy(nullptr),
+    m_learner(nullptr),
+    m_lastAction(-1),
+    m_decisionReward(0),
+    m_episodeScore(0),
+    m_episodeCount(0),
+    m_timeStep(1.0 / 60.0),
+    m_tickCount(0)
+{
+    Debug(ru("Создание симуляции мира (%1)").arg(m_world->objectName()));
+    m_world->physicsWorld()->setEventListener(m_eventListener);
+}
+
+FurySimulation::~FurySimulation()
+{
+    Debug(ru("Удаление симуляции мира (%1)").arg(m_world->objectName()));
+
+    detachScript();
+    detachPolicy();
+    attachLearner(nullptr);
+
+    m_world->physicsWorld()->setEventListener(nullptr);
+
+    delete m_eventListener;
+    m_eventListener = nullptr;
+}
+
+void FurySimulation::load()
+{
+    m_world->load();
+    spawnAgents();
+    findCarObject();
+
+    m_world->resetWorld();
+    captureInitialSnapshot();
+}
+
+void FurySimulation::captureInitialSnapshot()
+{
+    m_initialSnapshot.capture(m_world);
+}
+
+void FurySimulation::attachScript(const QString &_scriptName)
+{
+    if (m_carObject == nullptr)
+    {
+        Debug(ru("Невозможно подключить скрипт (%1): нет машины").arg(_scriptName));
+        return;
+    }
+
+    detachScript();
+
+    FuryScriptManager* scriptManager = FuryScriptManager::instance();
+    scriptManager->importScript(_scriptName);
+    scriptManager->createObject(m_carObject, _scriptName);
+    scriptManager->processStart();
+
+    m_scriptName = _scriptName;
+}
+
+void FurySimulation::detachScript()
+{
+    if (m_scriptName.isEmpty())
+    {
+        return;
+    }
+
+    FuryScriptManager* scriptManager = FuryScriptManager::instance();
+    scriptManager->processStop();
+    scriptManager->removeObject(m_carObject);
+
+    m_scriptName.clear();
+}
+
+bool FurySimulation::attachPolicy(const QString &_path)
+{
+    if (m_carObject == nullptr)
+    {
+        Debug(ru("Невозможно подключить политику (%1): нет машины").arg(_path));
+        return false;
+    }
+
+    FuryPolicyNetwork* policy = new FuryPolicyNetwork;
+
+    if (!policy->load(_path))
+    {
+        delete policy;
+        return false;
+    }
+
+    if (policy->inputSize() != CarObject::observationSize)
+    {
+        Debug(ru("Размер входа политики (%1) не совпадает с наблюдением машины")
+              .arg(policy->inputSize()));
+        delete policy;
+        return false;
+    }
+
+    detachPolicy();
+
+    m_policy = policy;
+
+    for (CarObject* car : carObjects())
+    {
+        car->setPolicy(m_policy);
+    }
+
+    return true;
+}
+
+void FurySimulation::detachPolicy()
+{
+    if (m_policy == nullptr)
+    {
+        return;
+    }
+
+    for (CarObject* car : carObjects())
+    {
+        car->setPolicy(nullptr);
+    }
+
+    delete m_policy;
+    m_policy = nullptr;
+}
+
+void FurySimulation::attachLearner(FuryAsyncLearner *_learner)
+{
+    m_learner = _learner;
+    m_lastAction = -1;
+    m_decisionReward = 0;
+    m_episodeScore = 0;
+
+    int size = (_learner != nullptr) ? _learner->observationSize() : 0;
+    m_lastObservation.fill(0, size);
+    m_nextObservation.fill(0, size);
+}
+
+void FurySimulation::attachRecord(FuryEpisodeRecord *_record)
+{
+    if (_record != nullptr && m_carObject == nullptr)
+    {
+        Debug(ru("Невозможно подключить запись эпизода: нет машины"));
+        return;
+    }
+
+    m_record = _record;
+}
+
+void FurySimulation::setSeed(quint32 _seed)
+{
+    m_seed = _seed;
+    m_random.seed(_seed);
+}
+
+void FurySimulation::tickWorld()
+{
+    if (m_policy != nullptr)
+    {
+        applyPolicyDecisions();
+    }
+
+    m_world->tick(m_timeStep);
+    ++m_tickCount;
+
+    if (m_record != nullptr)
+    {
+        m_record->recordTick(this);
+    }
+}
+
+void FurySimulation::step()
+{
+    tickWorld();
+
+    if (m_learner != nullptr)
+    {
+        stepActor();
+    }
+    else if (!m_scriptName.isEmpty())
+    {
+        FuryScriptManager::instance()->processUpdate();
+    }
+}
+
+void FurySimulation::writeObservation(float *_observation)
+{
+    m_carObject->writeObservation(_observation);
+}
+
+float FurySimulation::takeReward(bool &_done)
+{
+    float reward = m_carObject->getReward();
+    _done = true;
+
+    if (!m_carObject->checkTimeCounter())
+    {
+        reward = -1;
+    }
+    else if (!m_carObject->checkBackTriggerCounter())
+    {
+        reward -= 0.1f;
+    }
+    else if (!m_carObject->checkHasContact())
+    {
+        reward -= 0.1f;
+    }
+    else
+    {
+        _done = false;
+    }
+
+    return reward;
+}
+
+void FurySimulation::resetEpisode(float *_observation)
+{
+    if (m_record != nullptr)
+    {
+        m_record->recordReset();
+    }
+
+    if (!restoreSnapshot(m_initialSnapshot, _observation))
+    {
+        m_world->resetWorld();
+        writeObservation(_observation);
+        m_carObject->getReward();
+    }
+}
+
+bool FurySimulation::restoreSnapshot(const FuryWorldSnapshot &_snapshot, float *_observation)
+{
+    if (!_snapshot.restore(m_world))
+    {
+        return false;
+    }
+
+    // Переход, начатый до снимка, к восстановленному состоянию не относится:
+    // следующий шаг обучения начнёт эпизод заново, как после attachLearner
+    m_lastAction = -1;
+    m_decisionReward = 0;
+    m_lastObservation.fill(0);
+
+    writeObservation(_observation);
+
+    // Награда за первое наблюдение к эпизоду не относится
+    m_carObject->getReward();
+    return true;
+}
+
+void FurySimulation::stepActor()
+{
+    if (m_carObject == nullptr)
+    {
+        return;
+    }
+
+    if (m_lastAction < 0)
+    {
+        // Начало эпизода: награда за первое наблюдение к эпизоду не относится
+        writeObservation(m_nextObservation.data());
+        m_carObject->getReward();
+    }
+    else
+    {
+        bool done = false;
+        float reward = takeReward(done);
+        m_episodeScore += reward;
+        m_decisionReward += reward;
+
+        if (!done && !m_carObject->isDecisionRequired())
+        {
+            // Действие ещё повторяется: награда копится до границы решения
+            return;
+        }
+
+        reward = m_decisionReward;
+        m_decisionReward = 0;
+
+        if (done)
+        {
+            m_learner->pushTransition(m_lastObservation.constData(), m_lastAction, reward, nullptr);
+
+            Debug(ru("Игра: %1; Очки: %2").arg(m_episodeCount).arg(m_episodeScore));
+            ++m_episodeCount;
+            m_episodeScore = 0;
+
+            resetEpisode(m_nextObservation.data());
+        }
+        else
+        {
+            writeObservation(m_nextObservation.data());
+            m_learner->pushTransition(m_lastObservation.constData(), m_lastAction, reward,
+                                      m_nextObservation.constData());
+        }
+    }
+
+    m_lastAction = m_learner->selectAction(m_nextObservation.constData());
+    m_carObject->setBotAction(m_lastAction);
+
+    std::swap(m_lastObservation, m_nextObservation);
+}
+
+void FurySimulation::applyPolicyDecisions()
+{
+    // Машины, которым решение уже выбрано, не запросят его в своём tick
+    m_decisionCars.resize(0);
+
+    for (CarObject* car : carObjects())
+    {
+        if (car->policy() == m_policy && car->isDecisionRequired())
+        {
+            m_decisionCars.append(car);
+        }
+    }
+
+    if (!m_decisionCars.isEmpty())
+    {
+        CarObject::applyPolicyBatch(m_decisionCars, *m_policy);
+    }
+}
+
+const QVector<CarObject*>& FurySimulation::carObjects() const
+{
+    return m_world->vehicleSystem()->vehicles();
+}
+
+void FurySimulation::findCarObject()
+{
+    const QVector<CarObject*>& cars = carObjects();
+    m_carObject = cars.isEmpty() ? nullptr : cars.first();
+
+    if (m_carObject == nullptr)
+    {
+        Debug(ru("[ ВНИМАНИЕ ] В мире (%1) нет машины").arg(m_world->objectName()));
+    }
+    else if (cars.size() > 1)
+    {
+        Debug(ru("Машин в мире (%1): %2").arg(m_world->objectName()).arg(cars.size()));
+    }
+}
+
+void FurySimulation::spawnAgents()
+{
+    const QVector<CarObject*>& cars = carObjects();
+
+    if (cars.isEmpty() || cars.size() >= m_agentCount)
+    {
+        return;
+    }
+
+    // Копии стоят на месте первой машины, поэтому сталкиваться им нельзя
+    m_world->vehicleSystem()->setGhostMode(true);
+
+    // Колёса и отладочные сферы машина создаёт сама, из JSON их не берём
+    QJsonObject json = cars.first()->toJson();
+    json.remove("children");
+
+    FuryObjectsFactory* factory = FuryObjectsFactory::instance();
+
+    for (int i = cars.size(); i < m_agentCount; ++i)
+    {
+        FuryObject* car = factory->fromJson(json, m_world, nullptr, true);
+        car->setObjectName(QString("AI_car %1").arg(i));
+        m_world->addRootObject(car);
+    }
+}
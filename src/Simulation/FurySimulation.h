@@ -0,0 +1,256 @@
+#ifndef FURYSIMULATION_H
+#define FURYSIMULATION_H
+
+#include <QString>
+#include <QVector>
+#include <QRandomGenerator>
+
+#include "FuryWorldSnapshot.h"
+
+class CarObject;
+class FuryWorld;
+class FuryEventListener;
+class FuryAsyncLearner;
+class FuryEpisodeRecord;
+class FuryPolicyNetwork;
+
+
+//! Симуляция мира без отрисовки. Не обращается к OpenGL.
+class FurySimulation
+{
+public:
+    /*!
+     * \brief Конструктор
+     * \param[in] _world - Мир для симуляции
+     */
+    explicit FurySimulation(FuryWorld* _world);
+    //! Деструктор
+    ~FurySimulation();
+
+    //! Загрузка мира из JSON, добавление агентов, поиск машины и снимок начального состояния
+    void load();
+
+    /*!
+     * \brief Установка количества агентов-машин. Недостающие машины при load()
+     * создаются копиями первой машины сцены на её месте и в режиме призраков,
+     * общая трасса при этом одна на всех
+     * \param[in] _count - Количество машин
+     */
+    inline void setAgentCount(int _count)
+    { m_agentCount = qMax(1, _count); }
+
+    /*!
+     * \brief Получение количества агентов-машин, заданного до загрузки
+     * \return Возвращает количество машин
+     */
+    inline int agentCount() const
+    { return m_agentCount; }
+
+    //! Снимок текущего состояния мира как начального для resetEpisode
+    void captureInitialSnapshot();
+
+    /*!
+     * \brief Подключение скрипта управления машиной
+     * \param[in] _scriptName - Название модуля скрипта
+     */
+    void attachScript(const QString& _scriptName);
+
+    //! Остановка скрипта управления
+    void detachScript();
+
+    /*!
+     * \brief Подключение нейросети политики: машина едет сама, без Python
+     * \param[in] _path - Путь к файлу весов (saved-model/policy.bin)
+     * \return Возвращает признак успешной загрузки весов
+     */
+    bool attachPolicy(const QString& _path);
+
+    //! Отключение нейросети политики
+    void detachPolicy();
+
+    /*!
+     * \brief Подключение асинхронного обучения. Пока оно подключено, step()
+     * сам ведёт эпизоды: выбирает действия актором и отдаёт переходы в очередь
+     * обучения, не вызывая Python
+     * \param[in] _learner - Асинхронное обучение. nullptr - отключить.
+     * Память остаётся за вызывающим
+     */
+    void attachLearner(FuryAsyncLearner* _learner);
+
+    /*!
+     * \brief Подключение записи эпизода: после каждого тика в неё пишется
+     * управление машиной, а сбросы эпизода отмечаются
+     * \param[in] _record - Запись. nullptr - отключить. Память остаётся за вызывающим
+     */
+    void attachRecord(FuryEpisodeRecord* _record);
+
+    /*!
+     * \brief Установка зерна генератора случайных чисел симуляции
+     * \param[in] _seed - Зерно
+     */
+    void setSeed(quint32 _seed);
+
+    /*!
+     * \brief Получение зерна генератора случайных чисел симуляции
+     * \return Возвращает зерно
+     */
+    inline quint32 seed() const
+    { return m_seed; }
+
+    /*!
+     * \brief Получение генератора случайных чисел симуляции. Всё случайное
+     * в симуляции берётся из него, чтобы прогон повторялся по зерну
+     * \return Возвращает генератор
+     */
+    inline QRandomGenerator& random()
+    { return m_random; }
+
+    //! Один тик физики мира с фиксированным шагом
+    void tickWorld();
+
+    /*!
+     * \brief Шаг симуляции: тик физики и обновление скрипта управления или актора
+     * обучения. Между границами решения (см. CarObject::setActionRepeat) машина
+     * держит прошлое действие, а Python и актор не вызываются
+     */
+    void step();
+
+    /*!
+     * \brief Запись текущего наблюдения машины
+     * \param[out] _observation - Буфер на CarObject::observationSize значений
+     */
+    void writeObservation(float* _observation);
+
+    /*!
+     * \brief Получение награды за шаг и проверка окончания эпизода.
+     * Повторяет правила скрипта scripts.test: таймаут, езда назад, удар о стену.
+     * \param[out] _done - Признак окончания эпизода
+     * \return Возвращает награду за шаг
+     */
+    float takeReward(bool& _done);
+
+    /*!
+     * \brief Начало нового эпизода: восстановление начального снимка мира
+     * и первое наблюдение
+     * \param[out] _observation - Буфер на CarObject::observationSize значений
+     */
+    void resetEpisode(float* _observation);
+
+    /*!
+     * \brief Продолжение эпизода из снимка, например для нескольких прогонов
+     * из одного состояния посреди круга. Незавершённый переход обучения
+     * отбрасывается
+     * \param[in] _snapshot - Снимок мира той же сцены
+     * \param[out] _observation - Буфер на CarObject::observationSize значений
+     * \return Возвращает признак успешного восстановления
+     */
+    bool restoreSnapshot(const FuryWorldSnapshot& _snapshot, float* _observation);
+
+    /*!
+     * \brief Снятие текущего состояния мира
+     * \param[out] _snapshot - Снимок
+     */
+    inline void captureSnapshot(FuryWorldSnapshot& _snapshot) const
+    { _snapshot.capture(m_world); }
+
+    /*!
+     * \brief Получение мира
+     * \return Возвращает мир
+     */
+    inline FuryWorld* world() const
+    { return m_world; }
+
+    /*!
+     * \brief Получение основной машины: её ведут скрипт, обучение и запись
+     * \return Возвращает машину или nullptr, если её нет в мире
+     */
+    inline CarObject* carObject() const
+    { return m_carObject; }
+
+    /*!
+     * \brief Получение всех машин мира. Основная машина - первая
+     * \return Возвращает машины
+     */
+    const QVector<CarObject*>& carObjects() const;
+
+    /*!
+     * \brief Получение шага физики
+     * \return Возвращает шаг физики в секундах
+     */
+    inline double timeStep() const
+    { return m_timeStep; }
+
+    /*!
+     * \brief Получение количества выполненных тиков
+     * \return Возвращает количество тиков
+     */
+    inline quint64 tickCount() const
+    { return m_tickCount; }
+
+private:
+    //! Выбор основной машины среди машин мира
+    void findCarObject();
+
+    //! Добавление копий первой машины до количества агентов
+    void spawnAgents();
+
+    //! Шаг актора асинхронного обучения после тика физики
+    void stepActor();
+
+    //! Выбор действий политикой одним пакетом для всех машин на границе решения
+    void applyPolicyDecisions();
+
+private:
+    //! Мир
+    FuryWorld* m_world;
+    //! Слушатель событий физики
+    FuryEventListener* m_eventListener;
+    //! Основная машина
+    CarObject* m_carObject;
+    //! Количество агентов-машин
+    int m_agentCount;
+
+    //! Начальное состояние мира для resetEpisode
+    FuryWorldSnapshot m_initialSnapshot;
+    //! Запись эпизода. nullptr, если не подключена
+    FuryEpisodeRecord* m_record;
+
+    //! Зерно генератора случайных чисел
+    quint32 m_seed;
+    //! Генератор случайных чисел симуляции
+    QRandomGenerator m_random;
+
+    //! Название скрипта управления. Пустое, если скрипт не подключён
+    QString m_scriptName;
+    //! Нейросеть политики. nullptr, если не подключена
+    FuryPolicyNetwork* m_policy;
+    //! Машины, которым политика выбирает действие в текущем тике
+    QVector<CarObject*> m_decisionCars;
+
+    //! Асинхронное обучение. nullptr, если не подключено
+    FuryAsyncLearner* m_learner;
+    //! Наблюдение, по которому выбрано текущее действие актора
+    QVector<float> m_lastObservation;
+    //! Новое наблюдение актора
+    QVector<float> m_nextObservation;
+    //! Текущее действие актора. -1 - эпизод ещё не начат
+    int m_lastAction;
+    //! Награда, накопленная за тики повтора текущего действия актора
+    float m_decisionReward;
+    //! Очки текущего эпизода актора
+    float m_episodeScore;
+    //! Количество эпизодов актора
+    int m_episodeCount;
+
+    //! Шаг физики
+    double m_timeStep;
+    //! Количество выполненных тиков
+    quint64 m_tickCount;
+
+    //! Запрещаем конструктор копирования
+    FurySimulation(const FurySimulation&) = delete;
+    //! Запрещаем оператор присваивания
+    FurySimulation& operator=(const FurySimulation&) = delete;
+};
+
+#endif // FURYSIMULATION_H
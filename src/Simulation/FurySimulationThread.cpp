@@ -0,0 +1,289 @@
+#include "FurySimulationThread.h"
+
+#include "FuryWorld.h"
+#include "FuryObject.h"
+#include "FurySimulation.h"
+#include "Logger/FuryLogger.h"
+
+#include <QThread>
+#include <algorithm>
+
+
+//! Наибольшее количество тиков между публикациями кадров
+const int maxTicksPerFrame = 32;
+//! Наибольшее отставание симуляции в секундах. Больше не догоняем, иначе
+//! после долгой паузы поток уходит в спираль из одних тиков
+const double maxLag = 0.25;
+
+
+FurySimulationThread::FurySimulationThread(FurySimulation *_simulation) :
+    m_simulation(_simulation),
+    m_objectsVersion(0),
+    m_thread(nullptr),
+    m_stopRequested(0),
+    m_speed(1),
+    m_tickCount(0),
+    m_previousTime(0),
+    m_previousObjectsVersion(0)
+{
+    Debug(ru("Создание потока симуляции"));
+}
+
+FurySimulationThread::~FurySimulationThread()
+{
+    Debug(ru("Удаление потока симуляции"));
+
+    stop();
+}
+
+void FurySimulationThread::start()
+{
+    if (m_thread != nullptr)
+    {
+        return;
+    }
+
+    m_objects = m_simulation->world()->getAllObjects();
+    m_objectsVersion = m_simulation->world()->objectsVersion();
+
+    QVector<rp3d::Transform> transforms(m_objects.size());
+
+    for (int i = 0; i < m_objects.size(); ++i)
+    {
+        transforms[i] = m_objects[i]->physicsBody()->getTransform();
+    }
+
+    // Память кадров выделяется один раз, дальше потоки только перезаписывают её
+    for (int i = 0; i < 3; ++i)
+    {
+        m_frames.slot(i).objects = m_objects;
+        m_frames.slot(i).transforms = transforms;
+        m_frames.slot(i).transforms.detach();
+        m_frames.slot(i).objectsVersion = m_objectsVersion;
+        m_frames.slot(i).time = 0;
+    }
+
+    m_previousTransforms = transforms;
+    m_previousTime = 0;
+    m_previousObjectsVersion = m_objectsVersion;
+    m_clock.start();
+
+    m_stopRequested.storeRelease(0);
+    m_thread = QThread::create([this]()
+    {
+        run();
+    });
+
+    m_thread->setObjectName("FurySimulation");
+    m_thread->start();
+
+    Debug(ru("Старт потока симуляции (%1 объектов)").arg(m_objects.size()));
+}
+
+void FurySimulationThread::stop()
+{
+    if (m_thread == nullptr)
+    {
+        return;
+    }
+
+    m_stopRequested.storeRelease(1);
+
+    m_thread->wait();
+    delete m_thread;
+    m_thread = nullptr;
+
+    // Оставшиеся действия выполняем здесь: поток симуляции уже не работает
+    runCommands();
+
+    // Список берём у мира: объекты могли удалиться после последнего кадра
+    for (FuryObject* object : m_simulation->world()->getAllObjects())
+    {
+        object->clearRenderTransform();
+    }
+
+    m_objects.clear();
+
+    for (int i = 0; i < 3; ++i)
+    {
+        m_frames.slot(i).objects.clear();
+    }
+
+    Debug(ru("Поток симуляции остановлен"));
+}
+
+void FurySimulationThread::post(const std::function<void ()> &_command)
+{
+    if (m_thread == nullptr)
+    {
+        _command();
+        return;
+    }
+
+    QMutexLocker locker(&m_commandsMutex);
+    m_commands.append(_command);
+}
+
+void FurySimulationThread::applyRenderTransforms()
+{
+    if (m_thread == nullptr)
+    {
+        return;
+    }
+
+    if (m_frames.hasUpdate())
+    {
+        // Слот читателя после update() уйдёт писателю, поэтому копируем заранее
+        const Frame& previous = m_frames.readSlot();
+        m_previousTransforms.resize(previous.transforms.size());
+        std::copy(previous.transforms.constBegin(), previous.transforms.constEnd(),
+                  m_previousTransforms.begin());
+        m_previousTime = previous.time;
+        m_previousObjectsVersion = previous.objectsVersion;
+
+        m_frames.update();
+    }
+
+    const Frame& frame = m_frames.readSlot();
+
+    // Кадр показывается с задержкой в один интервал публикации: за это время
+    // трансформации плавно переходят от предыдущего кадра к последнему
+    float alpha = 1;
+    qint64 frameInterval = frame.time - m_previousTime;
+
+    if (frameInterval > 0)
+    {
+        alpha = qBound(0.0, double(m_clock.nsecsElapsed() - frame.time) / frameInterval, 1.0);
+    }
+
+    // После смены списка объектов индексы кадров не совпадают: показываем
+    // последний кадр без интерполяции
+    bool interpolate = frame.objectsVersion == m_previousObjectsVersion;
+    float rawMatrix[16];
+
+    for (int i = 0; i < frame.objects.size(); ++i)
+    {
+        rp3d::Transform transform = frame.transforms[i];
+
+        if (interpolate)
+        {
+            transform = rp3d::Transform::interpolateTransforms(m_previousTransforms[i],
+                                                               frame.transforms[i],
+                                                               alpha);
+        }
+
+        transform.getOpenGLMatrix(rawMatrix);
+        frame.objects[i]->setRenderTransform(glm::make_mat4(rawMatrix));
+    }
+}
+
+void FurySimulationThread::run()
+{
+    double timeStep = m_simulation->timeStep();
+    double accumulator = 0;
+    qint64 lastTime = m_clock.nsecsElapsed();
+
+    while (m_stopRequested.loadAcquire() == 0)
+    {
+        runCommands();
+
+        int currentSpeed = speed();
+        qint64 currentTime = m_clock.nsecsElapsed();
+
+        if (currentSpeed == 0)
+        {
+            // Без ограничений: тики подряд, кадр только для предпросмотра
+            stepFrame(maxTicksPerFrame);
+
+            accumulator = 0;
+            lastTime = currentTime;
+            continue;
+        }
+
+        accumulator += (currentTime - lastTime) / 1e9 * currentSpeed;
+        accumulator = qMin(accumulator, maxLag * currentSpeed);
+        lastTime = currentTime;
+
+        int ticks = qMin(int(accumulator / timeStep), maxTicksPerFrame);
+
+        if (ticks > 0)
+        {
+            stepFrame(ticks);
+            accumulator -= ticks * timeStep;
+        }
+        else
+        {
+            // До следующего тика спим, а не крутимся вхолостую
+            double waitSeconds = (timeStep - accumulator) / currentSpeed;
+            QThread::usleep(static_cast<unsigned long>(qMax(1.0, waitSeconds * 1e6)));
+        }
+    }
+}
+
+void FurySimulationThread::stepFrame(int _ticks)
+{
+    for (int i = 0; i < _ticks; ++i)
+    {
+        m_simulation->step();
+    }
+
+    m_tickCount.fetchAndAddRelaxed(_ticks);
+
+    if (m_afterTicksCallback)
+    {
+        m_afterTicksCallback();
+    }
+
+    publishFrame();
+}
+
+void FurySimulationThread::runCommands()
+{
+    QVector<std::function<void()>> commands;
+
+    {
+        QMutexLocker locker(&m_commandsMutex);
+        commands.swap(m_commands);
+    }
+
+    for (const std::function<void()>& command : commands)
+    {
+        command();
+    }
+}
+
+void FurySimulationThread::updateObjects()
+{
+    FuryWorld* world = m_simulation->world();
+
+    if (world->objectsVersion() == m_objectsVersion)
+    {
+        return;
+    }
+
+    m_objects = world->getAllObjects();
+    m_objectsVersion = world->objectsVersion();
+}
+
+void FurySimulationThread::publishFrame()
+{
+    updateObjects();
+
+    Frame& frame = m_frames.writeSlot();
+
+    // Слот перевыделяется только после смены списка объектов
+    if (frame.objectsVersion != m_objectsVersion)
+    {
+        frame.objects = m_objects;
+        frame.transforms.resize(m_objects.size());
+        frame.objectsVersion = m_objectsVersion;
+    }
+
+    for (int i = 0; i < m_objects.size(); ++i)
+    {
+        frame.transforms[i] = m_objects[i]->physicsBody()->getTransform();
+    }
+
+    frame.time = m_clock.nsecsElapsed();
+    m_frames.publish();
+}
@@ -0,0 +1,174 @@
+#ifndef FURYSIMULATIONTHREAD_H
+#define FURYSIMULATIONTHREAD_H
+
+#include "FuryTripleBuffer.h"
+
+#include <reactphysics3d/reactphysics3d.h>
+
+#include <QMutex>
+#include <QVector>
+#include <QAtomicInt>
+#include <QAtomicInteger>
+#include <QElapsedTimer>
+
+#include <functional>
+
+class QThread;
+class FuryObject;
+class FurySimulation;
+
+
+/*!
+ * \brief Поток симуляции с фиксированным шагом.
+ *
+ * Вызывает FurySimulation::step в своём потоке и после каждого пакета тиков
+ * публикует трансформации всех объектов мира через тройной буфер. Кадр несёт
+ * свой список объектов: он пересобирается, когда меняется список объектов мира,
+ * поэтому добавленные объекты получают трансформации, а удалённые выпадают. Поток
+ * отрисовки берёт последний кадр и интерполирует его с предыдущим
+ * (applyRenderTransforms), не дожидаясь физики, поэтому скорость обучения
+ * не влияет на отзывчивость интерфейса.
+ *
+ * Пока поток работает, мир меняется только в нём: всё, что трогает физику
+ * или скрипты из главного потока, передаётся через post().
+ */
+class FurySimulationThread
+{
+public:
+    /*!
+     * \brief Конструктор
+     * \param[in] _simulation - Симуляция. Память остаётся за вызывающим
+     */
+    explicit FurySimulationThread(FurySimulation* _simulation);
+    //! Деструктор. Останавливает поток
+    ~FurySimulationThread();
+
+    //! Запуск потока. Мир должен быть уже загружен
+    void start();
+
+    //! Остановка потока с ожиданием его завершения
+    void stop();
+
+    /*!
+     * \brief Получить признак работы потока
+     * \return Возвращает true, если поток запущен
+     */
+    inline bool isRunning() const
+    { return m_thread != nullptr; }
+
+    /*!
+     * \brief Выполнение действия над миром в потоке симуляции перед следующим тиком.
+     * Если поток не запущен, действие выполняется сразу
+     * \param[in] _command - Действие
+     */
+    void post(const std::function<void()>& _command);
+
+    /*!
+     * \brief Установка скорости: сколько секунд симуляции проходит за секунду
+     * \param[in] _speed - Скорость. 1 - реальное время, 0 - без ограничений:
+     * тики идут подряд, кадры публикуются только для предпросмотра
+     */
+    inline void setSpeed(int _speed)
+    { m_speed.storeRelaxed(qMax(0, _speed)); }
+
+    /*!
+     * \brief Получение скорости
+     * \return Возвращает количество секунд симуляции за секунду. 0 - без ограничений
+     */
+    inline int speed() const
+    { return m_speed.loadRelaxed(); }
+
+    /*!
+     * \brief Получение количества выполненных тиков. Можно вызывать из любого потока
+     * \return Возвращает количество тиков с запуска потока
+     */
+    inline quint64 tickCount() const
+    { return m_tickCount.loadRelaxed(); }
+
+    /*!
+     * \brief Установка действия после каждого пакета тиков, в потоке симуляции
+     * \param[in] _callback - Действие. Пустое - не вызывать
+     */
+    inline void setAfterTicksCallback(const std::function<void()>& _callback)
+    { m_afterTicksCallback = _callback; }
+
+    /*!
+     * \brief Выставление объектам матриц отрисовки по последнему кадру,
+     * интерполированному с предыдущим. Вызывается из потока отрисовки
+     */
+    void applyRenderTransforms();
+
+private:
+    //! Кадр трансформаций
+    struct Frame
+    {
+        //! Объекты мира, для которых записаны трансформации
+        QVector<FuryObject*> objects;
+        //! Трансформации тел, по одной на объект objects
+        QVector<reactphysics3d::Transform> transforms;
+        //! Номер изменения списка объектов мира, по которому собран objects
+        quint32 objectsVersion;
+        //! Время публикации по m_clock в наносекундах
+        qint64 time;
+    };
+
+    //! Цикл потока симуляции
+    void run();
+
+    /*!
+     * \brief Пакет тиков, действие после них и публикация кадра
+     * \param[in] _ticks - Количество тиков
+     */
+    void stepFrame(int _ticks);
+
+    //! Выполнение действий, переданных через post()
+    void runCommands();
+
+    //! Пересборка списка объектов, если список объектов мира изменился
+    void updateObjects();
+
+    //! Запись трансформаций объектов в слот писателя и его публикация
+    void publishFrame();
+
+private:
+    //! Симуляция
+    FurySimulation* m_simulation;
+    //! Объекты мира для следующего кадра. Меняется только в потоке симуляции
+    QVector<FuryObject*> m_objects;
+    //! Номер изменения списка объектов мира, по которому собран m_objects
+    quint32 m_objectsVersion;
+
+    //! Поток симуляции
+    QThread* m_thread;
+    //! Признак запроса остановки
+    QAtomicInt m_stopRequested;
+    //! Количество секунд симуляции за секунду. 0 - без ограничений
+    QAtomicInt m_speed;
+    //! Количество выполненных тиков
+    QAtomicInteger<quint64> m_tickCount;
+    //! Часы для шага и интерполяции
+    QElapsedTimer m_clock;
+
+    //! Действия для потока симуляции
+    QVector<std::function<void()>> m_commands;
+    //! Мьютекс действий
+    QMutex m_commandsMutex;
+    //! Действие после каждого пакета тиков
+    std::function<void()> m_afterTicksCallback;
+
+    //! Кадры трансформаций
+    FuryTripleBuffer<Frame> m_frames;
+    //! Трансформации предыдущего кадра читателя
+    QVector<reactphysics3d::Transform> m_previousTransforms;
+    //! Время предыдущего кадра читателя
+    qint64 m_previousTime;
+    //! Номер изменения списка объектов предыдущего кадра читателя
+    quint32 m_previousObjectsVersion;
+
+    //! Запрещаем конструктор копирования
+    FurySimulationThread(const FurySimulationThread&) = delete;
+    //! Запрещаем оператор присваивания
+    FurySimulationThread& operator=(const FurySimulationThread&) = delete;
+};
+
+#endif // FURYSIMULATIONTHREAD_H
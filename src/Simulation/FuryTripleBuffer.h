@@ -0,0 +1,98 @@
+#ifndef FURYTRIPLEBUFFER_H
+#define FURYTRIPLEBUFFER_H
+
+#include <QAtomicInt>
+
+
+/*!
+ * \brief Тройной буфер без блокировок для одного писателя и одного читателя.
+ *
+ * Писатель заполняет свой слот и публикует его, обменивая со средним.
+ * Читатель забирает средний слот, только если там есть новые данные.
+ * Ни одна из сторон не ждёт другую: писатель никогда не пишет в слот,
+ * который сейчас читают, а читатель всегда видит целый кадр.
+ */
+template<typename T>
+class FuryTripleBuffer
+{
+public:
+    //! Конструктор
+    FuryTripleBuffer() :
+        m_writeIndex(0),
+        m_middle(1),
+        m_readIndex(2)
+    {
+
+    }
+
+    /*!
+     * \brief Получение слота писателя
+     * \return Возвращает слот, который можно заполнять
+     */
+    inline T& writeSlot()
+    { return m_slots[m_writeIndex]; }
+
+    //! Публикация слота писателя. После неё writeSlot() указывает на другой слот
+    inline void publish()
+    { m_writeIndex = m_middle.fetchAndStoreAcquireRelease(m_writeIndex | s_freshFlag) & s_indexMask; }
+
+    /*!
+     * \brief Проверка наличия опубликованного слота, ещё не полученного читателем
+     * \return Возвращает true, если update() обновит слот читателя
+     */
+    inline bool hasUpdate() const
+    { return (m_middle.loadAcquire() & s_freshFlag) != 0; }
+
+    /*!
+     * \brief Получение последнего опубликованного слота читателем
+     * \return Возвращает true, если слот читателя обновился
+     */
+    inline bool update()
+    {
+        if (!hasUpdate())
+        {
+            return false;
+        }
+
+        m_readIndex = m_middle.fetchAndStoreAcquireRelease(m_readIndex) & s_indexMask;
+        return true;
+    }
+
+    /*!
+     * \brief Получение слота читателя
+     * \return Возвращает последний полученный update() слот
+     */
+    inline const T& readSlot() const
+    { return m_slots[m_readIndex]; }
+
+    /*!
+     * \brief Доступ ко всем слотам, пока ни писатель, ни читатель не работают.
+     * Например, для выделения памяти перед стартом
+     * \param[in] _index - Индекс слота [0; 2]
+     * \return Возвращает слот
+     */
+    inline T& slot(int _index)
+    { return m_slots[_index]; }
+
+private:
+    //! Маска индекса слота в m_middle
+    static const int s_indexMask = 3;
+    //! Признак неполученных читателем данных в m_middle
+    static const int s_freshFlag = 4;
+
+    //! Слоты
+    T m_slots[3];
+    //! Индекс слота писателя
+    int m_writeIndex;
+    //! Индекс среднего слота и признак новых данных
+    QAtomicInt m_middle;
+    //! Индекс слота читателя
+    int m_readIndex;
+
+    //! Запрещаем конструктор копирования
+    FuryTripleBuffer(const FuryTripleBuffer&) = delete;
+    //! Запрещаем оператор присваивания
+    FuryTripleBuffer& operator=(const FuryTripleBuffer&) = delete;
+};
+
+#endif // FURYTRIPLEBUFFER_H
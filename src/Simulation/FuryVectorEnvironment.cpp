@@ -0,0 +1,205 @@
+#include "FuryVectorEnvironment.h"
+
+#include "CarObject.h"
+#include "FuryWorld.h"
+#include "FurySimulation.h"
+#include "FuryWorldSnapshot.h"
+#include "Learning/FuryPolicyNetwork.h"
+#include "Logger/FuryLogger.h"
+#include "Logger/FuryException.h"
+#include "Managers/FuryWorldManager.h"
+
+#include <QThread>
+#include <algorithm>
+#include <QtConcurrent>
+
+
+FuryVectorEnvironment::FuryVectorEnvironment(int _envCount, int _threadCount,
+                                             const QString &_namePrefix) :
+    m_ticksPerStep(1),
+    m_policy(nullptr)
+{
+    Debug(ru("Создание векторной среды на %1 миров").arg(_envCount));
+
+    FuryWorldManager* worldManager = FuryWorldManager::instance();
+
+    for (int i = 0; i < _envCount; ++i)
+    {
+        FuryWorld& world = worldManager->createIsolatedWorld(QString("%1_%2").arg(_namePrefix).arg(i));
+        m_simulations.append(new FurySimulation(&world));
+        m_envIndices.append(i);
+    }
+
+    if (_threadCount <= 0)
+    {
+        _threadCount = QThread::idealThreadCount();
+    }
+
+    m_threadPool.setMaxThreadCount(qBound(1, _threadCount, qMax(1, _envCount)));
+
+    m_actions.fill(0, _envCount);
+    m_observations.fill(0, _envCount * CarObject::observationSize);
+    m_rewards.fill(0, _envCount);
+    m_dones.fill(false, _envCount);
+}
+
+FuryVectorEnvironment::~FuryVectorEnvironment()
+{
+    Debug(ru("Удаление векторной среды"));
+
+    m_threadPool.waitForDone();
+
+    FuryWorldManager* worldManager = FuryWorldManager::instance();
+
+    for (FurySimulation* simulation : m_simulations)
+    {
+        QString worldName = simulation->world()->objectName();
+        delete simulation;
+        worldManager->deleteWorldByName(worldName);
+    }
+
+    m_simulations.clear();
+}
+
+void FuryVectorEnvironment::setTicksPerStep(int _ticks)
+{
+    m_ticksPerStep = qMax(1, _ticks);
+
+    for (FurySimulation* simulation : m_simulations)
+    {
+        if (simulation->carObject() != nullptr)
+        {
+            simulation->carObject()->setActionRepeat(m_ticksPerStep);
+        }
+    }
+}
+
+void FuryVectorEnvironment::load()
+{
+    // Загрузка идёт последовательно: фабрика объектов и менеджеры ресурсов
+    // рассчитаны на один поток
+    for (FurySimulation* simulation : m_simulations)
+    {
+        simulation->load();
+
+        if (simulation->carObject() == nullptr)
+        {
+            throw FuryException(ru("В мире векторной среды нет машины"),
+                                "simulation->carObject() == nullptr",
+                                Q_FUNC_INFO);
+        }
+
+        simulation->carObject()->setActionRepeat(m_ticksPerStep);
+    }
+
+    reset();
+}
+
+void FuryVectorEnvironment::reset()
+{
+    float* observations = m_observations.data();
+
+    QtConcurrent::blockingMap(&m_threadPool, m_envIndices, [this, observations](int _index)
+    {
+        m_simulations.at(_index)->resetEpisode(observations + _index * CarObject::observationSize);
+    });
+
+    m_rewards.fill(0);
+    m_dones.fill(false);
+}
+
+void FuryVectorEnvironment::captureSnapshot(int _index, FuryWorldSnapshot &_snapshot) const
+{
+    m_simulations.at(_index)->captureSnapshot(_snapshot);
+}
+
+void FuryVectorEnvironment::restoreSnapshot(const FuryWorldSnapshot &_snapshot)
+{
+    float* observations = m_observations.data();
+    QAtomicInt failedCount(0);
+
+    QtConcurrent::blockingMap(&m_threadPool, m_envIndices, [this, observations, &_snapshot, &failedCount](int _index)
+    {
+        if (!m_simulations.at(_index)->restoreSnapshot(_snapshot, observations + _index * CarObject::observationSize))
+        {
+            failedCount.fetchAndAddRelaxed(1);
+        }
+    });
+
+    if (failedCount.loadRelaxed() > 0)
+    {
+        throw FuryException(ru("Снимок не подходит к мирам векторной среды"),
+                            "failedCount > 0",
+                            Q_FUNC_INFO);
+    }
+
+    m_rewards.fill(0);
+    m_dones.fill(false);
+}
+
+void FuryVectorEnvironment::step(const QVector<int> &_actions)
+{
+    if (_actions.size() != m_simulations.size())
+    {
+        throw FuryException(ru("Количество действий не совпадает с количеством миров"),
+                            "_actions.size() != m_simulations.size()",
+                            Q_FUNC_INFO);
+    }
+
+    std::copy(_actions.constBegin(), _actions.constEnd(), m_actions.begin());
+    step();
+}
+
+void FuryVectorEnvironment::step()
+{
+    // Указатели берём до раздачи по потокам, чтобы контейнеры
+    // не отсоединялись (detach) одновременно из нескольких потоков
+    float* observations = m_observations.data();
+    float* rewards = m_rewards.data();
+    bool* dones = m_dones.data();
+
+    if (m_policy != nullptr)
+    {
+        // Один пакетный проход нейросети по наблюдениям всех миров
+        m_policy->predictActions(observations, m_simulations.size(), m_actions.data());
+    }
+
+    QtConcurrent::blockingMap(&m_threadPool, m_envIndices,
+                              [this, observations, rewards, dones](int _index)
+    {
+        stepEnvironment(_index,
+                        observations + _index * CarObject::observationSize,
+                        rewards[_index],
+                        dones[_index]);
+    });
+}
+
+void FuryVectorEnvironment::stepEnvironment(int _index, float *_observation,
+                                            float &_reward, bool &_done)
+{
+    // Только константный доступ: контейнеры общие для всех потоков
+    FurySimulation* simulation = m_simulations.at(_index);
+
+    CarObject* carObject = simulation->carObject();
+    carObject->setBotAction(m_actions.at(_index));
+
+    _reward = 0;
+    _done = false;
+
+    // Действие держится, пока машина не запросит новое решение
+    do
+    {
+        simulation->tickWorld();
+        _reward += simulation->takeReward(_done);
+    }
+    while (!_done && !carObject->isDecisionRequired());
+
+    if (_done)
+    {
+        simulation->resetEpisode(_observation);
+    }
+    else
+    {
+        simulation->writeObservation(_observation);
+    }
+}
@@ -0,0 +1,198 @@
+#ifndef FURYVECTORENVIRONMENT_H
+#define FURYVECTORENVIRONMENT_H
+
+#include <QVector>
+#include <QString>
+#include <QThreadPool>
+
+class FurySimulation;
+class FuryWorldSnapshot;
+class FuryPolicyNetwork;
+
+
+/*!
+ * \brief Векторная среда для обучения.
+ *
+ * Клонирует гоночную трассу в N независимых миров, у каждого своя машина
+ * и свой главный объект физики. Шаг всех миров выполняется параллельно
+ * в пуле потоков, наблюдения складываются в один блок N x 49.
+ */
+class FuryVectorEnvironment
+{
+public:
+    /*!
+     * \brief Конструктор
+     * \param[in] _envCount - Количество миров
+     * \param[in] _threadCount - Количество потоков. 0 - по числу ядер
+     * \param[in] _namePrefix - Префикс названий миров
+     */
+    FuryVectorEnvironment(int _envCount, int _threadCount = 0,
+                          const QString& _namePrefix = "vectorEnv");
+    //! Деструктор
+    ~FuryVectorEnvironment();
+
+    /*!
+     * \brief Загрузка всех миров и первое наблюдение
+     * \throw FuryException - Если в мире нет машины
+     */
+    void load();
+
+    //! Сброс всех миров и новые начальные наблюдения
+    void reset();
+
+    /*!
+     * \brief Снятие состояния одного мира
+     * \param[in] _index - Индекс мира
+     * \param[out] _snapshot - Снимок
+     */
+    void captureSnapshot(int _index, FuryWorldSnapshot& _snapshot) const;
+
+    /*!
+     * \brief Восстановление одного снимка во все миры: несколько прогонов
+     * из одного состояния. Наблюдения пишутся в буфер наблюдений
+     * \param[in] _snapshot - Снимок мира той же сцены
+     * \throw FuryException - Если снимок не подходит к мирам среды
+     */
+    void restoreSnapshot(const FuryWorldSnapshot& _snapshot);
+
+    /*!
+     * \brief Шаг всех миров. Закончившиеся эпизоды сбрасываются автоматически,
+     * для них в наблюдениях лежит начало нового эпизода.
+     * \param[in] _actions - Действия для машин, по одному на мир
+     * \throw FuryException - При неверном количестве действий
+     */
+    void step(const QVector<int>& _actions);
+
+    /*!
+     * \brief Шаг всех миров с действиями из буфера действий (см. actionBuffer).
+     * Каждое действие держится, пока машина не запросит новое решение
+     * (по умолчанию ticksPerStep() тиков), награда за эти тики суммируется.
+     */
+    void step();
+
+    /*!
+     * \brief Установка количества тиков физики на один шаг: повтор действия
+     * всех машин (см. CarObject::setActionRepeat). Повтор отдельной машины
+     * можно потом изменить через simulation(i)->carObject()
+     * \param[in] _ticks - Количество тиков
+     */
+    void setTicksPerStep(int _ticks);
+
+    /*!
+     * \brief Получение количества тиков физики на один шаг
+     * \return Возвращает количество тиков
+     */
+    inline int ticksPerStep() const
+    { return m_ticksPerStep; }
+
+    /*!
+     * \brief Подключение нейросети политики. Пока она подключена, step()
+     * сам выбирает действия всех миров одним пакетным проходом по наблюдениям
+     * \param[in] _policy - Нейросеть политики. nullptr - действия из буфера действий.
+     * Память остаётся за вызывающим
+     */
+    inline void setPolicy(const FuryPolicyNetwork* _policy)
+    { m_policy = _policy; }
+
+    /*!
+     * \brief Получение буфера действий. Заполняется перед step()
+     * \return Возвращает буфер на envCount() действий
+     */
+    inline int* actionBuffer()
+    { return m_actions.data(); }
+
+    /*!
+     * \brief Получение буфера наблюдений
+     * \return Возвращает буфер на envCount() x CarObject::observationSize значений
+     */
+    inline float* observationBuffer()
+    { return m_observations.data(); }
+
+    /*!
+     * \brief Получение буфера наград
+     * \return Возвращает буфер на envCount() значений
+     */
+    inline float* rewardBuffer()
+    { return m_rewards.data(); }
+
+    /*!
+     * \brief Получение буфера признаков окончания эпизода
+     * \return Возвращает буфер на envCount() значений
+     */
+    inline bool* doneBuffer()
+    { return m_dones.data(); }
+
+    /*!
+     * \brief Получение количества миров
+     * \return Возвращает количество миров
+     */
+    inline int envCount() const
+    { return m_simulations.size(); }
+
+    /*!
+     * \brief Получение симуляции мира
+     * \param[in] _index - Индекс мира
+     * \return Возвращает симуляцию мира
+     */
+    inline FurySimulation* simulation(int _index) const
+    { return m_simulations[_index]; }
+
+    /*!
+     * \brief Получение наблюдений
+     * \return Возвращает блок наблюдений: envCount() строк по CarObject::observationSize
+     */
+    inline const QVector<float>& observations() const
+    { return m_observations; }
+
+    /*!
+     * \brief Получение наград за последний шаг
+     * \return Возвращает награды, по одной на мир
+     */
+    inline const QVector<float>& rewards() const
+    { return m_rewards; }
+
+    /*!
+     * \brief Получение признаков окончания эпизода за последний шаг
+     * \return Возвращает признаки окончания эпизода, по одному на мир
+     */
+    inline const QVector<bool>& dones() const
+    { return m_dones; }
+
+private:
+    /*!
+     * \brief Шаг одного мира. Вызывается из пула потоков.
+     * \param[in] _index - Индекс мира
+     * \param[out] _observation - Строка наблюдений мира
+     * \param[out] _reward - Награда за шаг
+     * \param[out] _done - Признак окончания эпизода
+     */
+    void stepEnvironment(int _index, float* _observation, float& _reward, bool& _done);
+
+private:
+    //! Симуляции миров
+    QVector<FurySimulation*> m_simulations;
+    //! Индексы миров для раздачи по потокам
+    QVector<int> m_envIndices;
+    //! Пул потоков для шага миров
+    QThreadPool m_threadPool;
+    //! Количество тиков физики на один шаг
+    int m_ticksPerStep;
+    //! Нейросеть политики. nullptr - действия из буфера действий
+    const FuryPolicyNetwork* m_policy;
+
+    //! Действия на текущий шаг
+    QVector<int> m_actions;
+    //! Наблюдения: envCount() x CarObject::observationSize
+    QVector<float> m_observations;
+    //! Награды за последний шаг
+    QVector<float> m_rewards;
+    //! Признаки окончания эпизода за последний шаг
+    QVector<bool> m_dones;
+
+    //! Запрещаем конструктор копирования
+    FuryVectorEnvironment(const FuryVectorEnvironment&) = delete;
+    //! Запрещаем оператор присваивания
+    FuryVectorEnvironment& operator=(const FuryVectorEnvironment&) = delete;
+};
+
+#endif // FURYVECTORENVIRONMENT_H
@@ -0,0 +1,219 @@
+#include "FuryWorldSnapshot.h"
+
+#include "FuryWorld.h"
+#include "FuryObject.h"
+#include "Logger/FuryLogger.h"
+
+#include <QDataStream>
+#include <cstring>
+
+
+/*!
+ * \brief Запись трансформации в поток
+ * \param[in] _stream - Поток
+ * \param[in] _transform - Трансформация
+ */
+static void writeTransform(QDataStream& _stream, const rp3d::Transform& _transform)
+{
+    const rp3d::Vector3& position = _transform.getPosition();
+    const rp3d::Quaternion& orientation = _transform.getOrientation();
+
+    _stream << position.x << position.y << position.z
+            << orientation.x << orientation.y << orientation.z << orientation.w;
+}
+
+/*!
+ * \brief Чтение трансформации из потока
+ * \param[in] _stream - Поток
+ * \return Возвращает трансформацию
+ */
+static rp3d::Transform readTransform(QDataStream& _stream)
+{
+    rp3d::Vector3 position;
+    rp3d::Quaternion orientation;
+
+    _stream >> position.x >> position.y >> position.z
+            >> orientation.x >> orientation.y >> orientation.z >> orientation.w;
+
+    return rp3d::Transform(position, orientation);
+}
+
+
+FuryWorldSnapshot::FuryWorldSnapshot() :
+    m_objectCount(0)
+{
+
+}
+
+void FuryWorldSnapshot::capture(FuryWorld *_world)
+{
+    const QVector<FuryObject*>& objects = _world->getAllObjects();
+
+    // Ёмкость буферов сохраняется между снятиями
+    m_bodies.resize(0);
+    m_objectStates.resize(0);
+    m_objectCount = objects.size();
+
+    QByteArray state;
+
+    for (int i = 0; i < objects.size(); ++i)
+    {
+        FuryObject* object = objects[i];
+        rp3d::RigidBody* body = object->physicsBody();
+
+        if (body != nullptr && body->getType() != rp3d::BodyType::STATIC)
+        {
+            BodyState bodyState;
+            bodyState.objectIndex = i;
+            bodyState.transform = body->getTransform();
+            bodyState.linearVelocity = body->getLinearVelocity();
+            bodyState.angularVelocity = body->getAngularVelocity();
+            bodyState.worldRotation = object->worldRotation();
+            m_bodies.append(bodyState);
+        }
+
+        state.resize(0);
+        object->saveSnapshotState(state);
+
+        if (!state.isEmpty())
+        {
+            ObjectStateHeader header;
+            header.objectIndex = i;
+            header.size = state.size();
+
+            m_objectStates.append(reinterpret_cast<const char*>(&header), sizeof(header));
+            m_objectStates.append(state);
+        }
+    }
+}
+
+bool FuryWorldSnapshot::restore(FuryWorld *_world) const
+{
+    const QVector<FuryObject*>& objects = _world->getAllObjects();
+
+    if (isEmpty() || objects.size() != m_objectCount)
+    {
+        Debug(ru("[ ВНИМАНИЕ ] Снимок (%1 объектов) не подходит к миру (%2): %3 объектов")
+              .arg(m_objectCount).arg(_world->objectName()).arg(objects.size()));
+        return false;
+    }
+
+    for (const BodyState& bodyState : m_bodies)
+    {
+        objects[bodyState.objectIndex]->restorePhysicsState(bodyState.transform,
+                                                            bodyState.linearVelocity,
+                                                            bodyState.angularVelocity,
+                                                            bodyState.worldRotation);
+    }
+
+    const char* data = m_objectStates.constData();
+    const char* end = data + m_objectStates.size();
+
+    while (data < end)
+    {
+        ObjectStateHeader header;
+        std::memcpy(&header, data, sizeof(header));
+        data += sizeof(header);
+
+        objects[header.objectIndex]->restoreSnapshotState(data, header.size);
+        data += header.size;
+    }
+
+    return true;
+}
+
+void FuryWorldSnapshot::clear()
+{
+    m_objectCount = 0;
+    m_bodies.clear();
+    m_objectStates.clear();
+}
+
+void FuryWorldSnapshot::write(QDataStream &_stream) const
+{
+    _stream << qint32(m_objectCount) << qint32(m_bodies.size());
+
+    for (const BodyState& bodyState : m_bodies)
+    {
+        _stream << qint32(bodyState.objectIndex);
+        writeTransform(_stream, bodyState.transform);
+        _stream << bodyState.linearVelocity.x << bodyState.linearVelocity.y << bodyState.linearVelocity.z
+                << bodyState.angularVelocity.x << bodyState.angularVelocity.y << bodyState.angularVelocity.z
+                << bodyState.worldRotation.x << bodyState.worldRotation.y << bodyState.worldRotation.z;
+    }
+
+    _stream << m_objectStates;
+}
+
+bool FuryWorldSnapshot::read(QDataStream &_stream)
+{
+    clear();
+
+    qint32 objectCount = 0;
+    qint32 bodyCount = 0;
+    _stream >> objectCount >> bodyCount;
+
+    if (_stream.status() != QDataStream::Ok || objectCount < 0
+            || bodyCount < 0 || bodyCount > objectCount)
+    {
+        return false;
+    }
+
+    m_bodies.resize(bodyCount);
+
+    for (BodyState& bodyState : m_bodies)
+    {
+        qint32 objectIndex = 0;
+        _stream >> objectIndex;
+
+        bodyState.objectIndex = objectIndex;
+        bodyState.transform = readTransform(_stream);
+        _stream >> bodyState.linearVelocity.x >> bodyState.linearVelocity.y >> bodyState.linearVelocity.z
+                >> bodyState.angularVelocity.x >> bodyState.angularVelocity.y >> bodyState.angularVelocity.z
+                >> bodyState.worldRotation.x >> bodyState.worldRotation.y >> bodyState.worldRotation.z;
+
+        if (objectIndex < 0 || objectIndex >= objectCount)
+        {
+            clear();
+            return false;
+        }
+    }
+
+    _stream >> m_objectStates;
+
+    if (_stream.status() != QDataStream::Ok)
+    {
+        clear();
+        return false;
+    }
+
+    // Заголовки состояний объектов проверяются до восстановления
+    const char* data = m_objectStates.constData();
+    const char* end = data + m_objectStates.size();
+
+    while (data < end)
+    {
+        ObjectStateHeader header;
+
+        if (end - data < qint64(sizeof(header)))
+        {
+            clear();
+            return false;
+        }
+
+        std::memcpy(&header, data, sizeof(header));
+        data += sizeof(header);
+
+        if (header.objectIndex < 0 || header.objectIndex >= objectCount
+                || header.size < 0 || end - data < header.size)
+        {
+            clear();
+            return false;
+        }
+
+        data += header.size;
+    }
+
+    m_objectCount = objectCount;
+    return true;
+}
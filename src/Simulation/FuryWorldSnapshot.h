@@ -0,0 +1,108 @@
+#ifndef FURYWORLDSNAPSHOT_H
+#define FURYWORLDSNAPSHOT_H
+
+#include <glm/glm.hpp>
+#include <reactphysics3d/reactphysics3d.h>
+
+#include <QVector>
+#include <QByteArray>
+
+class FuryWorld;
+class QDataStream;
+
+
+/*!
+ * \brief Снимок состояния мира: трансформации и скорости всех подвижных тел
+ * и состояние объектов вне физики (счётчики эпизода машины и т.п.).
+ *
+ * Всё лежит в плоских буферах и восстанавливается за один проход, без
+ * рекурсивного пересчёта трансформаций, как в FuryWorld::resetWorld.
+ * Объекты адресуются по индексу в FuryWorld::getAllObjects, поэтому снимок
+ * одного мира можно восстановить в любой мир, загруженный из той же сцены:
+ * так из одного состояния посреди круга запускаются несколько прогонов.
+ */
+class FuryWorldSnapshot
+{
+public:
+    //! Конструктор пустого снимка
+    FuryWorldSnapshot();
+
+    /*!
+     * \brief Снятие состояния мира
+     * \param[in] _world - Мир
+     */
+    void capture(FuryWorld* _world);
+
+    /*!
+     * \brief Восстановление состояния мира
+     * \param[in] _world - Мир той же сцены, что и при снятии
+     * \return Возвращает признак успешного восстановления
+     */
+    bool restore(FuryWorld* _world) const;
+
+    //! Очистка снимка
+    void clear();
+
+    /*!
+     * \brief Запись снимка в поток, например в файл записи эпизода.
+     * Состояния объектов пишутся как есть, в порядке байтов машины
+     * \param[in] _stream - Поток
+     */
+    void write(QDataStream& _stream) const;
+
+    /*!
+     * \brief Чтение снимка из потока
+     * \param[in] _stream - Поток
+     * \return Возвращает признак успешного чтения. При ошибке снимок пуст
+     */
+    bool read(QDataStream& _stream);
+
+    /*!
+     * \brief Получить признак пустого снимка
+     * \return Возвращает true, если состояние ещё не снято
+     */
+    inline bool isEmpty() const
+    { return m_objectCount == 0; }
+
+    /*!
+     * \brief Получить количество подвижных тел в снимке
+     * \return Возвращает количество тел
+     */
+    inline int bodyCount() const
+    { return m_bodies.size(); }
+
+private:
+    //! Состояние подвижного тела
+    struct BodyState
+    {
+        //! Индекс объекта в FuryWorld::getAllObjects
+        int objectIndex;
+        //! Трансформация тела
+        reactphysics3d::Transform transform;
+        //! Линейная скорость
+        reactphysics3d::Vector3 linearVelocity;
+        //! Угловая скорость
+        reactphysics3d::Vector3 angularVelocity;
+        //! Мировое вращение объекта, чтобы не пересчитывать углы Эйлера
+        glm::vec3 worldRotation;
+    };
+
+    //! Заголовок состояния объекта вне физики в m_objectStates
+    struct ObjectStateHeader
+    {
+        //! Индекс объекта в FuryWorld::getAllObjects
+        int objectIndex;
+        //! Размер состояния в байтах, следует сразу за заголовком
+        int size;
+    };
+
+private:
+    //! Количество объектов мира при снятии. 0 - снимок пуст
+    int m_objectCount;
+    //! Состояния подвижных тел
+    QVector<BodyState> m_bodies;
+    //! Состояния объектов вне физики: заголовок и данные подряд
+    QByteArray m_objectStates;
+};
+
+#endif // FURYWORLDSNAPSHOT_H
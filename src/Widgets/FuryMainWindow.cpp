@@ -55,6 +55,11 @@ void FuryMainWindow::onSetWindowTitleSlot(const QString &_title)
     m_ui->statusbar->showMessage(_title);
 }
 
+void FuryMainWindow::onSetStatusMessageSlot(const QString &_message)
+{
+    m_ui->statusbar->showMessage(_message);
+}
+
 void FuryMainWindow::onSetComputerLoadSlot(int _value)
 {
     m_ui->progressBar->setValue(_value);
@@ -88,16 +93,14 @@ void FuryMainWindow::onShadowCamDistanceSliderSlot()
     FuryRenderer::instance()->setShadowCamDistance(value);
 }
 
-void FuryMainWindow::onLearnSpeedCheckBoxSlot()
+void FuryMainWindow::onShadowQualityComboBoxSlot(int _index)
 {
-    if (m_ui->learnSpeedCheckBox->isChecked())
-    {
-        FuryRenderer::instance()->setLearnSpeed(20);
-    }
-    else
-    {
-        FuryRenderer::instance()->setLearnSpeed(1);
-    }
+    FuryRenderer::instance()->setShadowQuality(static_cast<FuryRenderer::ShadowQuality>(_index));
+}
+
+void FuryMainWindow::onLearnSpeedComboBoxSlot(int _index)
+{
+    FuryRenderer::instance()->setSimulationMode(static_cast<FuryRenderer::SimulationMode>(_index));
 }
 
 void FuryMainWindow::onSaveSlot()
@@ -213,8 +216,7 @@ void FuryMainWindow::propertyChangedSlot(const glm::vec3 &_vector)
 
     QVariant prop;
     prop.setValue(_vector);
-    m_currentObject->setProperty(input->property("propName").toByteArray().constData(),
-                                 prop);
+    setCurrentObjectProperty(input->property("propName").toByteArray(), prop);
 }
 
 void FuryMainWindow::propertyChangedSlot(const glm::vec2 &_vector)
@@ -233,8 +235,7 @@ void FuryMainWindow::propertyChangedSlot(const glm::vec2 &_vector)
 
     QVariant prop;
     prop.setValue(_vector);
-    m_currentObject->setProperty(input->property("propName").toByteArray().constData(),
-                                 prop);
+    setCurrentObjectProperty(input->property("propName").toByteArray(), prop);
 }
 
 void FuryMainWindow::propertyChangedSlot()
@@ -251,23 +252,34 @@ void FuryMainWindow::propertyChangedSlot()
         return;
     }
 
-    m_currentObject->setProperty(input->property("propName").toByteArray().constData(),
-                                 input->text());
+    setCurrentObjectProperty(input->property("propName").toByteArray(), input->text());
 }
 
 void FuryMainWindow::resetWorldSlot()
 {
-    FuryRenderer::instance()->getTestWorld()->resetWorld();
+    FuryWorld* world = FuryRenderer::instance()->getTestWorld();
+    FuryRenderer::instance()->runInSimulation([world]()
+    {
+        world->resetWorld();
+    });
 }
 
 void FuryMainWindow::pauseWorldSlot()
 {
-    FuryRenderer::instance()->getTestWorld()->pauseWorld();
+    FuryWorld* world = FuryRenderer::instance()->getTestWorld();
+    FuryRenderer::instance()->runInSimulation([world]()
+    {
+        world->pauseWorld();
+    });
 }
 
 void FuryMainWindow::resumeWorldSlot()
 {
-    FuryRenderer::instance()->getTestWorld()->resumeWorld();
+    FuryWorld* world = FuryRenderer::instance()->getTestWorld();
+    FuryRenderer::instance()->runInSimulation([world]()
+    {
+        world->resumeWorld();
+    });
 }
 
 void FuryMainWindow::prepareUi()
@@ -319,6 +331,8 @@ void FuryMainWindow::initConnections()
 
     connect(FuryRenderer::instance(), &FuryRenderer::setWindowTitleSignal,
             this, &FuryMainWindow::onSetWindowTitleSlot);
+    connect(FuryRenderer::instance(), &FuryRenderer::setStatusMessageSignal,
+            this, &FuryMainWindow::onSetStatusMessageSlot);
     connect(FuryRenderer::instance(), &FuryRenderer::setComputerLoadSignal,
             this, &FuryMainWindow::onSetComputerLoadSlot);
 
@@ -330,9 +344,11 @@ void FuryMainWindow::initConnections()
             this, &FuryMainWindow::onShadowViewSizeSliderSlot);
     connect(m_ui->shadowCamDistanceSlider, &QSlider::valueChanged,
             this, &FuryMainWindow::onShadowCamDistanceSliderSlot);
+    connect(m_ui->shadowQualityComboBox, &QComboBox::currentIndexChanged,
+            this, &FuryMainWindow::onShadowQualityComboBoxSlot);
 
-    connect(m_ui->learnSpeedCheckBox, &QCheckBox::stateChanged,
-            this, &FuryMainWindow::onLearnSpeedCheckBoxSlot);
+    connect(m_ui->learnSpeedComboBox, &QComboBox::currentIndexChanged,
+            this, &FuryMainWindow::onLearnSpeedComboBoxSlot);
     connect(m_ui->saveModelButton, &QPushButton::clicked,
             this, &FuryMainWindow::onSaveSlot);
 
@@ -359,3 +375,12 @@ void FuryMainWindow::loadStyle()
     setStyleSheet(styleStr);
 }
 
+void FuryMainWindow::setCurrentObjectProperty(const QByteArray &_name, const QVariant &_value)
+{
+    FuryObject* object = m_currentObject;
+
+    FuryRenderer::instance()->runInSimulation([object, _name, _value]()
+    {
+        object->setProperty(_name.constData(), _value);
+    });
+}
@@ -55,6 +55,12 @@ private slots:
      */
     void onSetWindowTitleSlot(const QString& _title);
 
+    /*!
+     * \brief Слот вывода сообщения в строку состояния
+     * \param[in] _message - Сообщение
+     */
+    void onSetStatusMessageSlot(const QString& _message);
+
     /*!
      * \brief Слот установки значения загрузки системы
      * \param[in] _value - Значение загрузки системы
@@ -70,9 +76,17 @@ private slots:
     void onShadowViewSizeSliderSlot();
     //! Слот изменения удалённости камеры для теней
     void onShadowCamDistanceSliderSlot();
+    /*!
+     * \brief Слот выбора качества теней
+     * \param[in] _index - Индекс качества FuryRenderer::ShadowQuality
+     */
+    void onShadowQualityComboBoxSlot(int _index);
 
-    //! Слот увеличения скорости обучения
-    void onLearnSpeedCheckBoxSlot();
+    /*!
+     * \brief Слот выбора режима скорости симуляции
+     * \param[in] _index - Индекс режима FuryRenderer::SimulationMode
+     */
+    void onLearnSpeedComboBoxSlot(int _index);
     //! Слот сохранения модели
     void onSaveSlot();
 
@@ -122,6 +136,13 @@ private:
     //! Загрузить стиль приложения
     void loadStyle();
 
+    /*!
+     * \brief Установка свойства текущего объекта в потоке симуляции
+     * \param[in] _name - Название свойства
+     * \param[in] _value - Значение
+     */
+    void setCurrentObjectProperty(const QByteArray& _name, const QVariant& _value);
+
 private:
     //! Интерфейс
     Ui::FuryMainWindow *m_ui;
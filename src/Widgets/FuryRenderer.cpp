@@ -9,10 +9,14 @@
 #include "ParticleSystem.h"
 #include "FuryWorld.h"
 #include "FuryModelCache.h"
+#include "FuryShadowCascades.h"
 #include "FuryTextureCache.h"
 #include "Logger/FuryLogger.h"
 #include "FuryLearningScript.h"
-#include "Physics/FuryEventListener.h"
+#include "Learning/FuryAsyncLearner.h"
+#include "Simulation/FurySimulation.h"
+#include "Simulation/FuryEpisodeRecord.h"
+#include "Simulation/FurySimulationThread.h"
 #include "Managers/FuryModelManager.h"
 #include "Managers/FuryWorldManager.h"
 #include "Managers/FuryShaderManager.h"
@@ -31,6 +35,7 @@
 #include <QTimer>
 #include <QMutex>
 #include <QString>
+#include <QDateTime>
 #include <QThread>
 #include <QJsonArray>
 #include <QMouseEvent>
@@ -45,18 +50,26 @@
 
 const bool NEED_DRAW_SHADOW = true;
 #define NEED_LEARN 0
+//! Обучение в отдельном потоке: симуляция не ждёт шагов обучения
+#define NEED_ASYNC_LEARN 1
+//! Демонстрация обученной модели: машиной управляет нейросеть без Python
+#define NEED_POLICY 0
+//! Повтор действия при обучении: 2 тика по 1/60 секунды, для ИИ 1 решение в 1/30 секунды
+const int LEARN_ACTION_REPEAT = 2;
+//! Ускоренный режим: секунд симуляции за секунду
+const int FAST_SIMULATION_SPEED = 20;
+//! Режим без ограничений: период кадров предпросмотра в миллисекундах
+const qint64 UNCAPPED_PREVIEW_PERIOD = 250;
+//! Период вывода частоты отрисовки и шагов симуляции в миллисекундах
+const qint64 SPEED_READOUT_PERIOD = 1000;
 
 
-const unsigned int SHADOW_WIDTH = 1024 * 4;
-const unsigned int SHADOW_HEIGHT = 1024 * 4;
-
 const unsigned int MAIN_BUFFER_WIDTH = 2048;
 const unsigned int MAIN_BUFFER_HEIGHT = 2048;
 
 
 void renderCube();
 void renderQuad();
-glm::mat4 getLightSpaceMatrix(Camera* _camera, const glm::vec3 &_dirLightPosition);
 
 
 FuryRenderer* FuryRenderer::s_instance = nullptr;
@@ -72,8 +85,11 @@ FuryRenderer::FuryRenderer(QObject *_parent) :
     m_scriptManager(FuryScriptManager::createInstance()),
     m_loadingTextureCache(new FuryTextureCache("Logo")),
     m_cubeModelCache(new FuryModelCache("cube")),
+    m_shadowCascades(new FuryShadowCascades),
     m_needDebugRender(false),
-    m_updateAccumulator(0),
+    m_learner(nullptr),
+    m_simulationThread(nullptr),
+    m_episodeRecord(nullptr),
 
     #if NEED_LEARN == 1
     // m_learnScript(new FuryLearningScript),
@@ -82,7 +98,9 @@ FuryRenderer::FuryRenderer(QObject *_parent) :
     m_learnScript(nullptr),
     #endif
 
-    m_learnSpeed(1),
+    m_simulationMode(SimulationRealTime),
+    m_renderedFrames(0),
+    m_speedTicks(0),
     m_russianKeyMapper(new FuryRussianLocalKeyMapper),
     m_context(new QOpenGLContext(this)),
     m_surface(new QOffscreenSurface(QApplication::primaryScreen(), this))
@@ -110,8 +128,8 @@ FuryRenderer::FuryRenderer(QObject *_parent) :
 
 
     m_testWorld = &(m_worldManager->createWorld("testWorld"));
-    m_eventListener = new FuryEventListener;
-    m_testWorld->physicsWorld()->setEventListener(m_eventListener);
+    m_simulation = new FurySimulation(m_testWorld);
+    m_simulationThread = new FurySimulationThread(m_simulation);
 }
 
 FuryRenderer::~FuryRenderer()
@@ -122,6 +140,9 @@ FuryRenderer::~FuryRenderer()
     delete m_cubeModelCache;
     m_cubeModelCache = nullptr;
 
+    delete m_shadowCascades;
+    m_shadowCascades = nullptr;
+
     delete m_loadingTextureCache;
     m_loadingTextureCache = nullptr;
 
@@ -131,14 +152,25 @@ FuryRenderer::~FuryRenderer()
         camera = nullptr;
     }
 
-    m_testWorld->physicsWorld()->setEventListener(nullptr);
+    // Поток симуляции останавливается первым: он вызывает актор и скрипты
+    delete m_simulationThread;
+    m_simulationThread = nullptr;
+
+    if (m_learner != nullptr)
+    {
+        // Поток обучения останавливается до удаления симуляции и менеджера скриптов
+        m_learner->stop();
+    }
 
-    if (m_eventListener != nullptr)
+    if (m_simulation != nullptr)
     {
-        delete m_eventListener;
-        m_eventListener = nullptr;
+        delete m_simulation;
+        m_simulation = nullptr;
     }
 
+    delete m_learner;
+    m_learner = nullptr;
+
     Debug(ru("Удаление менеджера скриптов..."));
     FuryScriptManager::deleteInstance();
 
@@ -214,6 +246,22 @@ void FuryRenderer::renderMainScene(QOpenGLFramebufferObject* _framebuffer)
         return;
     }
 
+    updateSpeedReadout();
+
+    // Без ограничений кадр рисуется редко, остальное время виджет показывает прошлый
+    if (m_simulationMode == SimulationUncapped)
+    {
+        if (m_previewTimer.isValid() && m_previewTimer.elapsed() < UNCAPPED_PREVIEW_PERIOD)
+        {
+            m_context->doneCurrent();
+            return;
+        }
+
+        m_previewTimer.restart();
+    }
+
+    ++m_renderedFrames;
+
 
     m_dirlight_position.x = sin(currentFrame / 1000 / 4) * 10;
     m_dirlight_position.z = cos(currentFrame / 1000 / 4) * 10;
@@ -223,10 +271,11 @@ void FuryRenderer::renderMainScene(QOpenGLFramebufferObject* _framebuffer)
     // Check if any events have been activiated (key pressed, mouse moved etc.) and call corresponding response functions
     do_movement();
 
-    for (int i = 0; i < m_learnSpeed; ++i)
-    {
-        updatePhysics();
-    }
+    // Физика считается в потоке симуляции, здесь только последний кадр трансформаций
+    m_simulationThread->applyRenderTransforms();
+
+    m_myFirstParticle->Tick(m_deltaTime);
+    m_myFirstParticleSystem->Tick(m_deltaTime);
 
 
     m_cameras[1]->setPosition(m_carObject->cameraPosition());
@@ -235,13 +284,16 @@ void FuryRenderer::renderMainScene(QOpenGLFramebufferObject* _framebuffer)
     glm::vec3 tempPosition = m_dirlight_position;
     tempPosition *= 3;
     tempPosition += m_testWorld->camera()->position();
-    m_sunVisualBox->setWorldPosition(tempPosition);
+    m_simulationThread->post([this, tempPosition]()
+    {
+        m_sunVisualBox->setWorldPosition(tempPosition);
+    });
 
 
     // 1. сначала рисуем карту глубины
     if (NEED_DRAW_SHADOW)
     {
-        drawWorldDepthMap(m_testWorld);
+        drawWorldDepthMap(m_testWorld, _framebuffer->width(), _framebuffer->height());
     }
 
 
@@ -258,23 +310,9 @@ void FuryRenderer::renderMainScene(QOpenGLFramebufferObject* _framebuffer)
 
 
 
-    glm::vec4 planes[6];
-    const glm::mat4& projection = m_testWorld->camera()->getPerspectiveMatrix(_framebuffer->width(), _framebuffer->height(), m_perspective_near, m_perspective_far);
-    const glm::mat4& view =  m_testWorld->camera()->getViewMatrix();
-
-    {
-        glm::mat4 m = glm::transpose(projection * view);
-        planes[0] = m[3] + m[0];
-        planes[1] = m[3] - m[0];
-        planes[2] = m[3] + m[1];
-        planes[3] = m[3] - m[1];
-        planes[4] = m[3] + m[2];
-        planes[5] = m[3] - m[2];
-    }
-
-
-
     drawWorld(m_testWorld, _framebuffer->width(), _framebuffer->height());
+    m_cullingStats = m_lastCulling;
+    m_drawStats = m_lastDrawStats;
 
 
     // ##################################
@@ -322,29 +360,6 @@ void FuryRenderer::initializeGL()
     InitGL();
 }
 
-// \note Пока не удаляю, до выяснения обстоятельств
-//
-// void FuryRenderer::paintGL()
-// {
-//     static int frameCount = 0;
-//     static QDateTime lastTime = QDateTime::currentDateTime();
-
-//     render();
-
-//     frameCount++;
-//     if (frameCount >= 100)
-//     {
-//         QDateTime current = QDateTime::currentDateTime();
-//         QString test = ru("FPS: %1; Эквивалентный FPS: %2")
-//                            .arg(1000.0 / lastTime.msecsTo(current) * frameCount)
-//                            .arg(1000.0 / lastTime.msecsTo(current) * frameCount * m_learnSpeed);
-//         emit setWindowTitleSignal(test);
-
-//         lastTime = current;
-//         frameCount = 0;
-//     }
-// }
-
 void FuryRenderer::setCameraZoomValue(int _value)
 {
     for (Camera* camera : m_cameras)
@@ -353,11 +368,100 @@ void FuryRenderer::setCameraZoomValue(int _value)
     }
 }
 
+void FuryRenderer::setSimulationMode(SimulationMode _mode)
+{
+    m_simulationMode = _mode;
+    m_previewTimer.invalidate();
+
+    switch (_mode)
+    {
+    case SimulationRealTime:
+        m_simulationThread->setSpeed(1);
+        break;
+    case SimulationFast:
+        m_simulationThread->setSpeed(FAST_SIMULATION_SPEED);
+        break;
+    case SimulationUncapped:
+        m_simulationThread->setSpeed(0);
+        break;
+    }
+
+    Debug(ru("Режим скорости симуляции: %1").arg(_mode));
+}
+
+void FuryRenderer::updateSpeedReadout()
+{
+    if (!m_speedTimer.isValid())
+    {
+        m_speedTimer.start();
+        m_speedTicks = m_simulationThread->tickCount();
+        m_renderedFrames = 0;
+        return;
+    }
+
+    qint64 elapsed = m_speedTimer.elapsed();
+
+    if (elapsed < SPEED_READOUT_PERIOD)
+    {
+        return;
+    }
+
+    quint64 ticks = m_simulationThread->tickCount();
+    double seconds = elapsed / 1000.0;
+    double stepsPerSecond = (ticks - m_speedTicks) / seconds;
+
+    emit setStatusMessageSignal(ru("Кадров/с: %1; Шагов симуляции/с: %2 (x%3 к реальному времени); Мешей в кадре: %4 из %5, в карте теней: %6; Смен шейдера: %7, материала: %8")
+                                .arg(m_renderedFrames / seconds, 0, 'f', 1)
+                                .arg(stepsPerSecond, 0, 'f', 0)
+                                .arg(stepsPerSecond * m_simulation->timeStep(), 0, 'f', 1)
+                                .arg(m_cullingStats.visible)
+                                .arg(m_cullingStats.tested)
+                                .arg(m_shadowDrawnEntries)
+                                .arg(m_drawStats.shaderBinds)
+                                .arg(m_drawStats.materialBinds));
+
+    m_speedTimer.restart();
+    m_speedTicks = ticks;
+    m_renderedFrames = 0;
+}
+
+void FuryRenderer::toggleEpisodeRecord()
+{
+    m_simulationThread->post([this]()
+    {
+        if (m_episodeRecord == nullptr)
+        {
+            m_episodeRecord = new FuryEpisodeRecord;
+            m_episodeRecord->begin(m_simulation);
+            m_simulation->attachRecord(m_episodeRecord);
+            return;
+        }
+
+        m_simulation->attachRecord(nullptr);
+        m_episodeRecord->finish(m_simulation);
+
+        QDir().mkpath("records");
+        m_episodeRecord->save(QString("records/%1.frec")
+                              .arg(QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss")));
+
+        delete m_episodeRecord;
+        m_episodeRecord = nullptr;
+    });
+}
+
+void FuryRenderer::runInSimulation(const std::function<void ()> &_command)
+{
+    m_simulationThread->post(_command);
+}
+
 void FuryRenderer::saveLearnModel()
 {
 #if NEED_LEARN == 1
     // m_learnScript->saveModel();
-    m_scriptManager->processStop();
+    m_simulationThread->post([this]()
+    {
+        m_scriptManager->processStop();
+    });
 #endif
 }
 
@@ -429,7 +533,10 @@ void FuryRenderer::keyPressEvent(QKeyEvent *_event)
 
     if (m_testWorld->camera() == m_cameras[1])
     { // Если камера машины
-        m_carObject->keyPressEvent(keyCode);
+        m_simulationThread->post([this, keyCode]()
+        {
+            m_carObject->keyPressEvent(keyCode);
+        });
     }
 
 
@@ -442,9 +549,17 @@ void FuryRenderer::keyPressEvent(QKeyEvent *_event)
         else
         {
             m_testWorld->setCamera(m_cameras[0]);
-            m_carObject->resetKeyInput();
+            m_simulationThread->post([this]()
+            {
+                m_carObject->resetKeyInput();
+            });
         }
     }
+
+    if (keyCode == Qt::Key_F9 && !_event->isAutoRepeat())
+    {
+        toggleEpisodeRecord();
+    }
 }
 
 void FuryRenderer::keyReleaseEvent(QKeyEvent *_event)
@@ -459,7 +574,10 @@ void FuryRenderer::keyReleaseEvent(QKeyEvent *_event)
 
     if (m_testWorld->camera() == m_cameras[1])
     { // Если камера машины
-        m_carObject->keyReleaseEvent(keyCode);
+        m_simulationThread->post([this, keyCode]()
+        {
+            m_carObject->keyReleaseEvent(keyCode);
+        });
     }
 }
 
@@ -517,25 +635,59 @@ void FuryRenderer::drawWorld(FuryWorld *_world, int _width, int _height)
     float perspective_far = 300.f;
 
 
-    QVector<QPair<FuryObject*, FuryMesh*>> solidComponents;
-    QVector<QPair<FuryObject*, FuryMesh*>> transparentComponents;
-
-    _world->fillDrawComponents(solidComponents, transparentComponents);
+    FuryRenderList* renderList = _world->renderList();
+    renderList->update();
 
 
     const glm::mat4& projection = _world->camera()->getPerspectiveMatrix(_width, _height,
                                                                         perspective_near,
                                                                         perspective_far);
     const glm::mat4& view = _world->camera()->getViewMatrix();
-    glm::mat4 lightSpaceMatrix = getLightSpaceMatrix(_world->camera(), _world->dirLightPosition());
 
     drawSelectedInEditor(_world, projection, view);
 
-    for (QPair<FuryObject*, FuryMesh*>& pair : solidComponents)
+    // Отсечение до цикла отрисовки: границы всех записей проверяются пакетом
+    m_lastCulling = renderList->cull(_world->camera()->frustum(), m_visibleEntries);
+
+    // Прозрачность материала может меняться без уведомлений - делим каждый кадр
+    QVector<const FuryRenderList::Entry*> transparentEntries;
+    const QVector<FuryRenderList::Entry>& entries = renderList->entries();
+    m_opaqueQueue.clear();
+
+    for (int i = 0; i < entries.size(); ++i)
+    {
+        const FuryRenderList::Entry& entry = entries[i];
+
+        if (!m_visibleEntries[i] || !entry.object->visible())
+        {
+            continue;
+        }
+
+        if (entry.material->opacity() >= 0.95)
+        {
+            m_opaqueQueue.append(qMakePair(entry.sortKey, &entry));
+        }
+        else
+        {
+            transparentEntries.append(&entry);
+        }
+    }
+
+    // Непрозрачные меши рисуются группами по шейдеру и материалу:
+    // состояние меняется только на границах групп
+    std::sort(m_opaqueQueue.begin(), m_opaqueQueue.end(),
+              [](const auto& p1, const auto& p2){return p1.first < p2.first;});
+
+    m_lastDrawStats = DrawStats();
+    resetDrawState();
+
+    for (const auto& item : m_opaqueQueue)
     {
-        drawComponent(_world, pair, projection, view, lightSpaceMatrix);
+        drawComponent(_world, *item.second, projection, view);
     }
 
+    glActiveTexture(GL_TEXTURE0);
+
 
     {
         // draw skybox as last
@@ -558,114 +710,147 @@ void FuryRenderer::drawWorld(FuryWorld *_world, int _width, int _height)
     }
 
     {
-        QList<QPair<float, QPair<FuryObject*, FuryMesh*>>> sorted;
-        for (unsigned int i = 0; i < transparentComponents.size(); i++){
-            float distance = glm::length(_world->camera()->position() - transparentComponents[i].first->worldPosition());
-            sorted.append(qMakePair(distance, transparentComponents[i]));
+        QList<QPair<float, const FuryRenderList::Entry*>> sorted;
+        for (int i = 0; i < transparentEntries.size(); i++){
+            float distance = glm::length(_world->camera()->position() - transparentEntries[i]->object->renderPosition());
+            sorted.append(qMakePair(distance, transparentEntries[i]));
         }
 
         std::sort(sorted.begin(), sorted.end(), [](auto& p1, auto& p2){return p1.first < p2.first;});
 
+        // Фон сменил программу и текстуру окружения
+        resetDrawState();
+
         for (int i = sorted.size() - 1; i >= 0; --i)
         {
-            QPair<FuryObject*, FuryMesh*>& pair = sorted[i].second;
-            drawComponent(_world, pair, projection, view, lightSpaceMatrix);
+            drawComponent(_world, *sorted[i].second, projection, view);
         }
 
         sorted.clear();
+        glActiveTexture(GL_TEXTURE0);
     }
 }
 
-void FuryRenderer::drawWorldDepthMap(FuryWorld *_world)
+void FuryRenderer::drawWorldDepthMap(FuryWorld *_world, int _width, int _height)
 {
-    const unsigned int SHADOW_WIDTH = 1024 * 4;
-    const unsigned int SHADOW_HEIGHT = 1024 * 4;
-
     static Shader* simpleDepthShader = new Shader("simpleDepthShader.vs", "simpleDepthShader.fs");
-    glm::mat4 lightSpaceMatrix = getLightSpaceMatrix(_world->camera(), _world->dirLightPosition());
 
-    simpleDepthShader->use();
-    simpleDepthShader->setMat4("lightSpaceMatrix", lightSpaceMatrix);
+    FuryShadowCascades* cascades = _world->shadowCascades();
+    if (cascades == nullptr)
+    {
+        return;
+    }
 
-    glViewport(0, 0, SHADOW_WIDTH, SHADOW_HEIGHT);
-    glBindFramebuffer(GL_FRAMEBUFFER, _world->depthMapFBO());
-    glClear(GL_DEPTH_BUFFER_BIT);
+    cascades->setRange(m_shadowNear, m_shadowPlane, m_shadowViewSize, m_shadowCamDistance);
+    cascades->update(_world->camera(), (float)_width / (float)_height, _world->dirLightPosition());
 
+    FuryRenderList* renderList = _world->renderList();
+    renderList->update();
 
-    QVector<FuryObject*> testWorldObjects = _world->getRootObjects();
-    QVector<QPair<FuryObject*, FuryMesh*>> meshesForRender;
+    m_shadowCullingStats = FuryRenderList::CullingStats();
+    m_shadowDrawnEntries = 0;
 
-    for (int i = 0; i < testWorldObjects.size(); ++i)
+    const QVector<FuryRenderList::Entry>& entries = renderList->entries();
+    auto drawEntries = [&](bool _static)
     {
-        FuryObject* obj = testWorldObjects[i];
-        foreach (QObject* child, obj->children())
+        for (int i = 0; i < entries.size(); ++i)
         {
-            FuryObject* obj = qobject_cast<FuryObject*>(child);
-            if (obj != nullptr)
+            const FuryRenderList::Entry& entry = entries[i];
+
+            if (entry.isStatic != _static || !m_visibleEntries[i]
+                    || !entry.castsShadow || !entry.object->visible())
             {
-                testWorldObjects.append(obj);
+                continue;
             }
-        }
 
-        if (!obj->visible())
-        {
-            continue;
+            simpleDepthShader->setMat4("model", entry.object->renderModelMatrix() * entry.mesh->transformation());
+            entry.mesh->draw();
+            ++m_shadowDrawnEntries;
         }
 
-        const FuryModel& model = obj->modelCache()->model();
-        foreach (FuryMesh* mesh, model.meshes())
-        {
-            meshesForRender.append(qMakePair(obj, mesh));
-        }
-    }
+        glBindVertexArray(0);
+        glActiveTexture(GL_TEXTURE0);
+    };
 
-    for (QPair<FuryObject*, FuryMesh*>& pair : meshesForRender)
+    simpleDepthShader->use();
+
+    for (int cascade = 0; cascade < cascades->cascadeCount(); ++cascade)
     {
-        FuryObject* obj = pair.first;
-        FuryMesh* mesh = pair.second;
-
-        //        if (obj->objectName().startsWith("Trigger"))
-        //        {
-        //            continue;
-        //        }
-        if (obj->objectName() == "sunVisualBox")
+        const glm::mat4& lightSpaceMatrix = cascades->lightSpaceMatrix(cascade);
+        int resolution = cascades->resolution(cascade);
+
+        // Ортографический объём каскада - та же пирамида видимости
+        FuryRenderList::CullingStats stats = renderList->cull(FuryFrustum(lightSpaceMatrix), m_visibleEntries);
+        m_shadowCullingStats.tested += stats.tested;
+        m_shadowCullingStats.visible += stats.visible;
+
+        simpleDepthShader->setMat4("lightSpaceMatrix", lightSpaceMatrix);
+        glViewport(0, 0, resolution, resolution);
+
+        if (cascades->needStaticRedraw(cascade, renderList->staticVersion()))
         {
-            continue;
-        }
+            glBindFramebuffer(GL_FRAMEBUFFER, cascades->staticDepthMapFBO(cascade));
+            glClear(GL_DEPTH_BUFFER_BIT);
+            drawEntries(true);
 
-        glm::mat4 modelMatrix = obj->getOpenGLTransform();
-        modelMatrix = glm::scale(modelMatrix, obj->scales());
-        modelMatrix *= obj->modelTransform();
-        modelMatrix *= mesh->transformation();
-        simpleDepthShader->setMat4("model", modelMatrix);
+            cascades->markStaticDrawn(cascade, renderList->staticVersion());
+        }
 
+        // Статический слой копируется в карту теней, подвижные меши рисуются поверх
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, cascades->staticDepthMapFBO(cascade));
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, cascades->depthMapFBO(cascade));
+        glBlitFramebuffer(0, 0, resolution, resolution,
+                          0, 0, resolution, resolution,
+                          GL_DEPTH_BUFFER_BIT, GL_NEAREST);
 
-        mesh->draw();
+        glBindFramebuffer(GL_FRAMEBUFFER, cascades->depthMapFBO(cascade));
+        drawEntries(false);
+    }
+}
 
+void FuryRenderer::setShadowQuality(ShadowQuality _quality)
+{
+    m_shadowQuality = _quality;
 
-        glBindVertexArray(0);
-        glActiveTexture(GL_TEXTURE0);
+    switch (_quality)
+    {
+    case ShadowLow:
+        m_shadowCascades->setCascadeCount(1);
+        m_shadowCascades->setResolution(0, 1024);
+        break;
+    case ShadowMedium:
+        m_shadowCascades->setCascadeCount(3);
+        m_shadowCascades->setResolution(0, 2048);
+        m_shadowCascades->setResolution(1, 1024);
+        m_shadowCascades->setResolution(2, 1024);
+        break;
+    case ShadowHigh:
+        m_shadowCascades->setCascadeCount(3);
+        m_shadowCascades->setResolution(0, 4096);
+        m_shadowCascades->setResolution(1, 2048);
+        m_shadowCascades->setResolution(2, 1024);
+        break;
     }
+
+    Debug(ru("Качество теней: %1").arg(_quality));
+}
+
+void FuryRenderer::setShadowCascadeCount(int _count)
+{
+    m_shadowCascades->setCascadeCount(_count);
+}
+
+void FuryRenderer::setShadowResolution(int _cascade, int _resolution)
+{
+    m_shadowCascades->setResolution(_cascade, _resolution);
 }
 
 void FuryRenderer::drawSelectedInEditor(FuryWorld *_world,
                                         const glm::mat4 &_projection,
                                         const glm::mat4 &_view)
 {
-    QVector<FuryObject*> testWorldObjects = _world->getRootObjects();
-
-    for (int i = 0; i < testWorldObjects.size(); ++i)
+    for (FuryObject* obj : _world->renderList()->objects())
     {
-        FuryObject* obj = testWorldObjects[i];
-        foreach (QObject* child, obj->children())
-        {
-            FuryObject* obj = qobject_cast<FuryObject*>(child);
-            if (obj != nullptr)
-            {
-                testWorldObjects.append(obj);
-            }
-        }
-
         if (!obj->visible())
         {
             continue;
@@ -724,7 +909,7 @@ void FuryRenderer::drawSelectedInEditor(FuryWorld *_world,
                 shader->setBool("shadowMapEnabled", false);
             }
 
-            glm::mat4 modelMatrix = obj->getOpenGLTransform();
+            glm::mat4 modelMatrix = obj->renderTransform();
             modelMatrix = glm::scale(modelMatrix, glm::vec3(obj->scales().x,
                                                             obj->scales().y,
                                                             obj->scales().z));
@@ -757,52 +942,71 @@ void FuryRenderer::drawSelectedInEditor(FuryWorld *_world,
 }
 
 void FuryRenderer::drawComponent(FuryWorld *_world,
-                                 const QPair<FuryObject *, FuryMesh *> &_component,
+                                 const FuryRenderList::Entry &_entry,
                                  const glm::mat4 &_projection,
-                                 const glm::mat4 &_view,
-                                 const glm::mat4 &_lightSpaceMatrix)
+                                 const glm::mat4 &_view)
 {
-    FuryObject* obj = _component.first;
-    FuryMesh* mesh = _component.second;
+    FuryObject* obj = _entry.object;
+    FuryMesh* mesh = _entry.mesh;
+    Shader* shader = _entry.shader;
 
-    if (!m_shaderManager->containsShader(obj->shaderName()))
+    // Об отсутствии шейдера список отрисовки сообщает один раз при сборке
+    if (shader == nullptr)
     {
-        qDebug() << ru("Менеджер шейдеров не содержит шейдер") << obj->shaderName();
         return;
     }
 
-    Shader* shader = m_shaderManager->shaderByName(obj->shaderName());
+    if (shader != m_boundShader)
+    {
+        bindShaderFrameState(_world, shader, _projection, _view);
+        m_boundShader = shader;
+        m_boundMaterial = nullptr;
+        ++m_lastDrawStats.shaderBinds;
+    }
 
-    if (shader == nullptr)
+    if (_entry.material != m_boundMaterial)
     {
-        qDebug() << ru("Не удалось получить шейдер") << obj->shaderName();
-        return;
+        _entry.material->setShaderMaterial(shader);
+        m_boundMaterial = _entry.material;
+        ++m_lastDrawStats.materialBinds;
     }
 
-    shader->use();
-    shader->setVec3("viewPos", _world->camera()->position());
-    shader->setFloat("material.shininess", 128.0f); // 32.0 - default
-    shader->setVec3("dirLight.direction", glm::vec3(0, 0, 0) - _world->dirLightPosition());
+    shader->setVec2("textureScales", obj->textureScales());
 
+    // Матрицы объекта кэшируются до его движения, матрица нормалей
+    // произведения - произведение матриц нормалей
+    shader->setMat4("model", obj->renderModelMatrix() * mesh->transformation());
+    shader->setMat3("normalMatrix", obj->renderNormalMatrix() * mesh->normalMatrix());
 
-    // view/projection transformations
-    shader->setMat4("projection", _projection);
-    shader->setMat4("view", _view);
+    mesh->draw();
+}
 
-    shader->setMat4("lightSpaceMatrix", _lightSpaceMatrix);
-    shader->setVec2("textureScales", obj->textureScales());
+void FuryRenderer::bindShaderFrameState(FuryWorld *_world,
+                                        Shader *_shader,
+                                        const glm::mat4 &_projection,
+                                        const glm::mat4 &_view)
+{
+    _shader->use();
+    _shader->setVec3("viewPos", _world->camera()->position());
+    _shader->setFloat("material.shininess", 128.0f); // 32.0 - default
+    _shader->setVec3("dirLight.direction", glm::vec3(0, 0, 0) - _world->dirLightPosition());
+
+
+    // view/projection transformations
+    _shader->setMat4("projection", _projection);
+    _shader->setMat4("view", _view);
 
 
     {
-        shader->setVec3("camPos", _world->camera()->position());
+        _shader->setVec3("camPos", _world->camera()->position());
 
         glm::vec3 tempPosition = _world->dirLightPosition();
         tempPosition *= 3;
 
-        shader->setVec3("lightPositions[0]", tempPosition);
-        shader->setVec3("lightPositions[1]", tempPosition);
-        shader->setVec3("lightPositions[2]", tempPosition);
-        shader->setVec3("lightPositions[3]", tempPosition);
+        _shader->setVec3("lightPositions[0]", tempPosition);
+        _shader->setVec3("lightPositions[1]", tempPosition);
+        _shader->setVec3("lightPositions[2]", tempPosition);
+        _shader->setVec3("lightPositions[3]", tempPosition);
 
         glActiveTexture(GL_TEXTURE0);
         glBindTexture(GL_TEXTURE_CUBE_MAP, _world->irradianceMap());
@@ -810,43 +1014,28 @@ void FuryRenderer::drawComponent(FuryWorld *_world,
         glBindTexture(GL_TEXTURE_CUBE_MAP, _world->prefilterMap());
         glActiveTexture(GL_TEXTURE2);
         glBindTexture(GL_TEXTURE_2D,_world->brdfLUTTexture());
-        glActiveTexture(GL_TEXTURE8);
-        shader->setBool("shadowMapEnabled", _world->shadowMapEnabled());
 
-        if (_world->shadowMapEnabled())
-        {
-            glBindTexture(GL_TEXTURE_2D, _world->depthMap());
-        }
-        else
-        {
-            glBindTexture(GL_TEXTURE_2D, 0);
-        }
-    }
+        FuryShadowCascades* cascades = _world->shadowCascades();
+        int cascadeCount = cascades != nullptr ? cascades->cascadeCount() : 0;
+        _shader->setBool("shadowMapEnabled", _world->shadowMapEnabled());
+        _shader->setInt("cascadeCount", cascadeCount);
 
-    glm::mat4 modelMatrix = obj->getOpenGLTransform();
-    modelMatrix = glm::scale(modelMatrix, obj->scales());
-    modelMatrix *= obj->modelTransform();
-    modelMatrix *= mesh->transformation();
-    shader->setMat4("model", modelMatrix);
-    shader->setMat3("normalMatrix", glm::transpose(glm::inverse(glm::mat3(modelMatrix))));
+        for (int i = 0; i < FuryShadowCascades::maxCascades; ++i)
+        {
+            glActiveTexture(GL_TEXTURE8 + i);
 
-    FuryMaterial* material = nullptr;
-    if (m_materialManager->materialExist(obj->materialName()))
-    {
-        material = m_materialManager->materialByName(obj->materialName());
-    }
-    else
-    {
-        material = m_materialManager->materialByName(mesh->materialName());
+            if (i < cascadeCount)
+            {
+                _shader->setMat4(QString("lightSpaceMatrices[%1]").arg(i), cascades->lightSpaceMatrix(i));
+                _shader->setFloat(QString("cascadeFar[%1]").arg(i), cascades->splitFar(i));
+                glBindTexture(GL_TEXTURE_2D, cascades->depthMap(i));
+            }
+            else
+            {
+                glBindTexture(GL_TEXTURE_2D, 0);
+            }
+        }
     }
-
-    material->setShaderMaterial(shader);
-
-    mesh->draw();
-
-
-    glBindVertexArray(0);
-    glActiveTexture(GL_TEXTURE0);
 }
 
 void FuryRenderer::init() {
@@ -875,35 +1064,43 @@ void FuryRenderer::init() {
     FuryWorld& world = m_worldManager->createWorld("materialPreview");
     world.setCamera(m_cameras[2]);
     world.addRootObject(new FurySphereObject(&world));
-    world.createPbrCubemap("textures/hdr/newport_loft3.hdr");
+    createWorldPbrCubemap(&world, "textures/hdr/newport_loft3.hdr");
 
-    m_testWorld->createPbrCubemap("textures/hdr/newport_loft3.hdr");
-    m_testWorld->createDepthMap();
+    createWorldPbrCubemap(m_testWorld, "textures/hdr/newport_loft3.hdr");
+    createWorldDepthMap(m_testWorld);
 
     //
     // МАШИНА
     //
 
-    m_testWorld->load();
+    m_simulation->load();
+    m_carObject = m_simulation->carObject();
 
-    foreach (FuryObject* obj, m_testWorld->getRootObjects())
-    {
-        if (obj->objectName() == "AI_car")
-        {
-            m_carObject = qobject_cast<CarObject*>(obj);
-            break;
-        }
-    }
-
-    m_eventListener->setCarObject(m_carObject);
+#if NEED_LEARN == 1
+    m_carObject->setActionRepeat(LEARN_ACTION_REPEAT);
+#endif
 
+#if NEED_LEARN == 1 && NEED_ASYNC_LEARN == 1
+    m_learner = new FuryAsyncLearner(CarObject::observationSize, 9);
+    m_simulation->attachLearner(m_learner);
+    m_learner->start("scripts.async_learner");
+#elif NEED_LEARN == 1
+    m_simulation->attachScript("scripts.test");
+#elif NEED_POLICY == 1
+    m_simulation->attachPolicy("saved-model/policy.bin");
+#endif
 
-#if NEED_LEARN == 1
-    m_scriptManager->importScript("scripts.test");
-    m_scriptManager->createObject(m_carObject, "scripts.test");
-    m_scriptManager->processStart();
+#if NEED_LEARN == 0
+    // Лучи датчика для отладочной отрисовки
+    m_simulationThread->setAfterTicksCallback([this]()
+    {
+        m_carObject->getRays();
+    });
 #endif
 
+    setSimulationMode(m_simulationMode);
+    m_simulationThread->start();
+
 
     m_particleShader = new Shader("particle.vs", "particle.fs");
 
@@ -948,7 +1145,10 @@ void FuryRenderer::init() {
             shader->setInt("material.metallicMap", 5);
             shader->setInt("material.roughnessMap", 6);
             shader->setInt("material.aoMap", 7);
-            shader->setInt("shadowMap", 8);
+            shader->setInt("shadowMaps[0]", 8);
+            shader->setInt("shadowMaps[1]", 9);
+            shader->setInt("shadowMaps[2]", 10);
+            shader->setInt("shadowMaps[3]", 11);
         }
     }
 }
@@ -1189,43 +1389,6 @@ void FuryRenderer::renderLoading()
     glClear(GL_COLOR_BUFFER_BIT);
 }
 
-void FuryRenderer::updatePhysics()
-{
-    float timeStep = 1.0f / 60.0f;
-
-#if NEED_LEARN == 0
-    m_updateAccumulator += m_deltaTime;
-
-    while (m_updateAccumulator >= timeStep)
-    {
-#endif
-
-    // Выполняем 2 тика по 1/60 секунды. Для ИИ получается 1 тик в 1/30 секунды
-//    int iCount = (m_learnSpeed == 1) ? 1 : 2;
-//    for (int i = 0; i < iCount; ++i)
-    {
-        m_myFirstParticle->Tick(timeStep);
-        m_myFirstParticleSystem->Tick(timeStep);
-
-        m_testWorld->tick(timeStep);
-    }
-
-#if NEED_LEARN == 0
-        m_updateAccumulator -= timeStep;
-    }
-#endif
-
-
-
-#if NEED_LEARN == 1
-
-    m_scriptManager->processUpdate();
-
-#else
-    m_carObject->getRays();
-#endif
-}
-
 void FuryRenderer::displayBuffer(GLuint _bufferId)
 {
     static Shader* shader = nullptr;
@@ -1369,27 +1532,21 @@ void FuryRenderer::do_movement()
         m_testWorld->camera()->processKeyboard(Down, m_deltaTime);
 }
 
-void FuryRenderer::createDepthMap(GLuint* _depthMapFBO, GLuint* _depthMap)
+void FuryRenderer::createWorldPbrCubemap(FuryWorld *_world, const QString &_cubemapHdrPath)
 {
-    // Создадим буфер глубины для теней
-    glGenFramebuffers(1, _depthMapFBO);
-
-    // Создадим текстуру для буфера
-    glGenTextures(1, _depthMap);
-    glBindTexture(GL_TEXTURE_2D, *_depthMap);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, SHADOW_WIDTH, SHADOW_HEIGHT, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
-    float borderColor[] = { 1.0f, 1.0f, 1.0f, 1.0f };
-    glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
-
-    glBindFramebuffer(GL_FRAMEBUFFER, *_depthMapFBO);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, *_depthMap, 0);
-    glDrawBuffer(GL_NONE);
-    glReadBuffer(GL_NONE);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    GLuint envCubemap = 0;
+    GLuint irradianceMap = 0;
+    GLuint prefilterMap = 0;
+    GLuint brdfLUTTexture = 0;
+
+    createPBRTextures(_cubemapHdrPath, &envCubemap, &irradianceMap, &prefilterMap, &brdfLUTTexture);
+    _world->setPbrCubemap(envCubemap, irradianceMap, prefilterMap, brdfLUTTexture);
+}
+
+void FuryRenderer::createWorldDepthMap(FuryWorld *_world)
+{
+    // Буферы каскадов создаются при первом проходе теней
+    _world->setShadowCascades(m_shadowCascades);
 }
 
 void FuryRenderer::loadRaceMapFromJson()
@@ -1432,36 +1589,90 @@ void renderQuad()
     glBindVertexArray(0);
 }
 
+static GLuint cubeVAO = 0;
+static GLuint cubeVBO = 0;
 
-
-
-
-
-glm::mat4 getLightSpaceMatrix(Camera* _camera, const glm::vec3 &_dirLightPosition)
+// renderCube() renders a 1x1 3D cube in NDC.
+// -------------------------------------------------
+void createBoxModel()
 {
-    float shadowNear = 0.1f;
-    float shadowPlane = 70.f;
-    float shadowViewSize = 25.f;
-    float shadowCamDistance = 37;
-
-    glm::mat4 lightProjection = glm::ortho(-shadowViewSize, shadowViewSize,
-                                           -shadowViewSize, shadowViewSize,
-                                           shadowNear, shadowPlane);
-
-    glm::vec3 tempDirLight = glm::normalize(_dirLightPosition);
-    tempDirLight *= shadowCamDistance;
-
-    glm::vec3 cameraPos = _camera->position();
-    glm::vec3 cameraFront = _camera->front();
-    cameraFront *= 15;
+    if (cubeVAO != 0)
+    {
+        return;
+    }
 
-    glm::vec3 shadowCameraView = cameraPos + cameraFront;
-    shadowCameraView.y = 0;
-    glm::vec3 shadowCameraPos = shadowCameraView + tempDirLight;
+    float vertices[] = {
+        // back face
+        -0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f, 4.0f / 4.0f, 1.0f / 3.0f, // bottom-left
+         0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f, 3.0f / 4.0f, 2.0f / 3.0f, // top-right
+         0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f, 3.0f / 4.0f, 1.0f / 3.0f, // bottom-right
+         0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f, 3.0f / 4.0f, 2.0f / 3.0f, // top-right
+        -0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f, 4.0f / 4.0f, 1.0f / 3.0f, // bottom-left
+        -0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f, 4.0f / 4.0f, 2.0f / 3.0f, // top-left
+        // front face
+        -0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f, 1.0f / 4.0f, 1.0f / 3.0f, // bottom-left
+         0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f, 2.0f / 4.0f, 1.0f / 3.0f, // bottom-right
+         0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f, 2.0f / 4.0f, 2.0f / 3.0f, // top-right
+         0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f, 2.0f / 4.0f, 2.0f / 3.0f, // top-right
+        -0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f, 1.0f / 4.0f, 2.0f / 3.0f, // top-left
+        -0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f, 1.0f / 4.0f, 1.0f / 3.0f, // bottom-left
+        // left face
+        -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f, 1.0f / 4.0f, 2.0f / 3.0f, // top-right
+        -0.5f,  0.5f, -0.5f, -1.0f,  0.0f,  0.0f, 0.0f / 4.0f, 2.0f / 3.0f, // top-left
+        -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f, 0.0f / 4.0f, 1.0f / 3.0f, // bottom-left
+        -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f, 0.0f / 4.0f, 1.0f / 3.0f, // bottom-left
+        -0.5f, -0.5f,  0.5f, -1.0f,  0.0f,  0.0f, 1.0f / 4.0f, 1.0f / 3.0f, // bottom-right
+        -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f, 1.0f / 4.0f, 2.0f / 3.0f, // top-right
+        // right face
+         0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f, 2.0f / 4.0f, 2.0f / 3.0f, // top-left
+         0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f, 3.0f / 4.0f, 1.0f / 3.0f, // bottom-right
+         0.5f,  0.5f, -0.5f,  1.0f,  0.0f,  0.0f, 3.0f / 4.0f, 2.0f / 3.0f, // top-right
+         0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f, 3.0f / 4.0f, 1.0f / 3.0f, // bottom-right
+         0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f, 2.0f / 4.0f, 2.0f / 3.0f, // top-left
+         0.5f, -0.5f,  0.5f,  1.0f,  0.0f,  0.0f, 2.0f / 4.0f, 1.0f / 3.0f, // bottom-left
+        // bottom face
+        -0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f, 1.0f / 4.0f, 0.0f / 3.0f, // top-right
+         0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f, 2.0f / 4.0f, 0.0f / 3.0f, // top-left
+         0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f, 2.0f / 4.0f, 1.0f / 3.0f, // bottom-left
+         0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f, 2.0f / 4.0f, 1.0f / 3.0f, // bottom-left
+        -0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f, 1.0f / 4.0f, 1.0f / 3.0f, // bottom-right
+        -0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f, 1.0f / 4.0f, 0.0f / 3.0f, // top-right
+        // top face
+        -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f, 1.0f / 4.0f, 3.0f / 3.0f, // top-left
+         0.5f,  0.5f , 0.5f,  0.0f,  1.0f,  0.0f, 2.0f / 4.0f, 2.0f / 3.0f, // bottom-right
+         0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f, 2.0f / 4.0f, 3.0f / 3.0f, // top-right
+         0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f, 2.0f / 4.0f, 2.0f / 3.0f, // bottom-right
+        -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f, 1.0f / 4.0f, 3.0f / 3.0f, // top-left
+        -0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f, 1.0f / 4.0f, 2.0f / 3.0f  // bottom-left
+    };
+
+    glGenVertexArrays(1, &cubeVAO);
+    glGenBuffers(1, &cubeVBO);
+    // fill buffer
+    glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    // link vertex attributes
+    glBindVertexArray(cubeVAO);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+}
 
-    glm::mat4 lightView = glm::lookAt(shadowCameraPos,
-                                      shadowCameraView,
-                                      glm::vec3(0.0f, 1.0f, 0.0f));
+void renderCube()
+{
+    // initialize (if necessary)
+    if (cubeVAO == 0)
+    {
+        createBoxModel();
+    }
 
-    return lightProjection * lightView;
+    // render Cube
+    glBindVertexArray(cubeVAO);
+    glDrawArrays(GL_TRIANGLES, 0, 36);
+    glBindVertexArray(0);
 }
@@ -7,9 +7,14 @@
 #include <glm/fwd.hpp>
 #include <glm/vec3.hpp>
 
+#include "FuryRenderList.h"
+
 #include <QPair>
 #include <QMap>
 #include <QObject>
+#include <QElapsedTimer>
+
+#include <functional>
 
 
 class Shader;
@@ -18,15 +23,20 @@ class Particle;
 class ParticleSystem;
 
 class FuryMesh;
+class FuryMaterial;
 class FuryWorld;
+class FurySimulation;
+class FuryAsyncLearner;
+class FuryEpisodeRecord;
+class FurySimulationThread;
 class FuryObject;
 class FuryModelCache;
 class FuryModelManager;
 class FuryWorldManager;
 class FuryTextureCache;
 class FuryScriptManager;
+class FuryShadowCascades;
 class FuryShaderManager;
-class FuryEventListener;
 class FuryTextureManager;
 class FuryMaterialManager;
 class FuryBaseLocalKeyMapper;
@@ -47,6 +57,28 @@ class FuryRenderer : public QObject
     Q_OBJECT
 
 public:
+    //! Режим скорости симуляции тестового мира
+    enum SimulationMode
+    {
+        //! Секунда симуляции за секунду
+        SimulationRealTime = 0,
+        //! Ускоренно, с фиксированным множителем
+        SimulationFast,
+        //! Без ограничений: тики подряд, отрисовка только для предпросмотра
+        SimulationUncapped
+    };
+
+    //! Предустановка качества теней
+    enum ShadowQuality
+    {
+        //! Один каскад 1024
+        ShadowLow = 0,
+        //! Три каскада 2048, 1024, 1024
+        ShadowMedium,
+        //! Три каскада 4096, 2048, 1024
+        ShadowHigh
+    };
+
     /*!
      * \brief Конструктор
      * \param[in] _parent - Родительский объект
@@ -91,11 +123,17 @@ public:
                            GLuint *_irradianceMap, GLuint *_prefilterMap, GLuint *_brdfLUTTexture);
 
     /*!
-     * \brief Создание карты теней
-     * \param[out] _depthMapFBO - Выходной буфер глубины
-     * \param[out] _depthMap - Выходная текстура для буфера
+     * \brief Создание текстур окружения для PBR и установка их в мир
+     * \param[in] _world - Мир
+     * \param[in] _cubemapHdrPath - Путь к HDR текстуры
+     */
+    void createWorldPbrCubemap(FuryWorld* _world, const QString& _cubemapHdrPath);
+
+    /*!
+     * \brief Установка каскадных карт теней рендера в мир
+     * \param[in] _world - Мир
      */
-    void createDepthMap(GLuint* _depthMapFBO, GLuint* _depthMap);
+    void createWorldDepthMap(FuryWorld* _world);
 
 
     /*!
@@ -105,7 +143,6 @@ public:
     static FuryRenderer* instance();
 
     void initializeGL();
-    // void paintGL();
 
     inline FuryWorld* getTestWorld() const
     { return m_testWorld; }
@@ -129,11 +166,75 @@ public:
     inline void setShadowCamDistance(float _shadowCamDistance)
     { m_shadowCamDistance = _shadowCamDistance; }
 
-    inline void setLearnSpeed(int _value)
-    { m_learnSpeed = _value; }
+    /*!
+     * \brief Установка предустановки качества теней: количества каскадов и размеров карт
+     * \param[in] _quality - Качество
+     */
+    void setShadowQuality(ShadowQuality _quality);
+
+    /*!
+     * \brief Получение предустановки качества теней
+     * \return Возвращает качество
+     */
+    inline ShadowQuality shadowQuality() const
+    { return m_shadowQuality; }
+
+    /*!
+     * \brief Установка количества каскадов теней
+     * \param[in] _count - Количество каскадов
+     */
+    void setShadowCascadeCount(int _count);
+
+    /*!
+     * \brief Установка размера карты каскада теней
+     * \param[in] _cascade - Номер каскада
+     * \param[in] _resolution - Ширина и высота карты в текселях
+     */
+    void setShadowResolution(int _cascade, int _resolution);
+
+    /*!
+     * \brief Установка режима скорости симуляции
+     * \param[in] _mode - Режим
+     */
+    void setSimulationMode(SimulationMode _mode);
+
+    /*!
+     * \brief Получение режима скорости симуляции
+     * \return Возвращает режим
+     */
+    inline SimulationMode simulationMode() const
+    { return m_simulationMode; }
+
+    /*!
+     * \brief Получение статистики отсечения последнего кадра основной сцены
+     * \return Возвращает количество проверенных и видимых записей отрисовки
+     */
+    inline const FuryRenderList::CullingStats& cullingStats() const
+    { return m_cullingStats; }
+
+    /*!
+     * \brief Получение статистики отсечения последнего прохода теней
+     * \return Возвращает количество проверенных записей и записей в объёмах
+     * света, просуммированные по каскадам
+     */
+    inline const FuryRenderList::CullingStats& shadowCullingStats() const
+    { return m_shadowCullingStats; }
+
+    /*!
+     * \brief Выполнение действия над тестовым миром в потоке симуляции.
+     * Всё, что из интерфейса меняет объекты или физику, идёт через него
+     * \param[in] _command - Действие
+     */
+    void runInSimulation(const std::function<void()>& _command);
 
     void saveLearnModel();
 
+    /*!
+     * \brief Начало или завершение записи эпизода тестового мира.
+     * Завершённая запись сохраняется в records/<дата_время>.frec
+     */
+    void toggleEpisodeRecord();
+
     inline void setNeedDebugRender(bool _need)
     { m_needDebugRender = _need; }
 
@@ -142,6 +243,12 @@ public:
 
 signals:
     void setWindowTitleSignal(const QString& _title);
+
+    /*!
+     * \brief Сигнал сообщения для строки состояния главного окна
+     * \param[in] _message - Сообщение
+     */
+    void setStatusMessageSignal(const QString& _message);
     void setComputerLoadSignal(int _value);
 
 public:
@@ -167,6 +274,12 @@ private:
     void init();
     void InitGL();
 
+    /*!
+     * \brief Раз в секунду отправляет в заголовок частоту отрисовки
+     * и количество шагов симуляции в секунду
+     */
+    void updateSpeedReadout();
+
     /*!
      * \brief Отрисовка мира
      * \param[in] _world - Мир
@@ -176,10 +289,13 @@ private:
     void drawWorld(FuryWorld* _world, int _width, int _height);
 
     /*!
-     * \brief Отрисовка карты теней
+     * \brief Отрисовка каскадных карт теней. Статические меши берутся из
+     * кэшированного слоя каскада, поверх рисуются только подвижные меши в объёме света
      * \param[in] _world - Мир
+     * \param[in] _width - Ширина кадра камеры
+     * \param[in] _height - Высота кадра камеры
      */
-    void drawWorldDepthMap(FuryWorld* _world);
+    void drawWorldDepthMap(FuryWorld* _world, int _width, int _height);
 
     /*!
      * \brief Отрисовка выделенного объекта в редакторе
@@ -191,18 +307,34 @@ private:
                               const glm::mat4& _projection,
                               const glm::mat4& _view);
     /*!
-     * \brief Отрисовка компоненты
+     * \brief Отрисовка компоненты. Состояние кадра шейдера и материал
+     * устанавливаются, только если они отличаются от предыдущей компоненты
      * \param[in] _world - Мир
-     * \param[in] _component - Пара <Объект, Меш> для отрисовки
+     * \param[in] _entry - Запись списка отрисовки с материалом и шейдером
      * \param[in] _projection - Матрица проекции
      * \param[in] _view - Матрица вида
-     * \param[in] _lightSpaceMatrix - Матрица пространства теней
      */
     void drawComponent(FuryWorld* _world,
-                       const QPair<FuryObject*, FuryMesh*>& _component,
+                       const FuryRenderList::Entry& _entry,
                        const glm::mat4& _projection,
-                       const glm::mat4& _view,
-                       const glm::mat4& _lightSpaceMatrix);
+                       const glm::mat4& _view);
+
+    /*!
+     * \brief Активация шейдера и установка общих для кадра uniform-переменных
+     * и текстур: матриц камеры, света, окружения и каскадов теней
+     * \param[in] _world - Мир
+     * \param[in] _shader - Шейдер
+     * \param[in] _projection - Матрица проекции
+     * \param[in] _view - Матрица вида
+     */
+    void bindShaderFrameState(FuryWorld* _world,
+                              Shader* _shader,
+                              const glm::mat4& _projection,
+                              const glm::mat4& _view);
+
+    //! Сброс запомненного шейдера и материала. Вызывается после чужой отрисовки
+    inline void resetDrawState()
+    { m_boundShader = nullptr; m_boundMaterial = nullptr; }
 
     void do_movement();
 
@@ -217,15 +349,20 @@ private:
     static FuryRenderer* s_instance;
 
 private:
-    FuryEventListener* m_eventListener;
+    //! Симуляция тестового мира
+    FurySimulation* m_simulation;
+    //! Асинхронное обучение. nullptr, если обучение синхронное или выключено
+    FuryAsyncLearner* m_learner;
+    //! Поток симуляции тестового мира
+    FurySimulationThread* m_simulationThread;
+    //! Текущая запись эпизода. nullptr, если запись не идёт. Меняется в потоке симуляции
+    FuryEpisodeRecord* m_episodeRecord;
 
 
     void loadRaceMapFromJson();
 
     void renderLoading();
 
-    void updatePhysics();
-
     void displayBuffer(GLuint _bufferId);
     void displayLogo(int _width, int _height);
 
@@ -277,11 +414,23 @@ private:
 
     CarObject* m_carObject = nullptr;
     FuryModelCache* m_cubeModelCache;
+    //! Каскадные карты теней тестового мира
+    FuryShadowCascades* m_shadowCascades;
 
+    //! Начало теней от камеры
     float m_shadowNear = 0.1f;
+    //! Конец теней от камеры
     float m_shadowPlane = 70.f;
+    //! Дальняя граница первого каскада
     float m_shadowViewSize = 25.f;
+    //! Запас глубины каскадов в сторону света
     float m_shadowCamDistance = 37;
+    //! Предустановка качества теней
+    ShadowQuality m_shadowQuality = ShadowHigh;
+    //! Статистика отсечения последнего прохода теней
+    FuryRenderList::CullingStats m_shadowCullingStats;
+    //! Мешей нарисовано в карту теней за последний кадр
+    int m_shadowDrawnEntries = 0;
 
     bool m_needDebugRender;
 
@@ -292,11 +441,44 @@ private:
 private:
     //! Камеры
     QVector<Camera*> m_cameras;
-    //! Аккумулятор для обновления физики
-    double m_updateAccumulator;
 
     FuryLearningScript* m_learnScript;
-    int m_learnSpeed;
+    //! Режим скорости симуляции
+    SimulationMode m_simulationMode;
+    //! Время с последнего кадра предпросмотра в режиме без ограничений
+    QElapsedTimer m_previewTimer;
+    //! Время с последнего вывода скорости
+    QElapsedTimer m_speedTimer;
+    //! Кадров отрисовано с последнего вывода скорости
+    int m_renderedFrames;
+    //! Тиков симуляции на момент последнего вывода скорости
+    quint64 m_speedTicks;
+    //! Признаки видимости записей списка отрисовки в текущем проходе
+    QVector<quint8> m_visibleEntries;
+    //! Статистика отсечения последнего прохода drawWorld
+    FuryRenderList::CullingStats m_lastCulling;
+    //! Статистика отсечения последнего кадра основной сцены
+    FuryRenderList::CullingStats m_cullingStats;
+    //! Непрозрачные записи текущего прохода с ключами сортировки
+    QVector<QPair<quint64, const FuryRenderList::Entry*>> m_opaqueQueue;
+    //! Шейдер, чьё состояние кадра установлено последним
+    Shader* m_boundShader = nullptr;
+    //! Материал, установленный в m_boundShader последним
+    FuryMaterial* m_boundMaterial = nullptr;
+
+    //! Смены состояния за проход
+    struct DrawStats
+    {
+        //! Установок шейдера с состоянием кадра
+        int shaderBinds = 0;
+        //! Установок материала
+        int materialBinds = 0;
+    };
+
+    //! Смены состояния последнего прохода drawWorld
+    DrawStats m_lastDrawStats;
+    //! Смены состояния последнего кадра основной сцены
+    DrawStats m_drawStats;
     QList<float> m_scoreList;
 
     //! Отображатель кодов русских клавиш на латинские
@@ -0,0 +1,400 @@
+#include "Managers/FuryScriptManager.h"
+
+#include "CarObject.h"
+#include "FuryWorld.h"
+#include "Logger/FuryLogger.h"
+#include "Learning/FuryAsyncLearner.h"
+#include "Learning/FuryPolicyNetwork.h"
+#include "Simulation/FurySimulation.h"
+#include "Simulation/FuryEpisodeRecord.h"
+#include "Simulation/FuryVectorEnvironment.h"
+#include "Managers/FuryModelManager.h"
+#include "Managers/FuryWorldManager.h"
+#include "Managers/FuryTextureManager.h"
+#include "Managers/FuryMaterialManager.h"
+
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QCoreApplication>
+#include <QCommandLineParser>
+
+#include <locale.h>
+
+/*!
+ * \brief Вывод скорости симуляции
+ * \param[in] _ticks - Количество тиков за период
+ * \param[in] _envCount - Количество миров
+ * \param[in] _elapsed - Длительность периода в миллисекундах
+ * \param[in] _totalTicks - Всего тиков
+ */
+static void reportSpeed(quint64 _ticks, int _envCount, qint64 _elapsed, quint64 _totalTicks)
+{
+    double seconds = qMax(1LL, _elapsed) / 1000.0;
+    Debug(ru("Тиков: %1; Тиков в секунду: %2; Шагов сред в секунду: %3")
+          .arg(_totalTicks)
+          .arg(_ticks / seconds, 0, 'f', 1)
+          .arg(_ticks * _envCount / seconds, 0, 'f', 1));
+}
+
+/*!
+ * \brief Векторная среда. Со скриптом цикл шагов ведёт функция run(env) скрипта,
+ * с политикой - действия выбирает нейросеть без Python,
+ * без того и другого - случайные действия для замера пропускной способности.
+ * \param[in] _envCount - Количество миров
+ * \param[in] _threadCount - Количество потоков
+ * \param[in] _ticks - Количество тиков (0 - бесконечно)
+ * \param[in] _reportPeriod - Период вывода скорости в тиках
+ * \param[in] _scriptName - Модуль скрипта с функцией run(env). Пустой - без скрипта
+ * \param[in] _policyPath - Файл весов нейросети политики. Пустой - без политики
+ * \param[in] _actionRepeat - Количество тиков физики на одно действие
+ */
+static void runVectorEnvironment(int _envCount, int _threadCount,
+                                 quint64 _ticks, quint64 _reportPeriod,
+                                 const QString& _scriptName, const QString& _policyPath,
+                                 int _actionRepeat)
+{
+    FuryVectorEnvironment environment(_envCount, _threadCount);
+    environment.setTicksPerStep(_actionRepeat);
+    environment.load();
+
+    if (!_scriptName.isEmpty())
+    {
+        Debug(ru("Старт скрипта (%1) на векторной среде из %2 миров").arg(_scriptName).arg(_envCount));
+        FuryScriptManager::instance()->runEnvironment(_scriptName, &environment);
+        return;
+    }
+
+    FuryPolicyNetwork policy;
+
+    if (!_policyPath.isEmpty())
+    {
+        if (!policy.load(_policyPath) || policy.inputSize() != CarObject::observationSize)
+        {
+            Debug(ru("Не удалось подключить политику (%1)").arg(_policyPath));
+            return;
+        }
+
+        environment.setPolicy(&policy);
+    }
+
+    Debug(ru("Старт векторной среды на %1 миров").arg(_envCount));
+
+    int* actions = environment.actionBuffer();
+    QRandomGenerator* random = QRandomGenerator::global();
+
+    QElapsedTimer timer;
+    timer.start();
+    qint64 lastReportTime = 0;
+    quint64 lastReportTick = 0;
+
+    for (quint64 tick = 1; _ticks == 0 || tick <= _ticks; ++tick)
+    {
+        if (!policy.isLoaded())
+        {
+            for (int i = 0; i < _envCount; ++i)
+            {
+                actions[i] = random->bounded(9);
+            }
+        }
+
+        environment.step();
+
+        if (tick % _reportPeriod == 0)
+        {
+            qint64 elapsed = timer.elapsed();
+            reportSpeed(tick - lastReportTick, _envCount, elapsed - lastReportTime, tick);
+
+            lastReportTime = elapsed;
+            lastReportTick = tick;
+        }
+    }
+
+    Debug(ru("Векторная среда завершена. Средняя скорость:"));
+    reportSpeed(_ticks, _envCount, timer.elapsed(), _ticks);
+}
+
+/*!
+ * \brief Воспроизведение записи эпизода со сверкой трансформаций бит в бит.
+ * Заодно замер скорости симуляции на одинаковой от запуска к запуску нагрузке
+ * \param[in] _simulation - Загруженная симуляция без скриптов
+ * \param[in] _path - Файл записи эпизода
+ * \return Возвращает признак совпадения с записью
+ */
+static bool replayEpisode(FurySimulation* _simulation, const QString& _path)
+{
+    FuryEpisodeRecord record;
+
+    if (!record.load(_path))
+    {
+        return false;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    quint64 failedTick = 0;
+    bool isMatched = record.replay(_simulation, &failedTick);
+    double seconds = qMax(1LL, timer.elapsed()) / 1000.0;
+
+    if (!isMatched)
+    {
+        Debug(ru("Воспроизведение НЕ совпало с записью (%1), тик %2").arg(_path).arg(failedTick));
+        return false;
+    }
+
+    Debug(ru("Воспроизведение совпало с записью (%1). Тиков: %2; Скорость: %3 тиков/с")
+          .arg(_path)
+          .arg(record.tickCount())
+          .arg(record.tickCount() / seconds, 0, 'f', 1));
+    return true;
+}
+
+/*!
+ * \brief Удаление менеджеров перед выходом
+ * \param[in] _withScript - Был ли создан менеджер скриптов
+ */
+static void shutdownManagers(bool _withScript)
+{
+    if (_withScript)
+    {
+        FuryScriptManager::deleteInstance();
+    }
+
+    FuryWorldManager::deleteInstance();
+    FuryMaterialManager::deleteInstance();
+
+    FuryTextureManager::instance()->stopLoopAndWait();
+    FuryTextureManager::deleteInstance();
+
+    FuryModelManager::instance()->stopLoopAndWait();
+    FuryModelManager::deleteInstance();
+
+    FuryLogger::deleteInstance();
+}
+
+/*!
+ * \brief Безголовый запуск симуляции гоночного мира.
+ *
+ * Загружает scene/testWorld_AE.json и крутит FuryWorld::tick в цикле без
+ * виджетов и контекста OpenGL. Для серверов обучения без видеокарты.
+ */
+int main(int argc, char *argv[])
+{
+    setlocale(LC_ALL, "rus");
+
+    QCoreApplication a(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(ru("Симуляция мира FuryEngine без отрисовки"));
+    parser.addHelpOption();
+
+    QCommandLineOption ticksOption("ticks",
+                                   ru("Количество тиков симуляции (0 - бесконечно)"),
+                                   "count", "0");
+    QCommandLineOption scriptOption("script",
+                                    ru("Модуль скрипта управления машиной"),
+                                    "module", "scripts.test");
+    QCommandLineOption noScriptOption("no-script",
+                                      ru("Запуск без скрипта управления"));
+    QCommandLineOption reportOption("report",
+                                    ru("Период вывода скорости симуляции в тиках"),
+                                    "count", "10000");
+    QCommandLineOption envsOption("envs",
+                                  ru("Количество миров векторной среды со случайными действиями (0 - одиночная симуляция)"),
+                                  "count", "0");
+    QCommandLineOption threadsOption("threads",
+                                     ru("Количество потоков векторной среды (0 - по числу ядер)"),
+                                     "count", "0");
+    QCommandLineOption envScriptOption("env-script",
+                                       ru("Модуль скрипта с функцией run(env) для векторной среды"),
+                                       "module");
+    QCommandLineOption policyOption("policy",
+                                    ru("Файл весов нейросети политики. Машины едут без Python"),
+                                    "file");
+    QCommandLineOption learnerOption("learner",
+                                     ru("Модуль скрипта с функцией run(learner) для обучения в отдельном потоке"),
+                                     "module");
+    QCommandLineOption publishPeriodOption("publish-period",
+                                           ru("Период публикации весов обучением в шагах обучения"),
+                                           "count", "100");
+    QCommandLineOption actionRepeatOption("action-repeat",
+                                          ru("Количество тиков физики на одно действие машины"),
+                                          "count", "1");
+    QCommandLineOption seedOption("seed",
+                                  ru("Зерно генератора случайных чисел симуляции"),
+                                  "value", "1");
+    QCommandLineOption randomActionsOption("random-actions",
+                                           ru("Случайные действия машины по зерну симуляции, без скрипта"));
+    QCommandLineOption recordOption("record",
+                                    ru("Запись эпизода одиночной симуляции в файл по окончании --ticks тиков (только с --ticks больше 0)"),
+                                    "file");
+    QCommandLineOption replayOption("replay",
+                                    ru("Воспроизведение записи эпизода со сверкой трансформаций"),
+                                    "file");
+    QCommandLineOption agentsOption("agents",
+                                    ru("Количество машин одиночной симуляции на общей трассе, в режиме призраков"),
+                                    "count", "1");
+
+    parser.addOption(ticksOption);
+    parser.addOption(scriptOption);
+    parser.addOption(noScriptOption);
+    parser.addOption(reportOption);
+    parser.addOption(envsOption);
+    parser.addOption(threadsOption);
+    parser.addOption(envScriptOption);
+    parser.addOption(policyOption);
+    parser.addOption(learnerOption);
+    parser.addOption(publishPeriodOption);
+    parser.addOption(actionRepeatOption);
+    parser.addOption(seedOption);
+    parser.addOption(randomActionsOption);
+    parser.addOption(recordOption);
+    parser.addOption(replayOption);
+    parser.addOption(agentsOption);
+    parser.process(a);
+
+    quint64 ticks = parser.value(ticksOption).toULongLong();
+    quint64 reportPeriod = qMax(1ULL, parser.value(reportOption).toULongLong());
+    int envCount = parser.value(envsOption).toInt();
+    int actionRepeat = qMax(1, parser.value(actionRepeatOption).toInt());
+    QString policyPath = parser.value(policyOption);
+    QString learnerModule = parser.value(learnerOption);
+    QString recordPath = parser.value(recordOption);
+    QString replayPath = parser.value(replayOption);
+    bool randomActions = parser.isSet(randomActionsOption);
+    bool withScript = (envCount <= 0) ? (!parser.isSet(noScriptOption) && policyPath.isEmpty()
+                                         && !randomActions && replayPath.isEmpty())
+                                        || !learnerModule.isEmpty()
+                                      : parser.isSet(envScriptOption);
+
+    // Запись сохраняется по окончании тиков, бесконечная симуляция её не сохранит
+    if (!recordPath.isEmpty() && ticks == 0)
+    {
+        Debug(ru("Для --record нужно задать --ticks больше 0"));
+        FuryLogger::deleteInstance();
+        return 1;
+    }
+
+    FuryWorldManager* worldManager = FuryWorldManager::createInstance();
+
+    if (envCount > 0)
+    {
+        runVectorEnvironment(envCount, parser.value(threadsOption).toInt(), ticks, reportPeriod,
+                             parser.value(envScriptOption), policyPath, actionRepeat);
+        shutdownManagers(withScript);
+        return 0;
+    }
+
+    FuryWorld& world = worldManager->createWorld("testWorld");
+
+    FurySimulation* simulation = new FurySimulation(&world);
+    simulation->setSeed(parser.value(seedOption).toUInt());
+    simulation->setAgentCount(parser.value(agentsOption).toInt());
+    simulation->load();
+
+    if (!replayPath.isEmpty())
+    {
+        bool isMatched = replayEpisode(simulation, replayPath);
+
+        delete simulation;
+        shutdownManagers(withScript);
+        return isMatched ? 0 : 1;
+    }
+
+    for (CarObject* agent : simulation->carObjects())
+    {
+        agent->setActionRepeat(actionRepeat);
+    }
+
+    FuryAsyncLearner* learner = nullptr;
+
+    if (!learnerModule.isEmpty())
+    {
+        learner = new FuryAsyncLearner(CarObject::observationSize, 9);
+        learner->setPublishPeriod(parser.value(publishPeriodOption).toInt());
+        simulation->attachLearner(learner);
+        learner->start(learnerModule);
+    }
+    else if (!policyPath.isEmpty())
+    {
+        if (!simulation->attachPolicy(policyPath))
+        {
+            delete simulation;
+            shutdownManagers(withScript);
+            return 1;
+        }
+    }
+    else if (withScript)
+    {
+        simulation->attachScript(parser.value(scriptOption));
+    }
+
+    CarObject* car = simulation->carObject();
+    FuryEpisodeRecord record;
+
+    if (!recordPath.isEmpty() && car != nullptr)
+    {
+        record.begin(simulation);
+        simulation->attachRecord(&record);
+    }
+
+    Debug(ru("Старт безголовой симуляции"));
+
+    QElapsedTimer timer;
+    timer.start();
+    qint64 lastReportTime = 0;
+    quint64 lastReportTick = 0;
+
+    while (ticks == 0 || simulation->tickCount() < ticks)
+    {
+        if (randomActions)
+        {
+            for (CarObject* agent : simulation->carObjects())
+            {
+                if (agent->isDecisionRequired())
+                {
+                    agent->setBotAction(simulation->random().bounded(9));
+                }
+            }
+        }
+
+        simulation->step();
+
+        if (simulation->tickCount() % reportPeriod == 0)
+        {
+            qint64 elapsed = timer.elapsed();
+            double seconds = qMax(1LL, elapsed - lastReportTime) / 1000.0;
+            double ticksPerSecond = (simulation->tickCount() - lastReportTick) / seconds;
+
+            Debug(ru("Тиков: %1; Тиков в секунду: %2")
+                  .arg(simulation->tickCount())
+                  .arg(ticksPerSecond, 0, 'f', 1));
+
+            lastReportTime = elapsed;
+            lastReportTick = simulation->tickCount();
+        }
+    }
+
+    double totalSeconds = qMax(1LL, timer.elapsed()) / 1000.0;
+    Debug(ru("Симуляция завершена. Тиков: %1; Средняя скорость: %2 тиков/с")
+          .arg(simulation->tickCount())
+          .arg(simulation->tickCount() / totalSeconds, 0, 'f', 1));
+
+    if (!recordPath.isEmpty() && car != nullptr)
+    {
+        simulation->attachRecord(nullptr);
+        record.finish(simulation);
+        record.save(recordPath);
+    }
+
+    if (learner != nullptr)
+    {
+        learner->stop();
+    }
+
+    delete simulation;
+    delete learner;
+
+    shutdownManagers(withScript);
+    return 0;
+}